@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Bump-pointer allocator for IR nodes, with free lists for recycling.
+//
+// Memory is carved out of slabs in allocation order, so nodes created one
+// after another sit next to each other. Slabs start small and double up to
+// MAX_SLAB_SIZE; a request larger than that gets a slab of its own. Memory
+// is never returned piecemeal: recycle() threads a block onto a free list
+// for its size, and the next allocation of that size takes it back. The
+// slabs are released together when the arena is destroyed.
+class Arena {
+public:
+    static constexpr size_t ALIGN = alignof(std::max_align_t);
+    static constexpr size_t FIRST_SLAB_SIZE = size_t(4) << 10;
+    static constexpr size_t MAX_SLAB_SIZE = size_t(1) << 20;
+    // Larger blocks are not recycled.
+    static constexpr size_t MAX_RECYCLED_SIZE = 512;
+
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() {
+        for (void* slab : slabs) {
+            ::operator delete(slab);
+        }
+    }
+
+    // `size` bytes aligned to ALIGN.
+    void* allocate(size_t size) {
+        size = roundUp(size);
+        if (size <= MAX_RECYCLED_SIZE) {
+            FreeBlock*& head = freeLists[size / ALIGN];
+            if (head) {
+                FreeBlock* block = head;
+                head = block->next;
+                return block;
+            }
+        }
+        if (size > static_cast<size_t>(end - cur)) {
+            size_t slabSize = std::min(MAX_SLAB_SIZE, FIRST_SLAB_SIZE << std::min<size_t>(slabs.size(), 8));
+            if (size > slabSize) {
+                slabs.push_back(::operator new(size)); // oversized: a slab of its own
+                return slabs.back();
+            }
+            slabs.push_back(::operator new(slabSize));
+            cur = static_cast<char*>(slabs.back());
+            end = cur + slabSize;
+        }
+        void* p = cur;
+        cur += size;
+        return p;
+    }
+
+    // Hands back `p`, from allocate(size), for a later allocate() of the
+    // same size.
+    void recycle(void* p, size_t size) {
+        size = roundUp(size);
+        if (size <= MAX_RECYCLED_SIZE) {
+            FreeBlock*& head = freeLists[size / ALIGN];
+            head = new (p) FreeBlock{head};
+        }
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(alignof(T) <= ALIGN, "over-aligned type");
+        void* p = allocate(sizeof(T));
+        try {
+            return new (p) T(std::forward<Args>(args)...);
+        } catch (...) {
+            recycle(p, sizeof(T));
+            throw;
+        }
+    }
+
+    // Destroys a node from create<T>(). Its dynamic type may be a subclass
+    // of T only if that is the same size.
+    template <typename T>
+    void destroy(T* node) {
+        node->~T();
+        recycle(node, sizeof(T));
+    }
+
+    size_t getNumSlabs() const { return slabs.size(); }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    char* cur = nullptr;
+    char* end = nullptr;
+    std::vector<void*> slabs;
+    FreeBlock* freeLists[MAX_RECYCLED_SIZE / ALIGN + 1] = {};
+
+    static size_t roundUp(size_t size) { return (std::max<size_t>(size, 1) + ALIGN - 1) & ~(ALIGN - 1); }
+};
@@ -0,0 +1,728 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "BitstreamWriter.h"
+#include "FunctionSnapshot.h"
+#include "IR.h"
+#include "IRPrinter.h"
+#include "OutputStream.h"
+
+// Writes a Module as LLVM bitcode (.bc): what `llvm-as` would make of the
+// .ll IRPrinter writes, with the same names, without linking LLVM. The
+// format is that of LLVM 14 (typed pointers), as LLVM's own BitcodeWriter
+// lays it out:
+//   IDENTIFICATION  producer and epoch
+//   MODULE          version 2: global names live in the string table
+//     BLOCKINFO       abbreviations for constants, instructions and names
+//     TYPE            every type used, parts before the types built on them
+//     records         one per global, then one per function
+//     CONSTANTS       the global initializers
+//     FUNCTION...     one block per function body, in the same order
+//   STRTAB          the names of globals and functions, back to back
+// Values are numbered as LLVM's ValueEnumerator does: globals, functions,
+// module constants, then per function its constants and its non-void
+// instructions. Instruction operands are relative (the number of the
+// instruction minus that of the operand), so they stay small and mostly
+// fit one 6-bit VBR chunk.
+class BitcodeWriter {
+public:
+    static void write(const Module& module, OutputStream& os) {
+        BitcodeWriter writer(module);
+        writer.writeFile();
+        const std::string& bits = writer.stream.buffer();
+        os.write(bits.data(), bits.size());
+    }
+
+private:
+    // Block IDs and record codes, as LLVM's LLVMBitCodes.h numbers them.
+    enum BlockId : unsigned {
+        MODULE_BLOCK_ID = 8,
+        CONSTANTS_BLOCK_ID = 11,
+        FUNCTION_BLOCK_ID = 12,
+        IDENTIFICATION_BLOCK_ID = 13,
+        VALUE_SYMTAB_BLOCK_ID = 14,
+        TYPE_BLOCK_ID_NEW = 17,
+        STRTAB_BLOCK_ID = 23,
+    };
+    enum : unsigned { IDENTIFICATION_CODE_STRING = 1, IDENTIFICATION_CODE_EPOCH = 2 };
+    enum : unsigned {
+        MODULE_CODE_VERSION = 1,
+        MODULE_CODE_GLOBALVAR = 7,
+        MODULE_CODE_FUNCTION = 8,
+        MODULE_CODE_SOURCE_FILENAME = 16,
+    };
+    enum : unsigned {
+        TYPE_CODE_NUMENTRY = 1,
+        TYPE_CODE_VOID = 2,
+        TYPE_CODE_INTEGER = 7,
+        TYPE_CODE_POINTER = 8,
+        TYPE_CODE_ARRAY = 11,
+        TYPE_CODE_FUNCTION = 21,
+    };
+    enum : unsigned {
+        CST_CODE_SETTYPE = 1,
+        CST_CODE_NULL = 2,
+        CST_CODE_UNDEF = 3,
+        CST_CODE_INTEGER = 4,
+        CST_CODE_AGGREGATE = 7,
+        CST_CODE_DATA = 22,
+    };
+    enum : unsigned {
+        FUNC_CODE_DECLAREBLOCKS = 1,
+        FUNC_CODE_INST_BINOP = 2,
+        FUNC_CODE_INST_CAST = 3,
+        FUNC_CODE_INST_RET = 10,
+        FUNC_CODE_INST_ALLOCA = 19,
+        FUNC_CODE_INST_LOAD = 20,
+        FUNC_CODE_INST_CMP2 = 28,
+        FUNC_CODE_INST_GEP = 43,
+        FUNC_CODE_INST_STORE = 44,
+    };
+    enum : unsigned { VST_CODE_ENTRY = 1, VST_CODE_BBENTRY = 2 };
+    enum : unsigned { STRTAB_BLOB = 1 };
+
+    static constexpr unsigned BITCODE_EPOCH = 0;
+    static constexpr unsigned ALIGN_4 = 3;      // alignments are stored as log2 + 1
+    static constexpr unsigned CAST_ZEXT = 1;
+    static constexpr uint64_t EXPLICIT_TYPE = 1u << 6; // alloca: the first field is the allocated type
+
+    // A constant as it is written: the CONSTANTS records it becomes.
+    struct Constant {
+        enum Kind { Null, Undef, Integer, Data, Aggregate };
+        const Type* type;
+        Kind kind;
+        int64_t value = 0;                // Integer
+        std::vector<uint64_t> elements{}; // Data: the elements; Aggregate: their value IDs
+    };
+
+    const Module& module;
+    BitstreamWriter stream;
+    std::string strtab;
+
+    std::vector<const Type*> types;
+    PointerIndexMap typeIds;
+    unsigned typeBits = 1; // width of a type ID in abbreviated records
+
+    uint32_t numModuleValues = 0;
+    std::vector<Constant> moduleConstants;
+    std::map<std::pair<const Type*, std::vector<int32_t>>, uint32_t> initializerIds;
+    std::vector<uint32_t> initializerOf; // per global, its initializer's value ID
+
+    // The function being written.
+    std::vector<Constant> constants;
+    PointerIndexMap constantIndex; // Value* -> index into `constants`
+    std::vector<uint32_t> constantIds; // index into `constants` -> value ID
+    std::vector<uint64_t> fields;      // the record being built
+    uint32_t numBlocks = 0;
+
+    // Abbreviation IDs.
+    unsigned vstEntry8Abbrev = 0, vstEntry7Abbrev = 0, vstEntry6Abbrev = 0, vstBlockEntry6Abbrev = 0;
+    unsigned settypeAbbrev = 0, integerAbbrev = 0, nullAbbrev = 0;
+    unsigned loadAbbrev = 0, binopAbbrev = 0, castAbbrev = 0, retVoidAbbrev = 0, retValAbbrev = 0, gepAbbrev = 0;
+
+    explicit BitcodeWriter(const Module& module) : module(module) {}
+
+    void writeFile() {
+        stream.emit('B', 8);
+        stream.emit('C', 8);
+        stream.emit(0x0, 4);
+        stream.emit(0xC, 4);
+        stream.emit(0xE, 4);
+        stream.emit(0xD, 4);
+        writeIdentification();
+
+        enumerateModule();
+        stream.enterBlock(MODULE_BLOCK_ID, 3);
+        stream.emitRecord(MODULE_CODE_VERSION, {2});
+        writeBlockInfo();
+        writeTypeTable();
+        writeModuleInfo();
+        writeConstants(moduleConstants);
+        for (const Function& func : module.funcList) {
+            if (!func.blockList.empty()) {
+                writeFunction(func);
+            }
+        }
+        stream.exitBlock();
+
+        stream.enterBlock(STRTAB_BLOCK_ID, 3);
+        unsigned blobAbbrev = stream.defineAbbrev({AbbrevOp::literal(STRTAB_BLOB), AbbrevOp::blob()});
+        stream.emitRecordWithBlob(STRTAB_BLOB, strtab, blobAbbrev);
+        stream.exitBlock();
+    }
+
+    void writeIdentification() {
+        stream.enterBlock(IDENTIFICATION_BLOCK_ID, 5);
+        unsigned stringAbbrev = stream.defineAbbrev(
+            {AbbrevOp::literal(IDENTIFICATION_CODE_STRING), AbbrevOp::array(), AbbrevOp::char6()});
+        std::string_view producer = "SysY";
+        stream.emitRecord(IDENTIFICATION_CODE_STRING, producer.data(), producer.size(), stringAbbrev);
+        unsigned epochAbbrev = stream.defineAbbrev({AbbrevOp::literal(IDENTIFICATION_CODE_EPOCH), AbbrevOp::vbr(6)});
+        stream.emitRecord(IDENTIFICATION_CODE_EPOCH, {BITCODE_EPOCH}, epochAbbrev);
+        stream.exitBlock();
+    }
+
+    // --- Numbering ---
+
+    // Types, and the value IDs of globals, functions and initializers.
+    void enumerateModule() {
+        uint32_t id = 0;
+        for (const auto& global : module.globalList) {
+            addType(global->type);
+            global->number = id++;
+        }
+        for (const Function& func : module.funcList) {
+            addType(func.type);
+            func.number = id++;
+            for (const BasicBlock& block : func.blockList) {
+                for (const Instruction& inst : block.instList) {
+                    addType(inst.type);
+                    for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                        addType(inst.getOperand(i)->type);
+                    }
+                    if (inst.opcode == Instruction::Alloca) {
+                        addPrimitiveType(Type::getInt32Ty()); // the implicit array size
+                    }
+                }
+            }
+        }
+        numModuleValues = id;
+        for (const auto& global : module.globalList) {
+            initializerOf.push_back(addInitializer(*global, global->getValueType(), 0));
+        }
+        while (uint64_t(1) << typeBits <= types.size()) {
+            ++typeBits;
+        }
+    }
+
+    // Parts first, as the reader only resolves types already defined.
+    void addType(const Type* type) {
+        if (typeIds.find(type) != PointerIndexMap::NONE) {
+            return;
+        }
+        switch (type->id) {
+        case Type::ArrayTyID:
+            addType(static_cast<const ArrayType*>(type)->elementType);
+            break;
+        case Type::PointerTyID:
+            addType(static_cast<const PointerType*>(type)->pointeeType);
+            break;
+        case Type::FunctionTyID: {
+            auto* function = static_cast<const FunctionType*>(type);
+            addType(function->returnType);
+            for (const Type* param : function->paramTypes) {
+                addType(param);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        typeIds.insert(type, static_cast<uint32_t>(types.size()));
+        types.push_back(type);
+    }
+
+    // A type without parts. Kept apart from addType so that inlining it for
+    // a known primitive does not apply the derived-type casts to it.
+    void addPrimitiveType(const Type* type) {
+        if (typeIds.insert(type, static_cast<uint32_t>(types.size())).second) {
+            types.push_back(type);
+        }
+    }
+
+    uint32_t typeId(const Type* type) const { return typeIds.find(type); }
+
+    // The constant for the part of `global`'s initializer that has `type`
+    // and starts at element `offset`, as IRPrinter::printInitializer spells
+    // it: all zeros is zeroinitializer, an array of i32 is a data array,
+    // and equal parts are one constant. Returns its value ID.
+    uint32_t addInitializer(const GlobalVariable& global, const Type* type, size_t offset) {
+        size_t count = 1;
+        for (const Type* t = type; t->id == Type::ArrayTyID; t = static_cast<const ArrayType*>(t)->elementType) {
+            count *= static_cast<const ArrayType*>(t)->numElements;
+        }
+        auto first = global.initializer.begin() + static_cast<std::ptrdiff_t>(offset);
+        std::vector<int32_t> key(first, first + static_cast<std::ptrdiff_t>(count));
+        auto found = initializerIds.find({type, key});
+        if (found != initializerIds.end()) {
+            return found->second;
+        }
+        Constant constant{type, Constant::Null};
+        if (type->id != Type::ArrayTyID) {
+            constant.kind = Constant::Integer;
+            constant.value = key[0];
+        } else if (std::any_of(key.begin(), key.end(), [](int32_t v) { return v != 0; })) {
+            auto* array = static_cast<const ArrayType*>(type);
+            if (array->elementType->id != Type::ArrayTyID) {
+                constant.kind = Constant::Data;
+                for (int32_t v : key) {
+                    constant.elements.push_back(static_cast<uint32_t>(v));
+                }
+            } else {
+                constant.kind = Constant::Aggregate;
+                size_t stride = count / array->numElements;
+                for (uint64_t i = 0; i < array->numElements; ++i) {
+                    constant.elements.push_back(addInitializer(global, array->elementType, offset + i * stride));
+                }
+            }
+        }
+        uint32_t id = numModuleValues + static_cast<uint32_t>(moduleConstants.size());
+        moduleConstants.push_back(std::move(constant));
+        initializerIds.emplace(std::make_pair(type, std::move(key)), id);
+        return id;
+    }
+
+    // Numbers the constants `func` uses after the module's values, grouped
+    // by type, and its non-void instructions after them; blocks get their
+    // index, and numBlocks is set. Returns the ID of the first instruction.
+    uint32_t enumerateFunction(const Function& func) {
+        constants.clear();
+        constantIndex = PointerIndexMap();
+        for (const BasicBlock& block : func.blockList) {
+            for (const Instruction& inst : block.instList) {
+                if (inst.opcode == Instruction::Alloca) {
+                    addConstant(&ALLOCA_SIZE, Type::getInt32Ty(), Constant::Integer, 1);
+                }
+                for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                    Value* operand = inst.getOperand(i);
+                    if (ConstantInt* constant = operand->asConstantInt()) {
+                        addConstant(keyOf(constant), constant->type, Constant::Integer, constant->value);
+                    } else if (operand->asUndefValue()) {
+                        addConstant(operand, operand->type, Constant::Undef, 0);
+                    }
+                }
+            }
+        }
+        std::vector<uint32_t> order(constants.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return typeId(constants[a].type) < typeId(constants[b].type); });
+        constantIds.assign(constants.size(), 0);
+        std::vector<Constant> sorted;
+        sorted.reserve(constants.size());
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            constantIds[order[i]] = numModuleValues + static_cast<uint32_t>(moduleConstants.size()) + i;
+            sorted.push_back(std::move(constants[order[i]]));
+        }
+        constants.swap(sorted);
+
+        uint32_t firstInst = numModuleValues + static_cast<uint32_t>(moduleConstants.size() + constants.size());
+        uint32_t id = firstInst;
+        uint32_t blockIndex = 0;
+        for (const BasicBlock& block : func.blockList) {
+            block.number = blockIndex++;
+            for (const Instruction& inst : block.instList) {
+                if (inst.type->id != Type::VoidTyID) {
+                    inst.number = id++;
+                }
+                // The reader moves on to the next block after a terminator,
+                // so what follows one is a block of its own, unnamed: what
+                // llvm-as makes of the same .ll.
+                if (inst.opcode == Instruction::Ret && &inst != &block.instList.back()) {
+                    ++blockIndex;
+                }
+            }
+        }
+        numBlocks = blockIndex;
+        return firstInst;
+    }
+
+    // An alloca's implicit size is the constant i32 1, which is the same
+    // constant as an i32 1 operand.
+    static inline const char ALLOCA_SIZE = 0;
+    static const void* keyOf(const ConstantInt* constant) {
+        if (constant->type == Type::getInt32Ty() && constant->value == 1) {
+            return &ALLOCA_SIZE;
+        }
+        return constant;
+    }
+
+    void addConstant(const void* key, const Type* type, Constant::Kind kind, int64_t value) {
+        if (constantIndex.insert(key, static_cast<uint32_t>(constants.size())).second) {
+            constants.push_back({type, kind, value});
+        }
+    }
+
+    uint32_t valueId(const Value* value) const {
+        auto* v = const_cast<Value*>(value); // the asX() casts are not const
+        if (v->asInstruction()) {
+            return v->number;
+        }
+        if (ConstantInt* constant = v->asConstantInt()) {
+            return constantIds[constantIndex.find(keyOf(constant))];
+        }
+        if (v->asUndefValue()) {
+            return constantIds[constantIndex.find(v)];
+        }
+        return v->number; // a global or a function
+    }
+
+    // --- Module ---
+
+    void writeBlockInfo() {
+        stream.enterBlockInfoBlock();
+        // Names: any 8-bit string (the code is a field, so this one serves
+        // blocks too), 7-bit strings, and strings of [a-zA-Z0-9._].
+        vstEntry8Abbrev = stream.defineBlockInfoAbbrev(
+            VALUE_SYMTAB_BLOCK_ID, {AbbrevOp::fixed(3), AbbrevOp::vbr(8), AbbrevOp::array(), AbbrevOp::fixed(8)});
+        vstEntry7Abbrev = stream.defineBlockInfoAbbrev(
+            VALUE_SYMTAB_BLOCK_ID,
+            {AbbrevOp::literal(VST_CODE_ENTRY), AbbrevOp::vbr(8), AbbrevOp::array(), AbbrevOp::fixed(7)});
+        vstEntry6Abbrev = stream.defineBlockInfoAbbrev(
+            VALUE_SYMTAB_BLOCK_ID,
+            {AbbrevOp::literal(VST_CODE_ENTRY), AbbrevOp::vbr(8), AbbrevOp::array(), AbbrevOp::char6()});
+        vstBlockEntry6Abbrev = stream.defineBlockInfoAbbrev(
+            VALUE_SYMTAB_BLOCK_ID,
+            {AbbrevOp::literal(VST_CODE_BBENTRY), AbbrevOp::vbr(8), AbbrevOp::array(), AbbrevOp::char6()});
+
+        settypeAbbrev = stream.defineBlockInfoAbbrev(
+            CONSTANTS_BLOCK_ID, {AbbrevOp::literal(CST_CODE_SETTYPE), AbbrevOp::fixed(typeBits)});
+        integerAbbrev =
+            stream.defineBlockInfoAbbrev(CONSTANTS_BLOCK_ID, {AbbrevOp::literal(CST_CODE_INTEGER), AbbrevOp::vbr(8)});
+        nullAbbrev = stream.defineBlockInfoAbbrev(CONSTANTS_BLOCK_ID, {AbbrevOp::literal(CST_CODE_NULL)});
+
+        // Instructions whose operands are all defined before them.
+        loadAbbrev = stream.defineBlockInfoAbbrev(
+            FUNCTION_BLOCK_ID, {AbbrevOp::literal(FUNC_CODE_INST_LOAD), AbbrevOp::vbr(6), AbbrevOp::fixed(typeBits),
+                                AbbrevOp::vbr(4), AbbrevOp::fixed(1)});
+        binopAbbrev = stream.defineBlockInfoAbbrev(
+            FUNCTION_BLOCK_ID,
+            {AbbrevOp::literal(FUNC_CODE_INST_BINOP), AbbrevOp::vbr(6), AbbrevOp::vbr(6), AbbrevOp::fixed(4)});
+        castAbbrev = stream.defineBlockInfoAbbrev(
+            FUNCTION_BLOCK_ID,
+            {AbbrevOp::literal(FUNC_CODE_INST_CAST), AbbrevOp::vbr(6), AbbrevOp::fixed(typeBits), AbbrevOp::fixed(4)});
+        retVoidAbbrev = stream.defineBlockInfoAbbrev(FUNCTION_BLOCK_ID, {AbbrevOp::literal(FUNC_CODE_INST_RET)});
+        retValAbbrev =
+            stream.defineBlockInfoAbbrev(FUNCTION_BLOCK_ID, {AbbrevOp::literal(FUNC_CODE_INST_RET), AbbrevOp::vbr(6)});
+        gepAbbrev = stream.defineBlockInfoAbbrev(
+            FUNCTION_BLOCK_ID, {AbbrevOp::literal(FUNC_CODE_INST_GEP), AbbrevOp::fixed(1), AbbrevOp::fixed(typeBits),
+                                AbbrevOp::array(), AbbrevOp::vbr(6)});
+        stream.exitBlock();
+    }
+
+    void writeTypeTable() {
+        stream.enterBlock(TYPE_BLOCK_ID_NEW, 4);
+        unsigned pointerAbbrev = stream.defineAbbrev(
+            {AbbrevOp::literal(TYPE_CODE_POINTER), AbbrevOp::fixed(typeBits), AbbrevOp::literal(0)});
+        unsigned functionAbbrev = stream.defineAbbrev(
+            {AbbrevOp::literal(TYPE_CODE_FUNCTION), AbbrevOp::fixed(1), AbbrevOp::array(), AbbrevOp::fixed(typeBits)});
+        unsigned arrayAbbrev = stream.defineAbbrev(
+            {AbbrevOp::literal(TYPE_CODE_ARRAY), AbbrevOp::vbr(8), AbbrevOp::fixed(typeBits)});
+        stream.emitRecord(TYPE_CODE_NUMENTRY, {types.size()});
+        for (const Type* type : types) {
+            switch (type->id) {
+            case Type::IntTyID:
+                stream.emitRecord(TYPE_CODE_INTEGER, {32});
+                break;
+            case Type::BoolTyID:
+                stream.emitRecord(TYPE_CODE_INTEGER, {1});
+                break;
+            case Type::VoidTyID:
+                stream.emitRecord(TYPE_CODE_VOID, {});
+                break;
+            case Type::ArrayTyID: {
+                auto* array = static_cast<const ArrayType*>(type);
+                stream.emitRecord(TYPE_CODE_ARRAY, {array->numElements, typeId(array->elementType)}, arrayAbbrev);
+                break;
+            }
+            case Type::PointerTyID:
+                stream.emitRecord(TYPE_CODE_POINTER, {typeId(static_cast<const PointerType*>(type)->pointeeType), 0},
+                                  pointerAbbrev);
+                break;
+            case Type::FunctionTyID: {
+                auto* function = static_cast<const FunctionType*>(type);
+                fields.assign({0, typeId(function->returnType)}); // not vararg
+                for (const Type* param : function->paramTypes) {
+                    fields.push_back(typeId(param));
+                }
+                stream.emitRecord(TYPE_CODE_FUNCTION, fields, functionAbbrev);
+                break;
+            }
+            }
+        }
+        stream.exitBlock();
+    }
+
+    // The source file name, then a record per global and per function.
+    void writeModuleInfo() {
+        std::string_view sourceName = "moudle"; // as in IRPrinter::header()
+        bool char6 = BitstreamWriter::isChar6(sourceName);
+        unsigned sourceAbbrev =
+            stream.defineAbbrev({AbbrevOp::literal(MODULE_CODE_SOURCE_FILENAME), AbbrevOp::array(),
+                                 char6 ? AbbrevOp::char6() : AbbrevOp::fixed(8)});
+        stream.emitRecord(MODULE_CODE_SOURCE_FILENAME, sourceName.data(), sourceName.size(), sourceAbbrev);
+
+        for (size_t i = 0; i < module.globalList.size(); ++i) {
+            const GlobalVariable& global = *module.globalList[i];
+            // [strtab offset, strtab size, value type, explicit type | constant,
+            //  initializer + 1, linkage, alignment, section, visibility,
+            //  thread local, unnamed_addr, externally initialized,
+            //  DLL storage, comdat, attributes, dso_local]
+            std::string_view name = module.getName(&global);
+            fields.assign({addToStrtab(name), name.size(), typeId(global.getValueType()),
+                           uint64_t(2) | global.isConstant, initializerOf[i] + uint64_t(1),
+                           encodeLinkage(global.linkage), ALIGN_4, 0, 0, 0, encodeUnnamedAddr(global.linkage), 0, 0,
+                           0, 0, 0});
+            stream.emitRecord(MODULE_CODE_GLOBALVAR, fields);
+        }
+        for (const Function& func : module.funcList) {
+            // [strtab offset, strtab size, function type, calling convention,
+            //  is declaration, linkage, attributes, alignment, section,
+            //  visibility, gc, unnamed_addr, prologue, DLL storage, comdat,
+            //  prefix, personality, dso_local, address space]
+            std::string_view name = module.getName(&func);
+            fields.assign({addToStrtab(name), name.size(), typeId(func.getFunctionType()), 0,
+                           func.blockList.empty(), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+            stream.emitRecord(MODULE_CODE_FUNCTION, fields);
+        }
+    }
+
+    uint64_t addToStrtab(std::string_view name) {
+        uint64_t offset = strtab.size();
+        strtab += name;
+        return offset;
+    }
+
+    // GlobalVariable::linkage is spelled as in the .ll, e.g. "private unnamed_addr".
+    static uint64_t encodeLinkage(const std::string& linkage) {
+        if (hasWord(linkage, "private")) {
+            return 9;
+        }
+        return hasWord(linkage, "internal") ? 3 : 0; // external
+    }
+    static uint64_t encodeUnnamedAddr(const std::string& linkage) {
+        if (hasWord(linkage, "local_unnamed_addr")) {
+            return 2;
+        }
+        return hasWord(linkage, "unnamed_addr") ? 1 : 0;
+    }
+    static bool hasWord(std::string_view text, std::string_view word) {
+        for (size_t pos = text.find(word); pos != std::string_view::npos; pos = text.find(word, pos + 1)) {
+            size_t end = pos + word.size();
+            if ((pos == 0 || text[pos - 1] == ' ') && (end == text.size() || text[end] == ' ')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A CONSTANTS block, switching the current type only when it changes.
+    void writeConstants(const std::vector<Constant>& list) {
+        if (list.empty()) {
+            return;
+        }
+        stream.enterBlock(CONSTANTS_BLOCK_ID, 4);
+        const Type* current = nullptr;
+        for (const Constant& constant : list) {
+            if (constant.type != current) {
+                stream.emitRecord(CST_CODE_SETTYPE, {typeId(constant.type)}, settypeAbbrev);
+                current = constant.type;
+            }
+            switch (constant.kind) {
+            case Constant::Null:
+                stream.emitRecord(CST_CODE_NULL, {}, nullAbbrev);
+                break;
+            case Constant::Undef:
+                stream.emitRecord(CST_CODE_UNDEF, {});
+                break;
+            case Constant::Integer:
+                stream.emitRecord(CST_CODE_INTEGER, {encodeSigned(signExtend(constant.type, constant.value))},
+                                  integerAbbrev);
+                break;
+            case Constant::Data:
+                stream.emitRecord(CST_CODE_DATA, constant.elements);
+                break;
+            case Constant::Aggregate:
+                stream.emitRecord(CST_CODE_AGGREGATE, constant.elements);
+                break;
+            }
+        }
+        stream.exitBlock();
+    }
+
+    // The value of an integer constant of `type`, read as signed.
+    static int64_t signExtend(const Type* type, int64_t value) {
+        if (type->id == Type::BoolTyID) {
+            return value & 1 ? -1 : 0;
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    // Sign in the low bit, magnitude above it, so small negative numbers
+    // stay short as VBRs.
+    static uint64_t encodeSigned(int64_t value) {
+        return value >= 0 ? uint64_t(value) << 1 : (uint64_t(0) - uint64_t(value)) << 1 | 1;
+    }
+
+    // --- Functions ---
+
+    void writeFunction(const Function& func) {
+        // The names IRPrinter would give, before Value::number is reused for IDs.
+        SlotTracker slots(func);
+        uint32_t instId = enumerateFunction(func);
+
+        stream.enterBlock(FUNCTION_BLOCK_ID, 4);
+        stream.emitRecord(FUNC_CODE_DECLAREBLOCKS, {numBlocks});
+        writeConstants(constants);
+        for (const BasicBlock& block : func.blockList) {
+            for (const Instruction& inst : block.instList) {
+                writeInstruction(inst, instId);
+                if (inst.type->id != Type::VoidTyID) {
+                    ++instId;
+                }
+            }
+        }
+        writeSymbolTable(slots);
+        stream.exitBlock();
+    }
+
+    // Pushes the operand relative to `instId`; an operand defined later
+    // also needs its type. Returns whether it is such a forward reference.
+    bool pushValueAndType(const Value* value, uint32_t instId) {
+        uint32_t id = valueId(value);
+        fields.push_back(static_cast<uint32_t>(instId - id));
+        if (id >= instId) {
+            fields.push_back(typeId(value->type));
+            return true;
+        }
+        return false;
+    }
+    void pushValue(const Value* value, uint32_t instId) {
+        fields.push_back(static_cast<uint32_t>(instId - valueId(value)));
+    }
+
+    void writeInstruction(const Instruction& inst, uint32_t instId) {
+        fields.clear();
+        unsigned code = 0;
+        unsigned abbrev = BitstreamWriter::UNABBREV_RECORD;
+        switch (inst.opcode) {
+        case Instruction::Alloca:
+            // [allocated type, size type, size (absolute), alignment | flags]
+            code = FUNC_CODE_INST_ALLOCA;
+            fields.assign({typeId(static_cast<PointerType*>(inst.type)->pointeeType), typeId(Type::getInt32Ty()),
+                           constantIds[constantIndex.find(&ALLOCA_SIZE)], ALIGN_4 | EXPLICIT_TYPE});
+            break;
+        case Instruction::Load:
+            // [pointer, type, alignment, volatile]
+            code = FUNC_CODE_INST_LOAD;
+            if (!pushValueAndType(inst.getOperand(0), instId)) {
+                abbrev = loadAbbrev;
+            }
+            fields.insert(fields.end(), {typeId(inst.type), ALIGN_4, 0});
+            break;
+        case Instruction::Store:
+            // [pointer, value, alignment, volatile]
+            code = FUNC_CODE_INST_STORE;
+            pushValueAndType(inst.getOperand(1), instId);
+            pushValueAndType(inst.getOperand(0), instId);
+            fields.insert(fields.end(), {ALIGN_4, 0});
+            break;
+        case Instruction::GetElementPtr: {
+            // [inbounds, source type, pointer, indices...]
+            code = FUNC_CODE_INST_GEP;
+            abbrev = gepAbbrev;
+            Value* ptr = inst.getOperand(0);
+            fields.assign({1, typeId(static_cast<PointerType*>(ptr->type)->pointeeType)});
+            for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                pushValueAndType(inst.getOperand(i), instId);
+            }
+            break;
+        }
+        case Instruction::Add:
+        case Instruction::Sub:
+        case Instruction::Mul:
+        case Instruction::SDiv:
+        case Instruction::SRem:
+            // [lhs, rhs, opcode]
+            code = FUNC_CODE_INST_BINOP;
+            if (!pushValueAndType(inst.getOperand(0), instId)) {
+                abbrev = binopAbbrev;
+            }
+            pushValue(inst.getOperand(1), instId);
+            fields.push_back(encodeBinaryOpcode(inst.opcode));
+            break;
+        case Instruction::ICmp:
+            // [lhs, rhs, predicate]
+            code = FUNC_CODE_INST_CMP2;
+            pushValueAndType(inst.getOperand(0), instId);
+            pushValue(inst.getOperand(1), instId);
+            fields.push_back(encodePredicate(static_cast<const ICmpInst&>(inst).getPredicate()));
+            break;
+        case Instruction::ZExt:
+            // [value, destination type, cast opcode]
+            code = FUNC_CODE_INST_CAST;
+            if (!pushValueAndType(inst.getOperand(0), instId)) {
+                abbrev = castAbbrev;
+            }
+            fields.insert(fields.end(), {typeId(inst.type), CAST_ZEXT});
+            break;
+        case Instruction::Ret:
+            // [] or [value]
+            code = FUNC_CODE_INST_RET;
+            if (inst.getNumOperands() == 0) {
+                abbrev = retVoidAbbrev;
+            } else if (!pushValueAndType(inst.getOperand(0), instId)) {
+                abbrev = retValAbbrev;
+            }
+            break;
+        }
+        stream.emitRecord(code, fields, abbrev);
+    }
+
+    static uint64_t encodeBinaryOpcode(Instruction::Opcode opcode) {
+        switch (opcode) {
+        case Instruction::Add: return 0;
+        case Instruction::Sub: return 1;
+        case Instruction::Mul: return 2;
+        case Instruction::SDiv: return 4;
+        case Instruction::SRem: return 6;
+        default: return 0;
+        }
+    }
+
+    static uint64_t encodePredicate(ICmpInst::Predicate predicate) {
+        switch (predicate) {
+        case ICmpInst::EQ: return 32;
+        case ICmpInst::NE: return 33;
+        case ICmpInst::SGT: return 38;
+        case ICmpInst::SGE: return 39;
+        case ICmpInst::SLT: return 40;
+        case ICmpInst::SLE: return 41;
+        }
+        return 0;
+    }
+
+    // Names of the function's blocks and instructions: value IDs for
+    // instructions, indices for blocks.
+    void writeSymbolTable(const SlotTracker& slots) {
+        const auto& named = slots.getNamedLocals();
+        if (named.empty()) {
+            return;
+        }
+        stream.enterBlock(VALUE_SYMTAB_BLOCK_ID, 4);
+        for (const auto& [value, name] : named) {
+            bool isBlock = const_cast<Value*>(value)->asBasicBlock() != nullptr;
+            fields.assign(1, value->number);
+            for (char c : name) {
+                fields.push_back(static_cast<unsigned char>(c));
+            }
+            unsigned abbrev = vstEntry8Abbrev;
+            if (BitstreamWriter::isChar6(name)) {
+                abbrev = isBlock ? vstBlockEntry6Abbrev : vstEntry6Abbrev;
+            } else if (!isBlock && std::all_of(name.begin(), name.end(), [](char c) { return (c & 0x80) == 0; })) {
+                abbrev = vstEntry7Abbrev;
+            }
+            stream.emitRecord(isBlock ? VST_CODE_BBENTRY : VST_CODE_ENTRY, fields, abbrev);
+        }
+        stream.exitBlock();
+    }
+};
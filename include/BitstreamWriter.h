@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// One operand of an abbreviation: how a field of an abbreviated record is
+// encoded. An Array is followed by the operand for its elements and must be
+// last, as must a Blob.
+struct AbbrevOp {
+    enum Kind : uint8_t { Literal, Fixed, VBR, Array, Char6, Blob };
+    Kind kind;
+    uint64_t value = 0; // the literal, or the width of Fixed and VBR
+
+    static AbbrevOp literal(uint64_t value) { return {Literal, value}; }
+    static AbbrevOp fixed(unsigned width) { return {Fixed, width}; }
+    static AbbrevOp vbr(unsigned width) { return {VBR, width}; }
+    static AbbrevOp array() { return {Array, 0}; }
+    static AbbrevOp char6() { return {Char6, 0}; }
+    static AbbrevOp blob() { return {Blob, 0}; }
+};
+
+// The record layout an abbreviation ID stands for; the first operand
+// encodes the record code.
+using Abbrev = std::vector<AbbrevOp>;
+
+// Writes the LLVM bitstream container format: a stream of bits grouped into
+// nested blocks, each holding records of unsigned integers. A record is
+// either written field by field as 6-bit VBRs, or against an abbreviation
+// that fixes the width and encoding of each field (and may make some of
+// them literals, which take no bits at all). Abbreviations are defined in
+// the block that uses them, or once for every block with a given ID in the
+// BLOCKINFO block. Bits fill 32-bit little-endian words from the low end,
+// and a block's length is patched in when it is closed.
+class BitstreamWriter {
+public:
+    // Abbreviation IDs every block has.
+    enum : unsigned { END_BLOCK = 0, ENTER_SUBBLOCK = 1, DEFINE_ABBREV = 2, UNABBREV_RECORD = 3 };
+    static constexpr unsigned FIRST_APPLICATION_ABBREV = 4;
+    static constexpr unsigned BLOCKINFO_BLOCK_ID = 0;
+    static constexpr unsigned BLOCKINFO_CODE_SETBID = 1;
+
+    const std::string& buffer() const { return out; }
+
+    void emit(uint32_t value, unsigned width) {
+        assert(width > 0 && width <= 32 && (width == 32 || value >> width == 0));
+        curValue |= uint64_t(value) << curBit;
+        curBit += width;
+        if (curBit >= 32) {
+            writeWord(static_cast<uint32_t>(curValue));
+            curValue >>= 32;
+            curBit -= 32;
+        }
+    }
+
+    void emit64(uint64_t value, unsigned width) {
+        if (width > 32) {
+            emit(static_cast<uint32_t>(value), 32);
+            emit(static_cast<uint32_t>(value >> 32), width - 32);
+        } else {
+            emit(static_cast<uint32_t>(value), width);
+        }
+    }
+
+    // Variable-width integer: chunks of width - 1 bits, low chunk first,
+    // each with a continuation bit on top.
+    void emitVBR(uint64_t value, unsigned width) {
+        uint64_t threshold = uint64_t(1) << (width - 1);
+        while (value >= threshold) {
+            emit(static_cast<uint32_t>((value & (threshold - 1)) | threshold), width);
+            value >>= width - 1;
+        }
+        emit(static_cast<uint32_t>(value), width);
+    }
+
+    void alignToWord() {
+        if (curBit > 0) {
+            writeWord(static_cast<uint32_t>(curValue));
+            curValue = 0;
+            curBit = 0;
+        }
+    }
+
+    // Opens a block whose abbreviation IDs are `abbrevWidth` bits wide; the
+    // abbreviations BLOCKINFO defines for `blockId` are in scope at once.
+    void enterBlock(unsigned blockId, unsigned abbrevWidth) {
+        emit(ENTER_SUBBLOCK, curWidth);
+        emitVBR(blockId, 8);
+        emitVBR(abbrevWidth, 4);
+        alignToWord();
+        blocks.push_back({curWidth, out.size(), std::move(curAbbrevs)});
+        emit(0, 32); // the length, patched by exitBlock()
+        curWidth = abbrevWidth;
+        curAbbrevs.clear();
+        auto info = blockInfo.find(blockId);
+        if (info != blockInfo.end()) {
+            curAbbrevs = info->second;
+        }
+    }
+
+    void exitBlock() {
+        assert(!blocks.empty());
+        emit(END_BLOCK, curWidth);
+        alignToWord();
+        Scope& scope = blocks.back();
+        auto words = static_cast<uint32_t>((out.size() - scope.lengthOffset) / 4 - 1);
+        for (int i = 0; i < 4; ++i) {
+            out[scope.lengthOffset + i] = static_cast<char>(words >> (8 * i));
+        }
+        curWidth = scope.outerWidth;
+        curAbbrevs = std::move(scope.outerAbbrevs);
+        blocks.pop_back();
+    }
+
+    // Defines an abbreviation for the rest of the current block; returns
+    // its ID.
+    unsigned defineAbbrev(const Abbrev& abbrev) {
+        writeAbbrev(abbrev);
+        curAbbrevs.push_back(&abbrevs.emplace_back(abbrev));
+        return FIRST_APPLICATION_ABBREV + static_cast<unsigned>(curAbbrevs.size()) - 1;
+    }
+
+    // BLOCKINFO: abbreviations for every later block with a given ID.
+    // Call defineBlockInfoAbbrev() between these two.
+    void enterBlockInfoBlock() {
+        enterBlock(BLOCKINFO_BLOCK_ID, 2);
+        blockInfoId = UINT32_MAX;
+    }
+    unsigned defineBlockInfoAbbrev(unsigned blockId, const Abbrev& abbrev) {
+        if (blockId != blockInfoId) {
+            emitRecord(BLOCKINFO_CODE_SETBID, {blockId});
+            blockInfoId = blockId;
+        }
+        writeAbbrev(abbrev);
+        std::vector<const Abbrev*>& list = blockInfo[blockId];
+        list.push_back(&abbrevs.emplace_back(abbrev));
+        return FIRST_APPLICATION_ABBREV + static_cast<unsigned>(list.size()) - 1;
+    }
+
+    // A record, unabbreviated or with abbreviation `abbrevId`.
+    template <typename T>
+    void emitRecord(unsigned code, const std::vector<T>& fields, unsigned abbrevId = UNABBREV_RECORD) {
+        emitRecord(code, fields.data(), fields.size(), abbrevId);
+    }
+    void emitRecord(unsigned code, std::initializer_list<uint64_t> fields, unsigned abbrevId = UNABBREV_RECORD) {
+        emitRecord(code, fields.begin(), fields.size(), abbrevId);
+    }
+
+    template <typename T>
+    void emitRecord(unsigned code, const T* fields, size_t count, unsigned abbrevId = UNABBREV_RECORD) {
+        if (abbrevId == UNABBREV_RECORD) {
+            emit(UNABBREV_RECORD, curWidth);
+            emitVBR(code, 6);
+            emitVBR(count, 6);
+            for (size_t i = 0; i < count; ++i) {
+                emitVBR(static_cast<uint64_t>(fields[i]), 6);
+            }
+            return;
+        }
+        const Abbrev& abbrev = abbrevFor(abbrevId);
+        emit(abbrevId, curWidth);
+        // The code is field -1 as far as the abbreviation is concerned.
+        size_t next = 0;
+        for (size_t op = 0; op < abbrev.size(); ++op) {
+            if (abbrev[op].kind == AbbrevOp::Array) {
+                const AbbrevOp& element = abbrev[op + 1];
+                emitVBR(count - next, 6);
+                for (; next < count; ++next) {
+                    emitScalar(element, static_cast<uint64_t>(fields[next]));
+                }
+                return;
+            }
+            assert(abbrev[op].kind != AbbrevOp::Blob && "use emitRecordWithBlob");
+            if (op == 0) {
+                emitScalar(abbrev[op], code);
+            } else {
+                assert(next < count);
+                emitScalar(abbrev[op], static_cast<uint64_t>(fields[next++]));
+            }
+        }
+        assert(next == count);
+    }
+
+    // A record whose abbreviation is the code followed by a Blob.
+    void emitRecordWithBlob(unsigned code, std::string_view blob, unsigned abbrevId) {
+        const Abbrev& abbrev = abbrevFor(abbrevId);
+        assert(abbrev.size() == 2 && abbrev[1].kind == AbbrevOp::Blob);
+        emit(abbrevId, curWidth);
+        emitScalar(abbrev[0], code);
+        emitVBR(blob.size(), 6);
+        alignToWord();
+        out.append(blob);
+        out.append((4 - blob.size() % 4) % 4, '\0');
+    }
+
+    // Whether every character of `text` fits the Char6 encoding.
+    static bool isChar6(std::string_view text) {
+        for (char c : text) {
+            if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_')) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Scope {
+        unsigned outerWidth;
+        size_t lengthOffset; // byte offset of the length word
+        std::vector<const Abbrev*> outerAbbrevs;
+    };
+
+    std::string out;
+    uint64_t curValue = 0; // bits not yet in `out`, low first
+    unsigned curBit = 0;
+    unsigned curWidth = 2; // the width of abbreviation IDs outside any block
+    std::vector<const Abbrev*> curAbbrevs;
+    std::vector<Scope> blocks;
+    std::deque<Abbrev> abbrevs; // every abbreviation defined, at a stable address
+    std::unordered_map<unsigned, std::vector<const Abbrev*>> blockInfo;
+    unsigned blockInfoId = UINT32_MAX;
+
+    void writeWord(uint32_t word) {
+        char bytes[4] = {static_cast<char>(word), static_cast<char>(word >> 8), static_cast<char>(word >> 16),
+                         static_cast<char>(word >> 24)};
+        out.append(bytes, 4);
+    }
+
+    void writeAbbrev(const Abbrev& abbrev) {
+        emit(DEFINE_ABBREV, curWidth);
+        emitVBR(abbrev.size(), 5);
+        for (const AbbrevOp& op : abbrev) {
+            emit(op.kind == AbbrevOp::Literal, 1);
+            if (op.kind == AbbrevOp::Literal) {
+                emitVBR(op.value, 8);
+                continue;
+            }
+            emit(op.kind, 3); // Fixed = 1 ... Blob = 5, as the format numbers them
+            if (op.kind == AbbrevOp::Fixed || op.kind == AbbrevOp::VBR) {
+                emitVBR(op.value, 5);
+            }
+        }
+    }
+
+    const Abbrev& abbrevFor(unsigned abbrevId) const {
+        assert(abbrevId >= FIRST_APPLICATION_ABBREV && abbrevId - FIRST_APPLICATION_ABBREV < curAbbrevs.size());
+        return *curAbbrevs[abbrevId - FIRST_APPLICATION_ABBREV];
+    }
+
+    void emitScalar(const AbbrevOp& op, uint64_t value) {
+        switch (op.kind) {
+        case AbbrevOp::Literal:
+            assert(value == op.value);
+            break;
+        case AbbrevOp::Fixed:
+            emit64(value, static_cast<unsigned>(op.value));
+            break;
+        case AbbrevOp::VBR:
+            emitVBR(value, static_cast<unsigned>(op.value));
+            break;
+        case AbbrevOp::Char6:
+            emit(encodeChar6(static_cast<char>(value)), 6);
+            break;
+        case AbbrevOp::Array:
+        case AbbrevOp::Blob:
+            assert(false && "not a scalar operand");
+            break;
+        }
+    }
+
+    static uint32_t encodeChar6(char c) {
+        if (c >= 'a' && c <= 'z') {
+            return static_cast<uint32_t>(c - 'a');
+        }
+        if (c >= 'A' && c <= 'Z') {
+            return static_cast<uint32_t>(c - 'A' + 26);
+        }
+        if (c >= '0' && c <= '9') {
+            return static_cast<uint32_t>(c - '0' + 52);
+        }
+        return c == '.' ? 62 : 63;
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "IR.h"
+
+// An undo log for one function, so that a pass can try a transformation,
+// weigh the result, and keep it or put the function back as it was without
+// copying it first:
+//
+//     ChangeJournal journal(func);
+//     journal.checkpoint();
+//     transform(func);
+//     if (cost(func) < before) journal.commit(); else journal.rollback();
+//
+// While a checkpoint is open the journal is attached to the function
+// (Function::journal) and records each change to the function's body as it
+// is made: an operand pointed at another value, a block or instruction
+// linked into or unlinked from its list. An instruction unlinked from its
+// block also has its operands recorded, since edits made to it before it
+// is linked in again reach no journal. A rollback replays the records
+// backwards, so it takes time in proportion to what was changed, not to the
+// size of the function. Blocks and instructions erased meanwhile are kept,
+// unlinked and with their operands cleared, until the outermost checkpoint
+// is committed; a rollback frees the ones created since its checkpoint.
+//
+// Checkpoints nest. commit() and rollback() close the innermost one, and
+// changes a committed inner checkpoint kept are still undone by rolling back
+// an outer one. A checkpoint still open when the journal is destroyed is
+// rolled back.
+//
+// Only the function's body is recorded: not names, globals, other functions
+// or the module's constants. Blocks and instructions must stay within the
+// function, and one taken out with remove() must be inserted again before
+// the checkpoint closes.
+class ChangeJournal : private FunctionJournal {
+public:
+    explicit ChangeJournal(Function& func) : func(func) {}
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+    ~ChangeJournal() override {
+        while (!checkpoints.empty()) {
+            rollback();
+        }
+    }
+
+    void checkpoint() {
+        assert((checkpoints.empty() ? !func.journal : func.journal == this) && "one journal per function");
+        checkpoints.push_back({changes.size(), erased.size()});
+        func.journal = this;
+    }
+
+    // Keeps the changes since the last checkpoint.
+    void commit() {
+        assert(!checkpoints.empty());
+        checkpoints.pop_back();
+        if (!checkpoints.empty()) {
+            return;
+        }
+        func.journal = nullptr;
+        changes.clear();
+        for (Value* node : erased) {
+            if (Instruction* inst = node->asInstruction()) {
+                free(inst);
+            } else {
+                func.getParent()->getArena().destroy(node->asBasicBlock());
+            }
+        }
+        erased.clear();
+    }
+
+    // Undoes the changes since the last checkpoint.
+    void rollback() {
+        assert(!checkpoints.empty());
+        Checkpoint checkpoint = checkpoints.back();
+        checkpoints.pop_back();
+        func.journal = nullptr;
+        // Nodes unlinked by undoing their insertion; those that undoing an
+        // earlier removal does not link back were created since the
+        // checkpoint.
+        std::vector<Value*> unlinked;
+        for (size_t i = changes.size(); i-- > checkpoint.changes;) {
+            const Change& change = changes[i];
+            switch (change.kind) {
+            case Change::Operand:
+                static_cast<Use*>(change.node)->set(static_cast<Value*>(change.from));
+                break;
+            case Change::InsertInstruction: {
+                auto* inst = static_cast<Instruction*>(change.node);
+                inst->getParent()->instList.remove(BasicBlock::InstListType::iteratorTo(inst));
+                unlinked.push_back(inst);
+                break;
+            }
+            case Change::RemoveInstruction: {
+                auto* inst = static_cast<Instruction*>(change.node);
+                auto* block = static_cast<BasicBlock*>(change.from);
+                auto* next = static_cast<Instruction*>(change.next);
+                block->instList.insert(next ? BasicBlock::InstListType::iteratorTo(next) : block->instList.end(), inst);
+                break;
+            }
+            case Change::InsertBlock: {
+                auto* block = static_cast<BasicBlock*>(change.node);
+                func.blockList.remove(IList<BasicBlock, Function>::iteratorTo(block));
+                unlinked.push_back(block);
+                break;
+            }
+            case Change::RemoveBlock: {
+                auto* block = static_cast<BasicBlock*>(change.node);
+                auto* next = static_cast<BasicBlock*>(change.next);
+                func.blockList.insert(next ? IList<BasicBlock, Function>::iteratorTo(next) : func.blockList.end(), block);
+                break;
+            }
+            }
+        }
+        changes.resize(checkpoint.changes);
+        // Whatever was erased since the checkpoint is linked in again.
+        erased.resize(checkpoint.erased);
+        // A node moved more than once was unlinked more than once.
+        std::sort(unlinked.begin(), unlinked.end());
+        unlinked.erase(std::unique(unlinked.begin(), unlinked.end()), unlinked.end());
+        for (Value* node : unlinked) {
+            if (Instruction* inst = node->asInstruction()) {
+                if (!inst->getParent()) {
+                    free(inst);
+                }
+            } else if (!node->asBasicBlock()->getParent()) {
+                func.getParent()->getArena().destroy(node->asBasicBlock());
+            }
+        }
+        if (!checkpoints.empty()) {
+            func.journal = this;
+        }
+    }
+
+    bool hasCheckpoint() const { return !checkpoints.empty(); }
+    // Changes recorded since the outermost checkpoint.
+    size_t size() const { return changes.size(); }
+
+private:
+    struct Change {
+        enum Kind : uint8_t { Operand, InsertInstruction, RemoveInstruction, InsertBlock, RemoveBlock };
+        Kind kind;
+        void* node; // the Use, Instruction or BasicBlock
+        void* from; // the value the Use pointed at; the block a removed instruction was in
+        void* next; // the node after a removed one, nullptr at the end
+    };
+    struct Checkpoint {
+        size_t changes;
+        size_t erased;
+    };
+
+    Function& func;
+    std::vector<Change> changes;
+    std::vector<Checkpoint> checkpoints;
+    std::vector<Value*> erased; // blocks and instructions, in the order they were erased
+
+    void free(Instruction* inst) {
+        size_t size = inst->getAllocSize();
+        inst->~Instruction();
+        func.getParent()->getArena().recycle(inst, size);
+    }
+
+    void operandChanged(Use* use) override { changes.push_back({Change::Operand, use, use->get(), nullptr}); }
+
+    void instructionInserted(Instruction* inst) override {
+        changes.push_back({Change::InsertInstruction, inst, nullptr, nullptr});
+    }
+
+    // Once unlinked, the instruction has no function to report its operand
+    // changes to, so its operands are recorded as they are now; a rollback
+    // then also undoes edits made while it was out of its block.
+    void instructionRemoved(Instruction* inst, Instruction* next) override {
+        for (size_t i = 0; i < inst->getNumOperands(); ++i) {
+            Use& use = inst->getOperandUse(i);
+            changes.push_back({Change::Operand, &use, use.get(), nullptr});
+        }
+        changes.push_back({Change::RemoveInstruction, inst, inst->getParent(), next});
+    }
+
+    void blockInserted(BasicBlock* block) override { changes.push_back({Change::InsertBlock, block, nullptr, nullptr}); }
+
+    void blockRemoved(BasicBlock* block, BasicBlock* next) override {
+        changes.push_back({Change::RemoveBlock, block, nullptr, next});
+    }
+
+    // The instruction is unlinked but still knows its block, so clearing its
+    // operands is recorded too.
+    void instructionErased(Instruction* inst) override {
+        inst->dropAllReferences();
+        erased.push_back(inst);
+    }
+
+    void blockErased(BasicBlock* block) override {
+        for (Instruction& inst : block->instList) {
+            inst.dropAllReferences();
+        }
+        erased.push_back(block);
+    }
+};
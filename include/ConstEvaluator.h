@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "ExpWalker.h"
+#include "SysYParser.h"
+
+// Value of a `const` declaration, known at compile time.
+struct ConstValue {
+    std::vector<uint32_t> dims;    // empty for a scalar
+    std::vector<int32_t> elements; // row-major, one per scalar element (zero-filled)
+
+    // Number of elements in a sub-array that starts at dimension `level`.
+    size_t span(size_t level) const {
+        size_t n = 1;
+        for (size_t i = level; i < dims.size(); ++i) {
+            n *= dims[i];
+        }
+        return n;
+    }
+};
+
+// Folds constant expressions (constExp, array dimensions, const initializers)
+// to i32 values without emitting any IR.
+//
+// An expression is constant if it is built from integer literals, the unary
+// and binary operators, and references to constants: const scalars, or
+// elements of const arrays at constant indices. Arithmetic wraps modulo 2^32
+// like the i32 it stands for; division by zero and INT_MIN / -1 are not
+// constant. && and || short-circuit, so `0 && x / 0` is 0.
+class ConstEvaluator {
+public:
+    // Returns the ConstValue an identifier is bound to, or nullptr if it
+    // does not name a constant in the current scope.
+    using Resolver = std::function<const ConstValue*(antlr4::tree::TerminalNode*)>;
+
+    explicit ConstEvaluator(Resolver resolve) : resolve(std::move(resolve)), walker(*this) {}
+
+    ConstEvaluator(const ConstEvaluator&) = delete;
+    ConstEvaluator& operator=(const ConstEvaluator&) = delete;
+
+    // Evaluates `ctx`; false if it is not a compile-time constant.
+    bool eval(SysYParser::ExpContext* ctx, int32_t& out) {
+        Result result = walker.walk(ctx);
+        out = result.value;
+        return result.ok;
+    }
+
+    // Fills value.elements from a const initializer, for value.dims already
+    // set. Following the C rules, a braced sub-list initializes the largest
+    // sub-array that starts at the current position, and elements without
+    // an initializer are zero. False if an element is not constant, the
+    // list has too many elements, or the shape does not fit the type.
+    bool evalInitializer(SysYParser::ConstInitValContext* ctx, ConstValue& value) {
+        value.elements.assign(value.span(0), 0);
+        if (value.dims.empty()) {
+            SysYParser::ConstExpContext* exp = ctx->constExp();
+            return exp && eval(exp->exp(), value.elements[0]);
+        }
+        return !ctx->constExp() && fill(ctx, 0, 0, value);
+    }
+
+    // The arithmetic shared with constant folding in the IR generator.
+    // `op` is a SysYParser token type. False if the result is not defined.
+    static bool applyBinary(size_t op, int32_t lhs, int32_t rhs, int32_t& out) {
+        int64_t a = lhs;
+        int64_t b = rhs;
+        int64_t result;
+        switch (op) {
+        case SysYParser::PLUS: result = a + b; break;
+        case SysYParser::MINUS: result = a - b; break;
+        case SysYParser::MUL: result = a * b; break;
+        case SysYParser::DIV:
+        case SysYParser::MOD:
+            if (b == 0 || (a == INT32_MIN && b == -1)) {
+                return false;
+            }
+            result = op == SysYParser::DIV ? a / b : a % b;
+            break;
+        case SysYParser::LT: result = a < b; break;
+        case SysYParser::GT: result = a > b; break;
+        case SysYParser::LE: result = a <= b; break;
+        case SysYParser::GE: result = a >= b; break;
+        case SysYParser::EQ: result = a == b; break;
+        case SysYParser::NEQ: result = a != b; break;
+        case SysYParser::AND: result = a && b; break;
+        case SysYParser::OR: result = a || b; break;
+        default: return false;
+        }
+        out = static_cast<int32_t>(static_cast<uint32_t>(result));
+        return true;
+    }
+
+    static int32_t applyUnary(size_t op, int32_t operand) {
+        switch (op) {
+        case SysYParser::MINUS: return static_cast<int32_t>(0u - static_cast<uint32_t>(operand));
+        case SysYParser::NOT: return operand == 0;
+        default: return operand; // PLUS
+        }
+    }
+
+private:
+    friend class ExpWalker<ConstEvaluator>;
+
+    // An operand that is not constant poisons the expression, except as the
+    // operand && / || do not need.
+    struct Result {
+        int32_t value = 0;
+        bool ok = false;
+    };
+
+    Resolver resolve;
+    ExpWalker<ConstEvaluator> walker;
+
+    // --- ExpWalker visitor ---
+
+    Result unsupported(antlr4::ParserRuleContext*) { return {}; } // e.g. function calls
+
+    Result number(SysYParser::NumberContext* ctx) {
+        if (ctx->children.empty() || ctx->children[0]->getTreeType() != antlr4::tree::ParseTreeType::TERMINAL) {
+            return {};
+        }
+        // Decimal digits only, wrapping modulo 2^32 (see IRGenerator::number).
+        uint32_t value = 0;
+        for (char c : static_cast<antlr4::tree::TerminalNode*>(ctx->children[0])->getSymbol()->getText()) {
+            value = value * 10 + static_cast<uint32_t>(c - '0');
+        }
+        return {static_cast<int32_t>(value), true};
+    }
+
+    Result unary(size_t op, Result operand) {
+        return operand.ok ? Result{applyUnary(op, operand.value), true} : Result{};
+    }
+
+    bool enterBinary(SysYParser::ExpContext*, size_t, Result&) { return true; }
+
+    Result binary(SysYParser::ExpContext*, size_t op, Result lhs, Result rhs) {
+        if (!lhs.ok) {
+            return {};
+        }
+        if ((op == SysYParser::AND && lhs.value == 0) || (op == SysYParser::OR && lhs.value != 0)) {
+            return {op == SysYParser::OR, true};
+        }
+        Result result;
+        result.ok = rhs.ok && applyBinary(op, lhs.value, rhs.value, result.value);
+        return result;
+    }
+
+    // A const scalar, or a const array element with every index given.
+    bool enterLVal(SysYParser::LValContext* ctx, Result& out) {
+        const ConstValue* value = resolve(static_cast<antlr4::tree::TerminalNode*>(ctx->children[0]));
+        out = {};
+        if (!value || ctx->children.size() != 1 + 3 * value->dims.size()) {
+            return false;
+        }
+        if (value->dims.empty()) {
+            out = {value->elements[0], true};
+            return false;
+        }
+        return true;
+    }
+
+    Result lVal(SysYParser::LValContext* ctx, const Result* indices, size_t count) {
+        const ConstValue* value = resolve(static_cast<antlr4::tree::TerminalNode*>(ctx->children[0]));
+        size_t offset = 0;
+        for (size_t d = 0; d < count; ++d) {
+            if (!indices[d].ok || indices[d].value < 0 || static_cast<uint32_t>(indices[d].value) >= value->dims[d]) {
+                return {};
+            }
+            offset = offset * value->dims[d] + static_cast<size_t>(indices[d].value);
+        }
+        return {value->elements[offset], true};
+    }
+
+    // Initializes the sub-array of dimension `level` that starts at element
+    // `base` from the braced list `ctx`.
+    bool fill(SysYParser::ConstInitValContext* ctx, size_t level, size_t base, ConstValue& value) {
+        size_t end = base + value.span(level);
+        size_t pos = base;
+        for (SysYParser::ConstInitValContext* item : ctx->constInitVal()) {
+            if (pos >= end) {
+                return false; // excess elements
+            }
+            if (SysYParser::ConstExpContext* exp = item->constExp()) {
+                if (!eval(exp->exp(), value.elements[pos++])) {
+                    return false;
+                }
+                continue;
+            }
+            size_t sub = level + 1;
+            while (sub < value.dims.size() && (pos - base) % value.span(sub) != 0) {
+                ++sub;
+            }
+            if (sub == value.dims.size() || !fill(item, sub, pos, value)) {
+                return false; // braces around a scalar, or a bad element
+            }
+            pos += value.span(sub);
+        }
+        return true;
+    }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+#include "IR.h"
+
+// Replaces instructions whose operands are all constants with the constant
+// they compute: binary operators, icmp and zext. A folded instruction is
+// erased once its uses point at the constant, so its users see constant
+// operands when the walk reaches them and folding cascades in one pass.
+// Division and remainder by zero, and INT_MIN / -1, are undefined behavior
+// and are left as they are.
+class ConstantFolding {
+public:
+    // Returns the number of instructions folded away.
+    static size_t run(Function& func) {
+        IRContext& context = func.getParent()->getContext();
+        size_t folded = 0;
+        for (BasicBlock& block : func.blockList) {
+            for (auto it = block.instList.begin(); it != block.instList.end();) {
+                if (Value* constant = fold(*it, context)) {
+                    it->replaceAllUsesWith(constant);
+                    it = block.instList.erase(it);
+                    ++folded;
+                } else {
+                    ++it;
+                }
+            }
+        }
+        return folded;
+    }
+
+    // The constant `inst` computes, or nullptr if it does not fold.
+    static Value* fold(Instruction& inst, IRContext& context) {
+        if (inst.opcode == Instruction::ZExt) {
+            ConstantInt* operand = inst.getOperand(0)->asConstantInt();
+            return operand ? context.getInt32(static_cast<int32_t>(operand->value & 1)) : nullptr;
+        }
+        if (!inst.isBinaryOp() && inst.opcode != Instruction::ICmp) {
+            return nullptr;
+        }
+        ConstantInt* lhs = inst.getOperand(0)->asConstantInt();
+        ConstantInt* rhs = inst.getOperand(1)->asConstantInt();
+        if (!lhs || !rhs) {
+            return nullptr;
+        }
+        int32_t a = signedValue(lhs);
+        int32_t b = signedValue(rhs);
+        if (inst.opcode == Instruction::ICmp) {
+            return context.getConstantInt(Type::getInt1Ty(), compare(static_cast<ICmpInst&>(inst).getPredicate(), a, b));
+        }
+        // Add, Sub and Mul wrap around, so compute them unsigned.
+        auto ua = static_cast<uint32_t>(a);
+        auto ub = static_cast<uint32_t>(b);
+        switch (inst.opcode) {
+        case Instruction::Add:
+            return context.getInt32(static_cast<int32_t>(ua + ub));
+        case Instruction::Sub:
+            return context.getInt32(static_cast<int32_t>(ua - ub));
+        case Instruction::Mul:
+            return context.getInt32(static_cast<int32_t>(ua * ub));
+        case Instruction::SDiv:
+        case Instruction::SRem:
+            if (b == 0 || (a == INT32_MIN && b == -1)) {
+                return nullptr;
+            }
+            return context.getInt32(inst.opcode == Instruction::SDiv ? a / b : a % b);
+        default:
+            return nullptr;
+        }
+    }
+
+private:
+    // i1 true is -1 when compared signed.
+    static int32_t signedValue(const ConstantInt* constant) {
+        if (constant->type == Type::getInt1Ty()) {
+            return (constant->value & 1) ? -1 : 0;
+        }
+        return static_cast<int32_t>(constant->value);
+    }
+
+    static bool compare(ICmpInst::Predicate predicate, int32_t a, int32_t b) {
+        switch (predicate) {
+        case ICmpInst::EQ:
+            return a == b;
+        case ICmpInst::NE:
+            return a != b;
+        case ICmpInst::SGT:
+            return a > b;
+        case ICmpInst::SGE:
+            return a >= b;
+        case ICmpInst::SLT:
+            return a < b;
+        case ICmpInst::SLE:
+            return a <= b;
+        }
+        return false;
+    }
+};
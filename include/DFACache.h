@@ -0,0 +1,606 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "antlr4-runtime.h"
+
+// On-disk cache of the decision DFAs an ANTLR parser learns while predicting.
+//
+// ParserATNSimulator builds its DFA lazily: the first time a decision sees a
+// lookahead sequence it runs full ATN closure and records the result as DFA
+// states and edges. Those DFAs are static per grammar, so they survive across
+// parser instances but not across processes. DFACache saves them after a
+// parse and restores them into a fresh process before the next one, so later
+// compiles predict from a warm DFA.
+//
+// Everything that prediction reads is saved: each DFA state's ATN config set
+// (including the prediction context graph and semantic contexts, which
+// computeTargetState needs to extend the DFA), accept / full-context flags,
+// predicates and edges, plus each decision's start state or per-precedence
+// start states. The file records a fingerprint of the serialized ATN. A cache
+// written for a different grammar, or any malformed file, is ignored as a
+// whole, and the parser then simply starts cold.
+class DFACache {
+public:
+    // Restores cached DFAs into the parser's (shared, static) decision DFAs.
+    // Decisions that already have states in this process are left alone.
+    // Returns false if the file is missing, stale or malformed.
+    static bool load(antlr4::Parser& parser, const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        Reader reader(bytes);
+        Loader loader(parser);
+        return loader.run(reader);
+    }
+
+    // Writes all decision DFAs of the parser to `path` (via a temporary file
+    // and rename, so concurrent compiles never observe a partial cache).
+    static bool save(antlr4::Parser& parser, const std::string& path) {
+        Writer writer;
+        Saver saver(parser);
+        saver.run(writer);
+
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            out.write(writer.bytes.data(), static_cast<std::streamsize>(writer.bytes.size()));
+            if (!out) {
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    // Total number of DFA states currently known to the parser; comparing it
+    // before and after a parse tells whether saving would add anything.
+    static size_t stateCount(antlr4::Parser& parser) {
+        size_t n = 0;
+        for (const auto& dfa : decisionDFAs(parser)) {
+            n += dfa.states.size();
+        }
+        return n;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x46444653;   // "SFDF"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;   // null reference / EOF / ERROR state
+    static constexpr uint32_t EMPTY_RETURN = 0xFFFFFFFEu;
+
+    using PredictionContextRef = std::shared_ptr<const antlr4::atn::PredictionContext>;
+    using SemanticContextRef = std::shared_ptr<const antlr4::atn::SemanticContext>;
+
+    enum SemanticKind : uint32_t { SEM_NONE, SEM_PREDICATE, SEM_PRECEDENCE, SEM_AND, SEM_OR };
+
+    static std::vector<antlr4::dfa::DFA>& decisionDFAs(antlr4::Parser& parser) {
+        return parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->decisionToDFA;
+    }
+
+    // FNV-1a over the serialized ATN: identifies the grammar the DFA belongs to.
+    static uint64_t fingerprint(antlr4::Parser& parser) {
+        uint64_t hash = 1469598103934665603ull;
+        for (int32_t word : parser.getSerializedATN()) {
+            hash = (hash ^ static_cast<uint32_t>(word)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static uint32_t encodeSymbol(size_t symbol) {
+        return symbol == antlr4::Token::EOF ? NONE : static_cast<uint32_t>(symbol);
+    }
+    static size_t decodeSymbol(uint32_t symbol) {
+        return symbol == NONE ? antlr4::Token::EOF : symbol;
+    }
+
+    // --- Binary encoding ---
+
+    struct Writer {
+        std::vector<char> bytes;
+        void u32(uint32_t v) {
+            for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+        void u64(uint64_t v) {
+            u32(static_cast<uint32_t>(v));
+            u32(static_cast<uint32_t>(v >> 32));
+        }
+    };
+
+    struct Reader {
+        const std::vector<char>& bytes;
+        size_t pos = 0;
+        bool ok = true;
+        explicit Reader(const std::vector<char>& bytes) : bytes(bytes) {}
+        uint32_t u32() {
+            if (bytes.size() - pos < 4) {
+                ok = false;
+                pos = bytes.size();
+                return 0;
+            }
+            uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[pos + i])) << (8 * i);
+            pos += 4;
+            return v;
+        }
+        uint64_t u64() {
+            uint64_t lo = u32();
+            return lo | (static_cast<uint64_t>(u32()) << 32);
+        }
+        // Reads a count and checks it could possibly fit in the rest of the file.
+        uint32_t count(size_t minBytesPerItem) {
+            uint32_t n = u32();
+            if (ok && static_cast<uint64_t>(n) * minBytesPerItem > bytes.size() - pos) {
+                ok = false;
+            }
+            return ok ? n : 0;
+        }
+    };
+
+    // --- Saving ---
+
+    class Saver {
+    public:
+        explicit Saver(antlr4::Parser& parser) : parser(parser) {}
+
+        void run(Writer& w) {
+            auto& dfas = decisionDFAs(parser);
+
+            // Number states and intern every context referenced by them first,
+            // so that the tables can be written before the states.
+            for (auto& dfa : dfas) {
+                for (antlr4::dfa::DFAState* state : dfa.states) {
+                    stateIds[state] = static_cast<uint32_t>(stateIds.size());
+                    for (const auto& config : state->configs->configs) {
+                        internContext(config->context);
+                        internSemantic(config->semanticContext);
+                    }
+                    for (const auto& pred : state->predicates) {
+                        internSemantic(pred.pred);
+                    }
+                }
+            }
+
+            w.u32(MAGIC);
+            w.u32(VERSION);
+            w.u64(fingerprint(parser));
+
+            w.u32(static_cast<uint32_t>(contexts.size()));
+            for (const antlr4::atn::PredictionContext* ctx : contexts) {
+                w.u32(static_cast<uint32_t>(ctx->size()));
+                for (size_t i = 0; i < ctx->size(); ++i) {
+                    const PredictionContextRef& parent = ctx->getParent(i);
+                    w.u32(parent ? contextIds.at(parent.get()) : NONE);
+                    size_t returnState = ctx->getReturnState(i);
+                    w.u32(returnState == antlr4::atn::PredictionContext::EMPTY_RETURN_STATE
+                              ? EMPTY_RETURN : static_cast<uint32_t>(returnState));
+                }
+            }
+
+            w.u32(static_cast<uint32_t>(semantics.size()));
+            for (const antlr4::atn::SemanticContext* sem : semantics) {
+                writeSemantic(w, sem);
+            }
+
+            w.u32(static_cast<uint32_t>(dfas.size()));
+            for (auto& dfa : dfas) {
+                writeDFA(w, dfa);
+            }
+        }
+
+    private:
+        antlr4::Parser& parser;
+        std::unordered_map<const antlr4::dfa::DFAState*, uint32_t> stateIds;
+        std::unordered_map<const antlr4::atn::PredictionContext*, uint32_t> contextIds;
+        std::vector<const antlr4::atn::PredictionContext*> contexts; // parents before children
+        std::unordered_map<const antlr4::atn::SemanticContext*, uint32_t> semanticIds;
+        std::vector<const antlr4::atn::SemanticContext*> semantics;  // operands before operators
+
+        void internContext(const PredictionContextRef& ctx) {
+            if (!ctx || contextIds.count(ctx.get())) {
+                return;
+            }
+            for (size_t i = 0; i < ctx->size(); ++i) {
+                internContext(ctx->getParent(i));
+            }
+            contextIds[ctx.get()] = static_cast<uint32_t>(contexts.size());
+            contexts.push_back(ctx.get());
+        }
+
+        void internSemantic(const SemanticContextRef& sem) {
+            if (!sem || semanticIds.count(sem.get())) {
+                return;
+            }
+            if (antlr4::atn::SemanticContext::Operator::is(sem.get())) {
+                auto* op = static_cast<const antlr4::atn::SemanticContext::Operator*>(sem.get());
+                for (const auto& operand : op->getOperands()) {
+                    internSemantic(operand);
+                }
+            }
+            semanticIds[sem.get()] = static_cast<uint32_t>(semantics.size());
+            semantics.push_back(sem.get());
+        }
+
+        void writeSemantic(Writer& w, const antlr4::atn::SemanticContext* sem) {
+            using antlr4::atn::SemanticContext;
+            switch (sem->getContextType()) {
+            case antlr4::atn::SemanticContextType::PREDICATE: {
+                auto* pred = static_cast<const SemanticContext::Predicate*>(sem);
+                w.u32(SEM_PREDICATE);
+                w.u32(static_cast<uint32_t>(pred->ruleIndex));
+                w.u32(static_cast<uint32_t>(pred->predIndex));
+                w.u32(pred->isCtxDependent ? 1 : 0);
+                break;
+            }
+            case antlr4::atn::SemanticContextType::PRECEDENCE:
+                w.u32(SEM_PRECEDENCE);
+                w.u32(static_cast<uint32_t>(static_cast<const SemanticContext::PrecedencePredicate*>(sem)->precedence));
+                break;
+            case antlr4::atn::SemanticContextType::AND:
+            case antlr4::atn::SemanticContextType::OR: {
+                auto* op = static_cast<const SemanticContext::Operator*>(sem);
+                w.u32(sem->getContextType() == antlr4::atn::SemanticContextType::AND ? SEM_AND : SEM_OR);
+                w.u32(static_cast<uint32_t>(op->getOperands().size()));
+                for (const auto& operand : op->getOperands()) {
+                    w.u32(semanticIds.at(operand.get()));
+                }
+                break;
+            }
+            default:
+                w.u32(SEM_NONE);
+                break;
+            }
+        }
+
+        uint32_t stateRef(const antlr4::dfa::DFAState* state) const {
+            auto it = stateIds.find(state);
+            return it == stateIds.end() ? NONE : it->second; // ERROR has no id
+        }
+
+        void writeDFA(Writer& w, antlr4::dfa::DFA& dfa) {
+            w.u32(static_cast<uint32_t>(dfa.states.size()));
+            for (antlr4::dfa::DFAState* state : dfa.states) {
+                const antlr4::atn::ATNConfigSet& configs = *state->configs;
+                w.u32(stateIds.at(state));
+                w.u32((state->isAcceptState ? 1u : 0u) | (state->requiresFullContext ? 2u : 0u) |
+                      (configs.fullCtx ? 4u : 0u) | (configs.hasSemanticContext ? 8u : 0u) |
+                      (configs.dipsIntoOuterContext ? 16u : 0u));
+                w.u32(static_cast<uint32_t>(state->prediction));
+                w.u32(static_cast<uint32_t>(configs.uniqueAlt));
+
+                std::vector<uint32_t> conflicting;
+                for (size_t alt = configs.conflictingAlts.nextSetBit(0); alt != INVALID_INDEX;
+                     alt = configs.conflictingAlts.nextSetBit(alt + 1)) {
+                    conflicting.push_back(static_cast<uint32_t>(alt));
+                }
+                w.u32(static_cast<uint32_t>(conflicting.size()));
+                for (uint32_t alt : conflicting) {
+                    w.u32(alt);
+                }
+
+                w.u32(static_cast<uint32_t>(configs.configs.size()));
+                for (const auto& config : configs.configs) {
+                    w.u32(static_cast<uint32_t>(config->state->stateNumber));
+                    w.u32(static_cast<uint32_t>(config->alt));
+                    w.u32(contextIds.at(config->context.get()));
+                    w.u32(semanticIds.at(config->semanticContext.get()));
+                    w.u64(config->reachesIntoOuterContext);
+                }
+
+                w.u32(static_cast<uint32_t>(state->predicates.size()));
+                for (const auto& pred : state->predicates) {
+                    w.u32(semanticIds.at(pred.pred.get()));
+                    w.u32(static_cast<uint32_t>(pred.alt));
+                }
+
+                w.u32(static_cast<uint32_t>(state->edges.size()));
+                for (const auto& [symbol, target] : state->edges) {
+                    w.u32(encodeSymbol(symbol));
+                    w.u32(stateRef(target));
+                }
+            }
+
+            // Start states: s0 for ordinary decisions, one per precedence
+            // level (the edges of the synthetic s0) for precedence decisions.
+            if (dfa.isPrecedenceDfa()) {
+                w.u32(static_cast<uint32_t>(dfa.s0->edges.size()));
+                for (const auto& [precedence, start] : dfa.s0->edges) {
+                    w.u32(static_cast<uint32_t>(precedence));
+                    w.u32(stateRef(start));
+                }
+            } else {
+                w.u32(dfa.s0 ? 1 : 0);
+                if (dfa.s0) {
+                    w.u32(0);
+                    w.u32(stateRef(dfa.s0));
+                }
+            }
+        }
+    };
+
+    // --- Loading ---
+
+    class Loader {
+    public:
+        explicit Loader(antlr4::Parser& parser) : parser(parser), atn(parser.getATN()) {}
+
+        ~Loader() {
+            // States that were not handed over to a DFA (failed load).
+            for (antlr4::dfa::DFAState* state : pending) {
+                delete state;
+            }
+        }
+
+        bool run(Reader& r) {
+            if (r.u32() != MAGIC || r.u32() != VERSION || r.u64() != fingerprint(parser) || !r.ok) {
+                return false;
+            }
+            if (!readContexts(r) || !readSemantics(r)) {
+                return false;
+            }
+
+            auto& dfas = decisionDFAs(parser);
+            uint32_t numDecisions = r.u32();
+            if (!r.ok || numDecisions != dfas.size()) {
+                return false;
+            }
+
+            // Pass 1: materialize every state; edges refer to global ids, so
+            // they are resolved only once all states exist.
+            struct Pending {
+                std::vector<std::pair<uint32_t, uint32_t>> edges; // (symbol, target id)
+            };
+            std::vector<std::vector<std::pair<uint32_t, Pending>>> perDecision(numDecisions);
+            std::vector<std::vector<std::pair<uint32_t, uint32_t>>> starts(numDecisions);
+            for (uint32_t d = 0; d < numDecisions; ++d) {
+                uint32_t numStates = r.count(40);
+                for (uint32_t i = 0; i < numStates; ++i) {
+                    Pending p;
+                    uint32_t id = 0;
+                    if (!readState(r, id, p.edges)) {
+                        return false;
+                    }
+                    perDecision[d].emplace_back(id, std::move(p));
+                }
+                uint32_t numStarts = r.count(8);
+                for (uint32_t i = 0; i < numStarts; ++i) {
+                    uint32_t key = r.u32();
+                    uint32_t id = r.u32();
+                    starts[d].emplace_back(key, id);
+                }
+                if (!r.ok) {
+                    return false;
+                }
+            }
+
+            // Pass 2: resolve edges and start states, then validate before
+            // anything is installed.
+            for (uint32_t d = 0; d < numDecisions; ++d) {
+                for (auto& [id, p] : perDecision[d]) {
+                    for (auto [symbol, target] : p.edges) {
+                        antlr4::dfa::DFAState* to = resolve(target);
+                        if (!to) {
+                            return false;
+                        }
+                        byId[id]->edges[decodeSymbol(symbol)] = to;
+                    }
+                }
+                for (auto [key, id] : starts[d]) {
+                    if (id == NONE || !byId.count(id)) {
+                        return false;
+                    }
+                }
+                if (!dfas[d].isPrecedenceDfa() && starts[d].size() > 1) {
+                    return false;
+                }
+                // Every state must be distinct under DFAState equality, or the
+                // DFA would reject it and leave edges pointing at a stray copy.
+                std::unordered_set<antlr4::dfa::DFAState*, StateHasher, StateEquals> unique;
+                for (auto& entry : perDecision[d]) {
+                    if (!unique.insert(byId[entry.first]).second) {
+                        return false;
+                    }
+                }
+            }
+
+            // Pass 3: install into decisions that are still cold.
+            for (uint32_t d = 0; d < numDecisions; ++d) {
+                antlr4::dfa::DFA& dfa = dfas[d];
+                bool install = dfa.states.empty() && (!dfa.isPrecedenceDfa() || dfa.s0->edges.empty());
+                if (!install) {
+                    continue;
+                }
+                for (auto& entry : perDecision[d]) {
+                    antlr4::dfa::DFAState* state = byId[entry.first];
+                    state->stateNumber = static_cast<int>(dfa.states.size());
+                    dfa.states.insert(state);
+                    pending.erase(state);
+                }
+                for (auto [key, id] : starts[d]) {
+                    if (dfa.isPrecedenceDfa()) {
+                        dfa.setPrecedenceStartState(static_cast<int>(key), byId[id]);
+                    } else {
+                        dfa.s0 = byId[id];
+                    }
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct StateHasher {
+            size_t operator()(const antlr4::dfa::DFAState* state) const { return state->hashCode(); }
+        };
+        struct StateEquals {
+            bool operator()(const antlr4::dfa::DFAState* a, const antlr4::dfa::DFAState* b) const { return *a == *b; }
+        };
+
+        antlr4::Parser& parser;
+        const antlr4::atn::ATN& atn;
+        std::vector<PredictionContextRef> contexts;
+        std::vector<SemanticContextRef> semantics;
+        std::unordered_map<uint32_t, antlr4::dfa::DFAState*> byId;
+        std::unordered_set<antlr4::dfa::DFAState*> pending; // owned until installed
+
+        antlr4::dfa::DFAState* resolve(uint32_t id) {
+            if (id == NONE) {
+                return antlr4::atn::ATNSimulator::ERROR.get();
+            }
+            auto it = byId.find(id);
+            return it == byId.end() ? nullptr : it->second;
+        }
+
+        bool readContexts(Reader& r) {
+            uint32_t n = r.count(4);
+            contexts.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                uint32_t size = r.count(8);
+                if (!r.ok || size == 0) {
+                    return false;
+                }
+                std::vector<PredictionContextRef> parents;
+                std::vector<size_t> returnStates;
+                for (uint32_t k = 0; k < size; ++k) {
+                    uint32_t parent = r.u32();
+                    uint32_t returnState = r.u32();
+                    if (parent != NONE && parent >= contexts.size()) {
+                        return false;
+                    }
+                    parents.push_back(parent == NONE ? nullptr : contexts[parent]);
+                    returnStates.push_back(returnState == EMPTY_RETURN
+                                               ? antlr4::atn::PredictionContext::EMPTY_RETURN_STATE : returnState);
+                }
+                if (size == 1) {
+                    contexts.push_back(antlr4::atn::SingletonPredictionContext::create(parents[0], returnStates[0]));
+                } else {
+                    contexts.push_back(std::make_shared<antlr4::atn::ArrayPredictionContext>(
+                        std::move(parents), std::move(returnStates)));
+                }
+            }
+            return r.ok;
+        }
+
+        bool readSemantics(Reader& r) {
+            using antlr4::atn::SemanticContext;
+            uint32_t n = r.count(4);
+            semantics.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                uint32_t kind = r.u32();
+                switch (kind) {
+                case SEM_NONE:
+                    semantics.push_back(SemanticContext::Empty::Instance);
+                    break;
+                case SEM_PREDICATE: {
+                    uint32_t rule = r.u32();
+                    uint32_t pred = r.u32();
+                    bool ctxDependent = r.u32() != 0;
+                    semantics.push_back(std::make_shared<SemanticContext::Predicate>(rule, pred, ctxDependent));
+                    break;
+                }
+                case SEM_PRECEDENCE:
+                    semantics.push_back(std::make_shared<SemanticContext::PrecedencePredicate>(static_cast<int>(r.u32())));
+                    break;
+                case SEM_AND:
+                case SEM_OR: {
+                    bool isAnd = kind == SEM_AND;
+                    uint32_t operands = r.count(4);
+                    SemanticContextRef result;
+                    for (uint32_t k = 0; k < operands; ++k) {
+                        uint32_t id = r.u32();
+                        if (id >= semantics.size()) {
+                            return false;
+                        }
+                        result = !result ? semantics[id]
+                               : isAnd ? SemanticContext::And(result, semantics[id])
+                                       : SemanticContext::Or(result, semantics[id]);
+                    }
+                    if (!result) {
+                        return false;
+                    }
+                    semantics.push_back(result);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            return r.ok;
+        }
+
+        bool readState(Reader& r, uint32_t& id, std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+            id = r.u32();
+            uint32_t flags = r.u32();
+            uint32_t prediction = r.u32();
+            uint32_t uniqueAlt = r.u32();
+            if (!r.ok || id == NONE || byId.count(id)) {
+                return false;
+            }
+
+            auto configs = std::make_unique<antlr4::atn::ATNConfigSet>((flags & 4u) != 0);
+            configs->uniqueAlt = uniqueAlt;
+            uint32_t numConflicting = r.count(4);
+            for (uint32_t k = 0; k < numConflicting; ++k) {
+                uint32_t alt = r.u32();
+                if (alt >= configs->conflictingAlts.size()) {
+                    return false;
+                }
+                configs->conflictingAlts.set(alt);
+            }
+
+            uint32_t numConfigs = r.count(24);
+            for (uint32_t k = 0; k < numConfigs; ++k) {
+                uint32_t stateNumber = r.u32();
+                uint32_t alt = r.u32();
+                uint32_t ctx = r.u32();
+                uint32_t sem = r.u32();
+                uint64_t reaches = r.u64();
+                if (!r.ok || stateNumber >= atn.states.size() || ctx >= contexts.size() || sem >= semantics.size()) {
+                    return false;
+                }
+                auto config = std::make_shared<antlr4::atn::ATNConfig>(atn.states[stateNumber], alt, contexts[ctx],
+                                                                      semantics[sem]);
+                config->reachesIntoOuterContext = static_cast<size_t>(reaches);
+                configs->add(config);
+            }
+            configs->hasSemanticContext = (flags & 8u) != 0;
+            configs->dipsIntoOuterContext = (flags & 16u) != 0;
+            configs->setReadonly(true);
+
+            auto* state = new antlr4::dfa::DFAState(std::move(configs));
+            pending.insert(state);
+            byId[id] = state;
+            state->isAcceptState = (flags & 1u) != 0;
+            state->requiresFullContext = (flags & 2u) != 0;
+            state->prediction = prediction;
+
+            uint32_t numPredicates = r.count(8);
+            for (uint32_t k = 0; k < numPredicates; ++k) {
+                uint32_t sem = r.u32();
+                uint32_t alt = r.u32();
+                if (sem >= semantics.size()) {
+                    return false;
+                }
+                state->predicates.emplace_back(semantics[sem], static_cast<int>(alt));
+            }
+
+            uint32_t numEdges = r.count(8);
+            for (uint32_t k = 0; k < numEdges; ++k) {
+                uint32_t symbol = r.u32();
+                uint32_t target = r.u32();
+                edges.emplace_back(symbol, target);
+            }
+            return r.ok;
+        }
+    };
+};
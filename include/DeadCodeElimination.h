@@ -0,0 +1,35 @@
+#pragma once
+
+#include "IR.h"
+
+// Erases instructions whose result is unused and that have no other effect:
+// everything but store and ret. Each block is swept back to front, so an
+// instruction is visited after its users in the block and goes in the same
+// sweep once they are gone; sweeps repeat until one erases nothing, which
+// catches values used in a later block.
+class DeadCodeElimination {
+public:
+    // Returns the number of instructions erased.
+    static size_t run(Function& func) {
+        size_t erased = 0;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (auto block = func.blockList.end(); block != func.blockList.begin();) {
+                --block;
+                for (auto it = block->instList.end(); it != block->instList.begin();) {
+                    --it;
+                    if (isTriviallyDead(*it)) {
+                        it = block->instList.erase(it);
+                        ++erased;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return erased;
+    }
+
+    static bool isTriviallyDead(const Instruction& inst) {
+        return !inst.hasUses() && inst.opcode != Instruction::Store && inst.opcode != Instruction::Ret;
+    }
+};
@@ -0,0 +1,706 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <vector>
+
+// ANTLR Generated Headers: the parser builds SysYParser's context classes
+#include "antlr4-runtime.h"
+#include "SysYParser.h"
+
+// Hand-written recursive-descent parser for SysY.
+//
+// Produces exactly the parse tree SysYParser would (same *Context classes,
+// same children order, same start/stop tokens), so IRGenerator can consume
+// either. `exp` is parsed by precedence climbing instead of ANTLR's
+// left-recursion rewrite with precedence predicates; the binary levels and
+// their left associativity follow the alternative order in SysYParser.g4.
+// Expressions are parsed on an explicit work stack rather than by recursion,
+// so arbitrarily deep expressions cannot overflow the native stack.
+//
+// The parser does not recover from syntax errors: it gives up at the first
+// unexpected token (compUnit() returns nullptr) so the caller can re-parse
+// with SysYParser for full diagnostics and recovery. Nodes are owned by the
+// DescentParser and live until it is destroyed, except in the streaming
+// compUnit(sink), which frees each top-level item once it has been handled.
+class DescentParser {
+public:
+    explicit DescentParser(antlr4::TokenStream* input) : input(input) {
+        cur = input->LT(1);
+        curType = cur->getType();
+    }
+
+    DescentParser(const DescentParser&) = delete;
+    DescentParser& operator=(const DescentParser&) = delete;
+
+    ~DescentParser() { tracker.reset(); }
+
+    // compUnit: (decl | funcDef)* EOF
+    SysYParser::CompUnitContext* compUnit() {
+        try {
+            auto* ctx = create<SysYParser::CompUnitContext>(nullptr);
+            while (curType != antlr4::Token::EOF) {
+                ctx->addChild(topLevel(ctx));
+            }
+            terminal(ctx, antlr4::Token::EOF);
+            return finish(ctx);
+        } catch (const SyntaxError&) {
+            return nullptr;
+        }
+    }
+
+    // Streaming form of compUnit(): each top-level decl / funcDef is passed
+    // to sink(ParserRuleContext*) as soon as it is parsed, under a throw-away
+    // CompUnitContext parent, and every node is freed when the sink returns.
+    // The sink may release the tokens consumed so far (LT(1) is re-read
+    // afterwards). Returns false at the first syntax error; items before it
+    // have already been passed to the sink.
+    template <typename Sink>
+    bool compUnit(Sink&& sink) {
+        try {
+            while (curType != antlr4::Token::EOF) {
+                auto* root = create<SysYParser::CompUnitContext>(nullptr);
+                antlr4::ParserRuleContext* item = topLevel(root);
+                root->addChild(item);
+                sink(item);
+                tracker.reset();
+                last = nullptr;
+                cur = input->LT(1);
+                curType = cur->getType();
+            }
+            return true;
+        } catch (const SyntaxError&) {
+            return false;
+        }
+    }
+
+    // Parses the top-level items from LT(1) up to token index `stop`, for
+    // ParallelParser: they are appended to `items` under a throw-away
+    // CompUnitContext parent and stay owned by this parser. Returns false at a
+    // syntax error, or if the last item does not end just before `stop`.
+    bool topLevelItems(size_t stop, std::vector<antlr4::ParserRuleContext*>& items) {
+        try {
+            auto* root = create<SysYParser::CompUnitContext>(nullptr);
+            while (curType != antlr4::Token::EOF && cur->getTokenIndex() < stop) {
+                items.push_back(topLevel(root));
+            }
+            return cur->getTokenIndex() == stop;
+        } catch (const SyntaxError&) {
+            return false;
+        }
+    }
+
+    // compUnit() over items parsed by topLevelItems(), possibly by other
+    // DescentParsers, which must outlive the tree. LT(1) must be the first
+    // token; the items must cover every token up to EOF.
+    SysYParser::CompUnitContext* compUnitFrom(const std::vector<antlr4::ParserRuleContext*>& items) {
+        try {
+            auto* ctx = create<SysYParser::CompUnitContext>(nullptr);
+            for (antlr4::ParserRuleContext* item : items) {
+                item->parent = ctx;
+                ctx->addChild(item);
+            }
+            input->seek(input->size() - 1);
+            cur = input->LT(1);
+            curType = cur->getType();
+            terminal(ctx, antlr4::Token::EOF);
+            return finish(ctx);
+        } catch (const SyntaxError&) {
+            return nullptr;
+        }
+    }
+
+private:
+    struct SyntaxError : std::exception {};
+
+    antlr4::TokenStream* input;
+    antlr4::Token* cur;   // LT(1)
+    size_t curType;       // LT(1)->getType()
+    antlr4::Token* last = nullptr; // LT(-1), the stop token of a finished rule
+    antlr4::tree::ParseTreeTracker tracker;
+
+    // Labeled alternatives (ExpContext / StmtContext subclasses) are built
+    // from a prototype via copyFrom(); reusing one avoids allocating a
+    // throw-away base context per node.
+    SysYParser::ExpContext expProto;
+    SysYParser::StmtContext stmtProto;
+
+    size_t LA(ssize_t k) { return input->LA(k); }
+
+    void consume() {
+        last = cur;
+        if (curType == antlr4::Token::EOF) {
+            return; // as in antlr4::Parser::consume, EOF is matched but never consumed
+        }
+        input->consume();
+        cur = input->LT(1);
+        curType = cur->getType();
+    }
+
+    [[noreturn]] void fail() { throw SyntaxError(); }
+
+    antlr4::ParserRuleContext* topLevel(SysYParser::CompUnitContext* parent) {
+        if (curType == SysYParser::VOID ||
+            (curType == SysYParser::INT && LA(2) == SysYParser::IDENT && LA(3) == SysYParser::L_PAREN)) {
+            return funcDef(parent);
+        }
+        return decl(parent);
+    }
+
+    template <typename T>
+    T* create(antlr4::ParserRuleContext* parent) {
+        T* ctx = tracker.createInstance<T>(parent, 0);
+        ctx->start = cur;
+        return ctx;
+    }
+
+    template <typename T>
+    T* createExp(antlr4::ParserRuleContext* parent) {
+        expProto.parent = parent;
+        expProto.start = cur;
+        return tracker.createInstance<T>(&expProto);
+    }
+
+    template <typename T>
+    T* createStmt(antlr4::ParserRuleContext* parent) {
+        stmtProto.parent = parent;
+        stmtProto.start = cur;
+        return tracker.createInstance<T>(&stmtProto);
+    }
+
+    template <typename T>
+    T* finish(T* ctx) {
+        ctx->stop = last;
+        return ctx;
+    }
+
+    // Matches the current token against `type` and attaches it to ctx.
+    void terminal(antlr4::ParserRuleContext* ctx, size_t type) {
+        if (curType != type) {
+            fail();
+        }
+        ctx->addChild(tracker.createInstance<antlr4::tree::TerminalNodeImpl>(cur));
+        consume();
+    }
+
+    // Attaches the current token if it has the given type.
+    bool optional(antlr4::ParserRuleContext* ctx, size_t type) {
+        if (curType != type) {
+            return false;
+        }
+        terminal(ctx, type);
+        return true;
+    }
+
+    // --- Declarations ---
+
+    // decl: constDecl | varDecl
+    SysYParser::DeclContext* decl(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::DeclContext>(parent);
+        if (curType == SysYParser::CONST) {
+            ctx->addChild(constDecl(ctx));
+        } else {
+            ctx->addChild(varDecl(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // constDecl: CONST bType constDef (COMMA constDef)* SEMICOLON
+    SysYParser::ConstDeclContext* constDecl(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::ConstDeclContext>(parent);
+        terminal(ctx, SysYParser::CONST);
+        ctx->addChild(bType(ctx));
+        ctx->addChild(constDef(ctx));
+        while (optional(ctx, SysYParser::COMMA)) {
+            ctx->addChild(constDef(ctx));
+        }
+        terminal(ctx, SysYParser::SEMICOLON);
+        return finish(ctx);
+    }
+
+    // bType: INT
+    SysYParser::BTypeContext* bType(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::BTypeContext>(parent);
+        terminal(ctx, SysYParser::INT);
+        return finish(ctx);
+    }
+
+    // constDef: IDENT (L_BRACK constExp R_BRACK)* ASSIGN constInitVal
+    SysYParser::ConstDefContext* constDef(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::ConstDefContext>(parent);
+        terminal(ctx, SysYParser::IDENT);
+        while (optional(ctx, SysYParser::L_BRACK)) {
+            ctx->addChild(constExp(ctx));
+            terminal(ctx, SysYParser::R_BRACK);
+        }
+        terminal(ctx, SysYParser::ASSIGN);
+        ctx->addChild(constInitVal(ctx));
+        return finish(ctx);
+    }
+
+    // constInitVal: constExp | L_BRACE (constInitVal (COMMA constInitVal)*)? R_BRACE
+    SysYParser::ConstInitValContext* constInitVal(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::ConstInitValContext>(parent);
+        if (optional(ctx, SysYParser::L_BRACE)) {
+            if (curType != SysYParser::R_BRACE) {
+                ctx->addChild(constInitVal(ctx));
+                while (optional(ctx, SysYParser::COMMA)) {
+                    ctx->addChild(constInitVal(ctx));
+                }
+            }
+            terminal(ctx, SysYParser::R_BRACE);
+        } else {
+            ctx->addChild(constExp(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // varDecl: bType varDef (COMMA varDef)* SEMICOLON
+    SysYParser::VarDeclContext* varDecl(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::VarDeclContext>(parent);
+        ctx->addChild(bType(ctx));
+        ctx->addChild(varDef(ctx));
+        while (optional(ctx, SysYParser::COMMA)) {
+            ctx->addChild(varDef(ctx));
+        }
+        terminal(ctx, SysYParser::SEMICOLON);
+        return finish(ctx);
+    }
+
+    // varDef: IDENT (L_BRACK constExp R_BRACK)* (ASSIGN initVal)?
+    SysYParser::VarDefContext* varDef(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::VarDefContext>(parent);
+        terminal(ctx, SysYParser::IDENT);
+        while (optional(ctx, SysYParser::L_BRACK)) {
+            ctx->addChild(constExp(ctx));
+            terminal(ctx, SysYParser::R_BRACK);
+        }
+        if (optional(ctx, SysYParser::ASSIGN)) {
+            ctx->addChild(initVal(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // initVal: exp | L_BRACE (initVal (COMMA initVal)*)? R_BRACE
+    SysYParser::InitValContext* initVal(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::InitValContext>(parent);
+        if (optional(ctx, SysYParser::L_BRACE)) {
+            if (curType != SysYParser::R_BRACE) {
+                ctx->addChild(initVal(ctx));
+                while (optional(ctx, SysYParser::COMMA)) {
+                    ctx->addChild(initVal(ctx));
+                }
+            }
+            terminal(ctx, SysYParser::R_BRACE);
+        } else {
+            ctx->addChild(exp(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // --- Functions ---
+
+    // funcDef: funcType IDENT L_PAREN funcFParams? R_PAREN block
+    SysYParser::FuncDefContext* funcDef(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::FuncDefContext>(parent);
+        ctx->addChild(funcType(ctx));
+        terminal(ctx, SysYParser::IDENT);
+        terminal(ctx, SysYParser::L_PAREN);
+        if (curType == SysYParser::INT) {
+            ctx->addChild(funcFParams(ctx));
+        }
+        terminal(ctx, SysYParser::R_PAREN);
+        ctx->addChild(block(ctx));
+        return finish(ctx);
+    }
+
+    // funcType: VOID | INT
+    SysYParser::FuncTypeContext* funcType(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::FuncTypeContext>(parent);
+        terminal(ctx, curType == SysYParser::VOID ? SysYParser::VOID : SysYParser::INT);
+        return finish(ctx);
+    }
+
+    // funcFParams: funcFParam (COMMA funcFParam)*
+    SysYParser::FuncFParamsContext* funcFParams(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::FuncFParamsContext>(parent);
+        ctx->addChild(funcFParam(ctx));
+        while (optional(ctx, SysYParser::COMMA)) {
+            ctx->addChild(funcFParam(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // funcFParam: bType IDENT (L_BRACK R_BRACK (L_BRACK exp R_BRACK)*)?
+    SysYParser::FuncFParamContext* funcFParam(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::FuncFParamContext>(parent);
+        ctx->addChild(bType(ctx));
+        terminal(ctx, SysYParser::IDENT);
+        if (optional(ctx, SysYParser::L_BRACK)) {
+            terminal(ctx, SysYParser::R_BRACK);
+            while (optional(ctx, SysYParser::L_BRACK)) {
+                ctx->addChild(exp(ctx));
+                terminal(ctx, SysYParser::R_BRACK);
+            }
+        }
+        return finish(ctx);
+    }
+
+    // --- Statements ---
+
+    // block: L_BRACE blockItem* R_BRACE
+    SysYParser::BlockContext* block(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::BlockContext>(parent);
+        terminal(ctx, SysYParser::L_BRACE);
+        while (curType != SysYParser::R_BRACE) {
+            ctx->addChild(blockItem(ctx));
+        }
+        terminal(ctx, SysYParser::R_BRACE);
+        return finish(ctx);
+    }
+
+    // blockItem: decl | stmt
+    SysYParser::BlockItemContext* blockItem(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::BlockItemContext>(parent);
+        if (curType == SysYParser::CONST || curType == SysYParser::INT) {
+            ctx->addChild(decl(ctx));
+        } else {
+            ctx->addChild(stmt(ctx));
+        }
+        return finish(ctx);
+    }
+
+    // True if the statement at LT(1) is `lVal ASSIGN ...`: an IDENT, any
+    // number of bracketed index groups, then '='.
+    bool startsAssignment() {
+        if (curType != SysYParser::IDENT) {
+            return false;
+        }
+        ssize_t k = 2;
+        size_t depth = 0;
+        for (;; ++k) {
+            size_t t = LA(k);
+            if (t == SysYParser::L_BRACK) {
+                ++depth;
+            } else if (t == SysYParser::R_BRACK) {
+                if (depth == 0) {
+                    return false;
+                }
+                --depth;
+            } else if (depth == 0) {
+                return t == SysYParser::ASSIGN;
+            } else if (t == antlr4::Token::EOF || t == SysYParser::SEMICOLON) {
+                return false;
+            }
+        }
+    }
+
+    SysYParser::StmtContext* stmt(antlr4::ParserRuleContext* parent) {
+        switch (curType) {
+        case SysYParser::L_BRACE: {
+            // block  # blockStmt
+            auto* ctx = createStmt<SysYParser::BlockStmtContext>(parent);
+            ctx->addChild(block(ctx));
+            return finish(ctx);
+        }
+        case SysYParser::IF: {
+            // IF L_PAREN cond R_PAREN stmt (ELSE stmt)?  # ifStmt
+            auto* ctx = createStmt<SysYParser::IfStmtContext>(parent);
+            terminal(ctx, SysYParser::IF);
+            terminal(ctx, SysYParser::L_PAREN);
+            ctx->addChild(cond(ctx));
+            terminal(ctx, SysYParser::R_PAREN);
+            ctx->addChild(stmt(ctx));
+            if (optional(ctx, SysYParser::ELSE)) {
+                ctx->addChild(stmt(ctx));
+            }
+            return finish(ctx);
+        }
+        case SysYParser::WHILE: {
+            // WHILE L_PAREN cond R_PAREN stmt  # whileStmt
+            auto* ctx = createStmt<SysYParser::WhileStmtContext>(parent);
+            terminal(ctx, SysYParser::WHILE);
+            terminal(ctx, SysYParser::L_PAREN);
+            ctx->addChild(cond(ctx));
+            terminal(ctx, SysYParser::R_PAREN);
+            ctx->addChild(stmt(ctx));
+            return finish(ctx);
+        }
+        case SysYParser::BREAK: {
+            auto* ctx = createStmt<SysYParser::BreakStmtContext>(parent);
+            terminal(ctx, SysYParser::BREAK);
+            terminal(ctx, SysYParser::SEMICOLON);
+            return finish(ctx);
+        }
+        case SysYParser::CONTINUE: {
+            auto* ctx = createStmt<SysYParser::ContinueStmtContext>(parent);
+            terminal(ctx, SysYParser::CONTINUE);
+            terminal(ctx, SysYParser::SEMICOLON);
+            return finish(ctx);
+        }
+        case SysYParser::RETURN: {
+            // RETURN exp? SEMICOLON  # returnStmt
+            auto* ctx = createStmt<SysYParser::ReturnStmtContext>(parent);
+            terminal(ctx, SysYParser::RETURN);
+            if (curType != SysYParser::SEMICOLON) {
+                ctx->addChild(exp(ctx));
+            }
+            terminal(ctx, SysYParser::SEMICOLON);
+            return finish(ctx);
+        }
+        default:
+            break;
+        }
+
+        if (startsAssignment()) {
+            // lVal ASSIGN exp SEMICOLON  # assignStmt
+            auto* ctx = createStmt<SysYParser::AssignStmtContext>(parent);
+            ctx->addChild(lVal(ctx));
+            terminal(ctx, SysYParser::ASSIGN);
+            ctx->addChild(exp(ctx));
+            terminal(ctx, SysYParser::SEMICOLON);
+            return finish(ctx);
+        }
+
+        // exp? SEMICOLON  # expStmt
+        auto* ctx = createStmt<SysYParser::ExpStmtContext>(parent);
+        if (curType != SysYParser::SEMICOLON) {
+            ctx->addChild(exp(ctx));
+        }
+        terminal(ctx, SysYParser::SEMICOLON);
+        return finish(ctx);
+    }
+
+    // --- Expressions ---
+
+    // Binary precedence of a token, as assigned by ANTLR to the left-recursive
+    // alternatives of `exp` (higher binds tighter); 0 if not a binary operator.
+    static int binaryPrecedence(size_t type) {
+        switch (type) {
+        case SysYParser::MUL: case SysYParser::DIV: case SysYParser::MOD: return 6;
+        case SysYParser::PLUS: case SysYParser::MINUS: return 5;
+        case SysYParser::LT: case SysYParser::GT: case SysYParser::LE: case SysYParser::GE: return 4;
+        case SysYParser::EQ: case SysYParser::NEQ: return 3;
+        case SysYParser::AND: return 2;
+        case SysYParser::OR: return 1;
+        default: return 0;
+        }
+    }
+
+    // Creates the labeled context for a binary operator at precedence `prec`.
+    SysYParser::ExpContext* createBinary(int prec, antlr4::ParserRuleContext* parent) {
+        switch (prec) {
+        case 6: return createExp<SysYParser::MulDivModExpContext>(parent);
+        case 5: return createExp<SysYParser::AddSubExpContext>(parent);
+        case 4: return createExp<SysYParser::RelExpContext>(parent);
+        case 3: return createExp<SysYParser::EqNeqExpContext>(parent);
+        case 2: return createExp<SysYParser::LandExpContext>(parent);
+        default: return createExp<SysYParser::LorExpContext>(parent);
+        }
+    }
+
+    // An entry on the expression work stack: a node still waiting for
+    // sub-expressions, or the start of a nested `exp` (Sub).
+    struct ExpFrame {
+        enum Kind {
+            Sub,    // ctx: parent of the exp being parsed
+            Binary, // ctx: exp op . ; awaits its right operand
+            Unary,  // ctx: (PLUS | MINUS | NOT) . ; awaits its operand
+            Paren,  // ctx: L_PAREN . R_PAREN
+            Args,   // ctx: funcRParams of `call`; awaits the next argument
+            Index,  // ctx: lVal of `lValExp`; awaits the index before R_BRACK
+        } kind;
+        antlr4::ParserRuleContext* ctx;
+        int prec;                       // Binary
+        antlr4::ParserRuleContext* outer; // Args: the funcCallExp; Index: the lValExp
+    };
+    std::vector<ExpFrame> expStack;
+
+    // exp, parsed without native recursion: nested expressions (operands,
+    // parentheses, call arguments, array indices) are frames on expStack,
+    // so nesting depth is bounded by memory, not by the thread's stack.
+    // Binary operators are resolved by precedence climbing: a pending Binary
+    // frame is completed once the next operator binds no tighter than it,
+    // which gives ANTLR's left associativity. The tree is built exactly as
+    // the recursive version built it, including start/stop tokens and the
+    // re-parenting of left operands.
+    SysYParser::ExpContext* exp(antlr4::ParserRuleContext* parent) {
+        expStack.clear(); // not re-entered; left over only after a SyntaxError
+        expStack.push_back({ExpFrame::Sub, parent, 0, nullptr});
+        SysYParser::ExpContext* operand = nullptr;
+        for (;;) {
+            if (!operand) {
+                operand = primary(expStack.back().ctx);
+                if (!operand) {
+                    continue; // a frame was pushed; parse its operand first
+                }
+            }
+            ExpFrame& top = expStack.back();
+            if (top.kind == ExpFrame::Unary) {
+                top.ctx->addChild(operand);
+                operand = static_cast<SysYParser::ExpContext*>(finish(top.ctx));
+                expStack.pop_back();
+                continue;
+            }
+            int prec = binaryPrecedence(curType);
+            while (expStack.back().kind == ExpFrame::Binary && expStack.back().prec >= prec) {
+                antlr4::ParserRuleContext* ctx = expStack.back().ctx;
+                ctx->addChild(operand);
+                operand = static_cast<SysYParser::ExpContext*>(finish(ctx));
+                expStack.pop_back();
+            }
+            if (prec > 0) {
+                // Mirrors Parser::pushNewRecursionContext: the left operand is
+                // re-parented under the new binary node.
+                SysYParser::ExpContext* ctx = createBinary(prec, static_cast<antlr4::ParserRuleContext*>(operand->parent));
+                ctx->start = operand->start;
+                operand->parent = ctx;
+                ctx->addChild(operand);
+                terminal(ctx, curType);
+                expStack.push_back({ExpFrame::Binary, ctx, prec, nullptr});
+                operand = nullptr;
+                continue;
+            }
+            // The Sub frame on top is complete: `operand` is its exp.
+            expStack.pop_back();
+            if (expStack.empty()) {
+                return operand;
+            }
+            operand = closeFrame(operand);
+        }
+    }
+
+    // Parses the non-left-recursive start of an operand whose parent is
+    // `parent`. Returns the finished operand, or nullptr after pushing the
+    // frame(s) for a construct that contains a nested exp.
+    SysYParser::ExpContext* primary(antlr4::ParserRuleContext* parent) {
+        switch (curType) {
+        case SysYParser::PLUS:
+        case SysYParser::MINUS:
+        case SysYParser::NOT: {
+            // (PLUS | MINUS | NOT) exp  # unaryExp; the operand binds tighter
+            // than any binary operator
+            auto* ctx = createExp<SysYParser::UnaryExpContext>(parent);
+            terminal(ctx, curType);
+            expStack.push_back({ExpFrame::Unary, ctx, 0, nullptr});
+            return nullptr;
+        }
+        case SysYParser::L_PAREN: {
+            // L_PAREN exp R_PAREN  # parenExp
+            auto* ctx = createExp<SysYParser::ParenExpContext>(parent);
+            terminal(ctx, SysYParser::L_PAREN);
+            expStack.push_back({ExpFrame::Paren, ctx, 0, nullptr});
+            expStack.push_back({ExpFrame::Sub, ctx, 0, nullptr});
+            return nullptr;
+        }
+        case SysYParser::IntConst: {
+            // number  # numberExp
+            auto* ctx = createExp<SysYParser::NumberExpContext>(parent);
+            ctx->addChild(number(ctx));
+            return finish(ctx);
+        }
+        case SysYParser::IDENT: {
+            if (LA(2) == SysYParser::L_PAREN) {
+                // IDENT L_PAREN funcRParams? R_PAREN  # funcCallExp
+                // funcRParams: exp (COMMA exp)*
+                auto* ctx = createExp<SysYParser::FuncCallExpContext>(parent);
+                terminal(ctx, SysYParser::IDENT);
+                terminal(ctx, SysYParser::L_PAREN);
+                if (curType == SysYParser::R_PAREN) {
+                    terminal(ctx, SysYParser::R_PAREN);
+                    return finish(ctx);
+                }
+                auto* args = create<SysYParser::FuncRParamsContext>(ctx);
+                expStack.push_back({ExpFrame::Args, args, 0, ctx});
+                expStack.push_back({ExpFrame::Sub, args, 0, nullptr});
+                return nullptr;
+            }
+            // lVal  # lValExp
+            // lVal: IDENT (L_BRACK exp R_BRACK)*
+            auto* ctx = createExp<SysYParser::LValExpContext>(parent);
+            auto* lval = create<SysYParser::LValContext>(ctx);
+            terminal(lval, SysYParser::IDENT);
+            if (optional(lval, SysYParser::L_BRACK)) {
+                expStack.push_back({ExpFrame::Index, lval, 0, ctx});
+                expStack.push_back({ExpFrame::Sub, lval, 0, nullptr});
+                return nullptr;
+            }
+            ctx->addChild(finish(lval));
+            return finish(ctx);
+        }
+        default:
+            fail();
+        }
+    }
+
+    // Hands the finished nested exp `sub` to the frame on top. Returns the
+    // operand that frame completes, or nullptr if it awaits another exp.
+    SysYParser::ExpContext* closeFrame(SysYParser::ExpContext* sub) {
+        ExpFrame& top = expStack.back();
+        top.ctx->addChild(sub);
+        switch (top.kind) {
+        case ExpFrame::Paren: {
+            terminal(top.ctx, SysYParser::R_PAREN);
+            auto* ctx = static_cast<SysYParser::ExpContext*>(finish(top.ctx));
+            expStack.pop_back();
+            return ctx;
+        }
+        case ExpFrame::Args: {
+            if (optional(top.ctx, SysYParser::COMMA)) {
+                expStack.push_back({ExpFrame::Sub, top.ctx, 0, nullptr});
+                return nullptr;
+            }
+            antlr4::ParserRuleContext* call = top.outer;
+            call->addChild(finish(top.ctx));
+            terminal(call, SysYParser::R_PAREN);
+            expStack.pop_back();
+            return static_cast<SysYParser::ExpContext*>(finish(call));
+        }
+        case ExpFrame::Index: {
+            terminal(top.ctx, SysYParser::R_BRACK);
+            if (optional(top.ctx, SysYParser::L_BRACK)) {
+                expStack.push_back({ExpFrame::Sub, top.ctx, 0, nullptr});
+                return nullptr;
+            }
+            antlr4::ParserRuleContext* lValExp = top.outer;
+            lValExp->addChild(finish(top.ctx));
+            expStack.pop_back();
+            return static_cast<SysYParser::ExpContext*>(finish(lValExp));
+        }
+        default: // Sub, Binary and Unary frames are completed in exp()
+            fail();
+        }
+    }
+
+    // cond: exp
+    SysYParser::CondContext* cond(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::CondContext>(parent);
+        ctx->addChild(exp(ctx));
+        return finish(ctx);
+    }
+
+    // lVal: IDENT (L_BRACK exp R_BRACK)*
+    SysYParser::LValContext* lVal(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::LValContext>(parent);
+        terminal(ctx, SysYParser::IDENT);
+        while (optional(ctx, SysYParser::L_BRACK)) {
+            ctx->addChild(exp(ctx));
+            terminal(ctx, SysYParser::R_BRACK);
+        }
+        return finish(ctx);
+    }
+
+    // number: IntConst
+    SysYParser::NumberContext* number(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::NumberContext>(parent);
+        terminal(ctx, SysYParser::IntConst);
+        return finish(ctx);
+    }
+
+    // constExp: exp
+    SysYParser::ConstExpContext* constExp(antlr4::ParserRuleContext* parent) {
+        auto* ctx = create<SysYParser::ConstExpContext>(parent);
+        ctx->addChild(exp(ctx));
+        return finish(ctx);
+    }
+};
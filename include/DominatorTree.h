@@ -0,0 +1,567 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "FunctionSnapshot.h"
+
+// The dominator tree, or post-dominator tree, of a function's CFG, kept up
+// to date as CFG edges are inserted and deleted.
+//
+// Blocks are numbered as in FunctionSnapshot, with the entry block as 0.
+// The post-dominator tree is the dominator tree of the reversed CFG, rooted
+// at a virtual exit whose successors are the blocks without successors.
+// Blocks that cannot reach such a block are unreachable in it. (LLVM gives
+// those blocks extra roots instead.)
+//
+// The tree is built with Semi-NCA (Georgiadis, 2005). Semidominators are
+// computed with Lengauer-Tarjan's path-compressed eval, and each immediate
+// dominator is found by walking up from the DFS parent to the
+// semidominator. Updates follow Georgiadis et al., "An Experimental Study
+// of Dynamic Dominators" (2016), as LLVM's SemiNCAInfo does:
+//  - insertEdge(x, y) with y already reachable: only blocks deeper than
+//    nca(x, y) + 1 can change. A depth-based search from y finds them, and
+//    they move under nca(x, y). If y was unreachable, the blocks that become
+//    reachable get a Semi-NCA run of their own first.
+//  - deleteEdge(x, y): nothing changes if an edge idom(y) -> y is left.
+//    Otherwise only blocks that nca(x, y) dominates can change, so only
+//    that subtree is rebuilt. The whole tree is rebuilt when nca(x, y) is
+//    the root.
+// An update costs time in proportion to the part of the tree it touches.
+class DominatorTree {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    explicit DominatorTree(const FunctionSnapshot& snapshot, bool postDominators = false)
+        : DominatorTree(snapshot.numBlocks(), edgesOf(snapshot), postDominators) {}
+
+    // The tree of a CFG given as edges between blocks 0..numBlocks-1. The
+    // same edge may appear more than once.
+    DominatorTree(uint32_t numBlocks, const std::vector<std::pair<uint32_t, uint32_t>>& edges,
+                  bool postDominators = false)
+        : blocks(numBlocks), post(postDominators), root(postDominators ? numBlocks : 0) {
+        uint32_t numNodes = numBlocks + (post ? 1 : 0);
+        succ.resize(numNodes);
+        pred.resize(numNodes);
+        outDegree.assign(numBlocks, 0);
+        for (auto [from, to] : edges) {
+            ++outDegree[from];
+            post ? addArc(to, from) : addArc(from, to);
+        }
+        for (uint32_t b = 0; post && b < numBlocks; ++b) {
+            if (outDegree[b] == 0) {
+                addArc(root, b);
+            }
+        }
+        idoms.assign(numNodes, NONE);
+        levels.assign(numNodes, NONE);
+        kids.resize(numNodes);
+        kidIndex.assign(numNodes, NONE);
+        dfsNum.assign(numNodes, 0);
+        recalculate();
+    }
+
+    uint32_t numBlocks() const { return blocks; }
+    bool isPostDominatorTree() const { return post; }
+
+    bool isReachable(uint32_t b) const { return levels[b] != NONE; }
+    // The immediate (post-)dominator of `b`. It is NONE for the entry, for
+    // blocks only the virtual exit post-dominates, and for unreachable blocks.
+    uint32_t idom(uint32_t b) const { return post && idoms[b] == root ? NONE : idoms[b]; }
+    // Depth in the tree: 0 for the entry, 1 for the blocks the virtual exit
+    // immediately post-dominates.
+    uint32_t level(uint32_t b) const { return levels[b]; }
+    // The blocks `b` immediately dominates, in no particular order.
+    const std::vector<uint32_t>& children(uint32_t b) const { return kids[b]; }
+
+    // Whether `a` (post-)dominates `b`. Every block dominates itself, and an
+    // unreachable block is dominated by every block.
+    bool dominates(uint32_t a, uint32_t b) const {
+        if (!isReachable(b)) {
+            return true;
+        }
+        if (!isReachable(a)) {
+            return false;
+        }
+        while (levels[b] > levels[a]) {
+            b = idoms[b];
+        }
+        return a == b;
+    }
+
+    // The deepest block that dominates both `a` and `b`, which must be
+    // reachable; NONE if only the virtual exit post-dominates both.
+    uint32_t nearestCommonDominator(uint32_t a, uint32_t b) const {
+        uint32_t n = nca(a, b);
+        return n == root && post ? NONE : n;
+    }
+
+    // The (post-)dominance frontier of every block: the blocks just beyond
+    // the region it dominates. Found by walking up from the predecessors of
+    // each join block, and of the entry, to its idom (Cooper, Harvey and
+    // Kennedy).
+    std::vector<std::vector<uint32_t>> dominanceFrontiers() const {
+        std::vector<std::vector<uint32_t>> frontiers(blocks);
+        for (uint32_t b = 0; b < blocks; ++b) {
+            if (!isReachable(b) || (pred[b].size() < 2 && b != root)) {
+                continue;
+            }
+            for (uint32_t p : pred[b]) {
+                for (uint32_t runner = p; isReachable(p) && runner != idoms[b]; runner = idoms[runner]) {
+                    // Paths from two predecessors may meet below idom(b).
+                    if (frontiers[runner].empty() || frontiers[runner].back() != b) {
+                        frontiers[runner].push_back(b);
+                    }
+                }
+            }
+        }
+        return frontiers;
+    }
+
+    // Adds the CFG edge from -> to and updates the tree.
+    void insertEdge(uint32_t from, uint32_t to) {
+        assert(from < blocks && to < blocks);
+        if (!post) {
+            ++outDegree[from];
+            insertArc(from, to);
+            return;
+        }
+        insertArc(to, from);
+        if (outDegree[from]++ == 0) {
+            deleteArc(root, from);
+        }
+    }
+
+    // Removes one CFG edge from -> to, which must exist, and updates the tree.
+    void deleteEdge(uint32_t from, uint32_t to) {
+        assert(from < blocks && to < blocks && outDegree[from] > 0);
+        if (!post) {
+            --outDegree[from];
+            deleteArc(from, to);
+            return;
+        }
+        // A block left without successors hangs from the virtual exit; link
+        // it there first so it stays reachable meanwhile.
+        if (--outDegree[from] == 0) {
+            insertArc(root, from);
+        }
+        deleteArc(to, from);
+    }
+
+    // The CFG as it now stands, one pair per edge.
+    std::vector<std::pair<uint32_t, uint32_t>> edges() const {
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        for (uint32_t u = 0; u < blocks; ++u) {
+            for (uint32_t v : succ[u]) {
+                result.push_back(post ? std::pair{v, u} : std::pair{u, v});
+            }
+        }
+        return result;
+    }
+
+    // Rebuilds the whole tree.
+    void recalculate() {
+        std::fill(idoms.begin(), idoms.end(), NONE);
+        std::fill(levels.begin(), levels.end(), NONE);
+        for (std::vector<uint32_t>& list : kids) {
+            list.clear();
+        }
+        if (root >= succ.size()) {
+            return; // a function without blocks
+        }
+        levels[root] = 0;
+        search(root, [](uint32_t, uint32_t) { return true; });
+        computeIdoms();
+        attachSearched();
+        clearSearch();
+    }
+
+    // Whether the tree is the one recalculate() would build from the
+    // current CFG, and its child lists agree with it. For checking updates.
+    bool verify() const {
+        DominatorTree fresh(blocks, edges(), post);
+        if (fresh.idoms != idoms || fresh.levels != levels) {
+            return false;
+        }
+        for (uint32_t v = 0; v < idoms.size(); ++v) {
+            uint32_t parent = idoms[v];
+            if (parent != NONE && (kidIndex[v] >= kids[parent].size() || kids[parent][kidIndex[v]] != v)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    uint32_t blocks;
+    bool post;
+    uint32_t root; // the entry block, or the virtual exit (node `blocks`)
+    // The graph the tree is built over: the CFG, or the reversed CFG plus
+    // the virtual exit's edges.
+    std::vector<std::vector<uint32_t>> succ;
+    std::vector<std::vector<uint32_t>> pred;
+    std::vector<uint32_t> outDegree; // CFG successors per block
+    std::vector<uint32_t> idoms;
+    std::vector<uint32_t> levels;
+    std::vector<std::vector<uint32_t>> kids;
+    std::vector<uint32_t> kidIndex; // position in the parent's child list
+
+    // One Semi-NCA run, indexed by DFS number; dfsNum is that number plus
+    // one for the nodes the last search reached, and 0 for all others.
+    std::vector<uint32_t> dfsNum;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> ancestor; // DFS parent, then compressed
+    std::vector<uint32_t> semi;
+    std::vector<uint32_t> label;
+    std::vector<uint32_t> parentNum; // DFS parent, then immediate dominator
+    std::vector<uint32_t> evalStack;
+
+    static std::vector<std::pair<uint32_t, uint32_t>> edgesOf(const FunctionSnapshot& snapshot) {
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        for (uint32_t b = 0; b < snapshot.numBlocks(); ++b) {
+            for (const uint32_t* s = snapshot.successors.begin(b); s != snapshot.successors.end(b); ++s) {
+                result.push_back({b, *s});
+            }
+        }
+        return result;
+    }
+
+    void addArc(uint32_t u, uint32_t v) {
+        succ[u].push_back(v);
+        pred[v].push_back(u);
+    }
+
+    static void eraseOne(std::vector<uint32_t>& list, uint32_t value) {
+        auto it = std::find(list.begin(), list.end(), value);
+        assert(it != list.end() && "no such edge");
+        *it = list.back();
+        list.pop_back();
+    }
+
+    uint32_t nca(uint32_t a, uint32_t b) const {
+        while (a != b) {
+            if (levels[a] < levels[b]) {
+                std::swap(a, b);
+            }
+            a = idoms[a];
+        }
+        return a;
+    }
+
+    void setIdom(uint32_t v, uint32_t parent) {
+        if (idoms[v] != NONE) {
+            std::vector<uint32_t>& siblings = kids[idoms[v]];
+            uint32_t last = siblings.back();
+            siblings[kidIndex[v]] = last;
+            kidIndex[last] = kidIndex[v];
+            siblings.pop_back();
+        }
+        idoms[v] = parent;
+        if (parent != NONE) {
+            kidIndex[v] = static_cast<uint32_t>(kids[parent].size());
+            kids[parent].push_back(v);
+        }
+    }
+
+    // Depth-first search from `start` that enters a node `to` over an edge
+    // from -> to only if enter(from, to) holds, numbering nodes in preorder.
+    template <typename Enter>
+    void search(uint32_t start, Enter enter) {
+        order.clear();
+        parentNum.clear();
+        std::vector<std::pair<uint32_t, uint32_t>> stack; // node, next successor
+        auto visit = [&](uint32_t v, uint32_t parent) {
+            dfsNum[v] = static_cast<uint32_t>(order.size()) + 1;
+            order.push_back(v);
+            parentNum.push_back(parent);
+            stack.push_back({v, 0});
+        };
+        visit(start, 0);
+        while (!stack.empty()) {
+            auto& [v, next] = stack.back();
+            if (next == succ[v].size()) {
+                stack.pop_back();
+                continue;
+            }
+            uint32_t w = succ[v][next++];
+            if (!dfsNum[w] && enter(v, w)) {
+                visit(w, dfsNum[v] - 1);
+            }
+        }
+    }
+
+    void clearSearch() {
+        for (uint32_t v : order) {
+            dfsNum[v] = 0;
+        }
+    }
+
+    // Semi-NCA over the nodes the last search reached, leaving the DFS
+    // number of each one's immediate dominator in parentNum. Edges from
+    // nodes it did not reach are ignored.
+    void computeIdoms() {
+        uint32_t n = static_cast<uint32_t>(order.size());
+        ancestor = parentNum;
+        semi.resize(n);
+        label.resize(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            semi[i] = i;
+            label[i] = i;
+        }
+        for (uint32_t i = n; i-- > 1;) {
+            uint32_t s = parentNum[i];
+            for (uint32_t p : pred[order[i]]) {
+                if (dfsNum[p]) {
+                    s = std::min(s, semi[eval(dfsNum[p] - 1, i + 1)]);
+                }
+            }
+            semi[i] = s;
+        }
+        // idom(w) is the nearest common ancestor of semi(w) and the DFS
+        // parent of w, whose own idom is already known.
+        for (uint32_t i = 1; i < n; ++i) {
+            uint32_t candidate = parentNum[i];
+            while (candidate > semi[i]) {
+                candidate = parentNum[candidate];
+            }
+            parentNum[i] = candidate;
+        }
+    }
+
+    // The node of least semidominator on the path from `v` up to, but not
+    // including, the first ancestor numbered below `linked`; the nodes from
+    // `linked` on have been processed.
+    uint32_t eval(uint32_t v, uint32_t linked) {
+        if (ancestor[v] < linked) {
+            return label[v];
+        }
+        uint32_t top = v;
+        do {
+            evalStack.push_back(top);
+            top = ancestor[top];
+        } while (ancestor[top] >= linked);
+        uint32_t topLabel = label[top];
+        do {
+            v = evalStack.back();
+            evalStack.pop_back();
+            ancestor[v] = ancestor[top];
+            if (semi[topLabel] < semi[label[v]]) {
+                label[v] = topLabel;
+            } else {
+                topLabel = label[v];
+            }
+            top = v;
+        } while (!evalStack.empty());
+        return label[v];
+    }
+
+    // Hangs the nodes of the last search below its start node, whose level
+    // must already be set.
+    void attachSearched() {
+        for (uint32_t i = 1; i < order.size(); ++i) {
+            uint32_t parent = order[parentNum[i]];
+            setIdom(order[i], parent);
+            levels[order[i]] = levels[parent] + 1;
+        }
+    }
+
+    void insertArc(uint32_t u, uint32_t v) {
+        addArc(u, v);
+        if (!isReachable(u)) {
+            return;
+        }
+        if (isReachable(v)) {
+            insertReachable(u, v);
+            return;
+        }
+        // v and whatever it leads to that was unreachable become reachable,
+        // dominated by u; edges from them into the rest of the tree are then
+        // inserted one by one.
+        std::vector<std::pair<uint32_t, uint32_t>> connecting;
+        search(v, [&](uint32_t from, uint32_t to) {
+            if (isReachable(to)) {
+                connecting.push_back({from, to});
+                return false;
+            }
+            return true;
+        });
+        computeIdoms();
+        setIdom(v, u);
+        levels[v] = levels[u] + 1;
+        attachSearched();
+        clearSearch();
+        for (auto [from, to] : connecting) {
+            insertReachable(from, to);
+        }
+    }
+
+    // After u -> v with both reachable, a block w changes its idom, to
+    // nca(u, v), iff level(w) > level(nca) + 1 and some path from v to w
+    // stays at level(w) or deeper. The search expands the deepest blocks
+    // first, like Dijkstra's algorithm with levels as keys.
+    void insertReachable(uint32_t u, uint32_t v) {
+        uint32_t top = nca(u, v);
+        uint32_t topLevel = levels[top];
+        if (topLevel + 1 >= levels[v]) {
+            return;
+        }
+        std::priority_queue<std::pair<uint32_t, uint32_t>> bucket; // level, node
+        std::vector<uint32_t> visited{v};
+        std::vector<uint32_t> affected;
+        std::vector<uint32_t> unaffected; // deeper than the level being expanded
+        dfsNum[v] = 1;
+        bucket.push({levels[v], v});
+        while (!bucket.empty()) {
+            uint32_t w = bucket.top().second;
+            bucket.pop();
+            affected.push_back(w);
+            uint32_t current = levels[w];
+            for (;;) {
+                for (uint32_t s : succ[w]) {
+                    if (levels[s] <= topLevel + 1 || dfsNum[s]) {
+                        continue;
+                    }
+                    dfsNum[s] = 1;
+                    visited.push_back(s);
+                    if (levels[s] > current) {
+                        unaffected.push_back(s);
+                    } else {
+                        bucket.push({levels[s], s});
+                    }
+                }
+                if (unaffected.empty()) {
+                    break;
+                }
+                w = unaffected.back();
+                unaffected.pop_back();
+            }
+        }
+        for (uint32_t w : visited) {
+            dfsNum[w] = 0;
+        }
+        for (uint32_t w : affected) {
+            setIdom(w, top);
+        }
+        for (uint32_t w : affected) {
+            updateLevels(w);
+        }
+    }
+
+    // Sets the levels of `v` and its subtree from its parent's.
+    void updateLevels(uint32_t v) {
+        std::vector<uint32_t> stack{v};
+        while (!stack.empty()) {
+            uint32_t w = stack.back();
+            stack.pop_back();
+            if (levels[w] == levels[idoms[w]] + 1) {
+                continue;
+            }
+            levels[w] = levels[idoms[w]] + 1;
+            stack.insert(stack.end(), kids[w].begin(), kids[w].end());
+        }
+    }
+
+    void deleteArc(uint32_t u, uint32_t v) {
+        eraseOne(succ[u], v);
+        eraseOne(pred[v], u);
+        if (!isReachable(u) || !isReachable(v)) {
+            return;
+        }
+        uint32_t top = nca(u, v);
+        if (top == v) {
+            return; // every path through u -> v already passed v
+        }
+        // An edge idom(v) -> v that is left keeps idom(v), since paths to
+        // idom(v) never use u -> v. A path that did use it can then be
+        // rerouted through that edge, so no other block changes either.
+        if (std::find(pred[v].begin(), pred[v].end(), idoms[v]) != pred[v].end()) {
+            return;
+        }
+        if (idoms[v] == u && !hasOtherSupport(v)) {
+            deleteUnreachable(v);
+            return;
+        }
+        if (top == root) {
+            recalculate();
+            return;
+        }
+        rebuildSubtree(top);
+    }
+
+    // Whether `v` has a predecessor it does not dominate, that is, one it
+    // can be reached from without the edge just deleted.
+    bool hasOtherSupport(uint32_t v) const {
+        for (uint32_t p : pred[v]) {
+            if (isReachable(p) && nca(v, p) != v) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Cuts off the subtree of `v`, which the deleted edge was the only way
+    // into. Blocks it has edges to keep their idom, unless they dominate v
+    // or the edges were their only way in; the highest nca(v, s) over the
+    // targets s that do not dominate v bounds what else changes.
+    void deleteUnreachable(uint32_t v) {
+        std::vector<uint32_t> subtree = collectSubtree(v);
+        for (uint32_t w : subtree) {
+            levels[w] = NONE;
+        }
+        uint32_t top = NONE;
+        for (uint32_t w : subtree) {
+            for (uint32_t s : succ[w]) {
+                if (!isReachable(s)) {
+                    continue;
+                }
+                uint32_t c = nca(idoms[v], s);
+                if (c != s && (top == NONE || levels[c] < levels[top])) {
+                    top = c;
+                }
+            }
+        }
+        for (uint32_t w : subtree) {
+            setIdom(w, NONE);
+        }
+        if (top == root) {
+            recalculate();
+        } else if (top != NONE) {
+            rebuildSubtree(top);
+        }
+    }
+
+    // `top` and the blocks it dominates, parents first.
+    std::vector<uint32_t> collectSubtree(uint32_t top) const {
+        std::vector<uint32_t> subtree{top};
+        for (size_t i = 0; i < subtree.size(); ++i) {
+            const std::vector<uint32_t>& list = kids[subtree[i]];
+            subtree.insert(subtree.end(), list.begin(), list.end());
+        }
+        return subtree;
+    }
+
+    // Recomputes the tree below `top`, whose own idom stays. Every path
+    // into the subtree passes `top` and then stays inside it, so a Semi-NCA
+    // run from `top` restricted to the subtree gives the right idoms; what
+    // it does not reach has become unreachable.
+    void rebuildSubtree(uint32_t top) {
+        std::vector<uint32_t> subtree = collectSubtree(top);
+        for (uint32_t w : subtree) {
+            levels[w] = NONE; // marks the subtree for the search
+        }
+        levels[top] = levels[idoms[top]] + 1;
+        search(top, [&](uint32_t, uint32_t to) { return levels[to] == NONE; });
+        computeIdoms();
+        attachSearched();
+        for (uint32_t w : subtree) {
+            if (!dfsNum[w]) {
+                setIdom(w, NONE);
+            }
+        }
+        clearSearch();
+    }
+};
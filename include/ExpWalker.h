@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "SysYParser.h"
+
+// Post-order walk over an `exp` tree, driven by an explicit work stack
+// instead of native recursion, so nesting depth is bounded by memory rather
+// than by the thread's stack. IRGenerator lowers expressions with it and
+// ConstEvaluator folds them.
+//
+// Nodes are classified by the shape of the labeled alternative, which is
+// fixed by SysYParser.g4: the first child is a token (parenExp, funcCallExp,
+// unaryExp) or a rule (lValExp, numberExp, binary alternatives), and a
+// binary alternative's operator is the token in the middle. Children are
+// read by position, with no RTTI. Operands are walked left to right.
+//
+// The Visitor supplies the semantics:
+//   using Result = ...;
+//   Result number(SysYParser::NumberContext*);
+//   Result unsupported(antlr4::ParserRuleContext*);   // a shape it does not handle
+//   Result unary(size_t op, Result operand);
+//   // Called before the operands are walked; false to skip them, with the
+//   // node's result in `out`.
+//   bool enterBinary(SysYParser::ExpContext*, size_t op, Result& out);
+//   Result binary(SysYParser::ExpContext*, size_t op, Result lhs, Result rhs);
+//   // Called before the index expressions of a well-formed lVal are walked;
+//   // false to skip them, with the node's result in `out`.
+//   bool enterLVal(SysYParser::LValContext*, Result& out);
+//   Result lVal(SysYParser::LValContext*, const Result* indices, size_t count);
+template <typename Visitor>
+class ExpWalker {
+public:
+    using Result = typename Visitor::Result;
+
+    explicit ExpWalker(Visitor& visitor) : visitor(visitor) {}
+
+    Result walk(SysYParser::ExpContext* root) {
+        size_t base = work.size();
+        work.push_back({root, Task::Visit, 0});
+        while (work.size() > base) {
+            Task task = work.back();
+            work.pop_back();
+            switch (task.kind) {
+            case Task::Visit:
+                expand(static_cast<SysYParser::ExpContext*>(task.ctx));
+                break;
+            case Task::Unary: {
+                Result operand = pop();
+                values.push_back(visitor.unary(task.op, operand));
+                break;
+            }
+            case Task::Binary: {
+                Result rhs = pop();
+                Result lhs = pop();
+                values.push_back(visitor.binary(static_cast<SysYParser::ExpContext*>(task.ctx), task.op, lhs, rhs));
+                break;
+            }
+            case Task::LVal: {
+                size_t count = task.op;
+                size_t first = values.size() - count;
+                Result result = visitor.lVal(static_cast<SysYParser::LValContext*>(task.ctx), values.data() + first, count);
+                values.resize(first);
+                values.push_back(result);
+                break;
+            }
+            }
+        }
+        return pop();
+    }
+
+private:
+    struct Task {
+        antlr4::ParserRuleContext* ctx;
+        enum Kind : uint8_t { Visit, Unary, Binary, LVal } kind;
+        size_t op; // Unary, Binary: operator token type; LVal: number of indices
+    };
+
+    Visitor& visitor;
+    std::vector<Task> work;
+    std::vector<Result> values;
+
+    static bool isToken(antlr4::tree::ParseTree* node) {
+        return node->getTreeType() == antlr4::tree::ParseTreeType::TERMINAL;
+    }
+    static bool isRule(antlr4::tree::ParseTree* node) {
+        return node->getTreeType() == antlr4::tree::ParseTreeType::RULE;
+    }
+    static size_t tokenType(antlr4::tree::ParseTree* node) {
+        return static_cast<antlr4::tree::TerminalNode*>(node)->getSymbol()->getType();
+    }
+    // Every rule child of an ExpContext is an exp, except lVal / number in
+    // first position, which expand() dispatches on before calling this.
+    static antlr4::ParserRuleContext* expAt(antlr4::ParserRuleContext* ctx, size_t i) {
+        return static_cast<antlr4::ParserRuleContext*>(ctx->children[i]);
+    }
+
+    Result pop() {
+        Result result = values.back();
+        values.pop_back();
+        return result;
+    }
+
+    // Either pushes the node's result, or schedules the node after its
+    // operands (pushed last, so the leftmost is walked first).
+    void expand(SysYParser::ExpContext* ctx) {
+        const auto& children = ctx->children;
+        if (children.empty()) {
+            values.push_back(visitor.unsupported(ctx)); // left behind by error recovery
+            return;
+        }
+        antlr4::tree::ParseTree* first = children[0];
+        if (isToken(first)) {
+            size_t type = tokenType(first);
+            if (type == SysYParser::L_PAREN && children.size() == 3 && isRule(children[1])) {
+                work.push_back({expAt(ctx, 1), Task::Visit, 0});
+            } else if ((type == SysYParser::PLUS || type == SysYParser::MINUS || type == SysYParser::NOT) &&
+                       children.size() == 2 && isRule(children[1])) {
+                work.push_back({ctx, Task::Unary, type});
+                work.push_back({expAt(ctx, 1), Task::Visit, 0});
+            } else {
+                values.push_back(visitor.unsupported(ctx)); // funcCallExp: calls are not lowered yet
+            }
+            return;
+        }
+        if (!isRule(first)) {
+            values.push_back(visitor.unsupported(ctx));
+            return;
+        }
+        switch (static_cast<antlr4::ParserRuleContext*>(first)->getRuleIndex()) {
+        case SysYParser::RuleLVal:
+            expandLVal(static_cast<SysYParser::LValContext*>(first));
+            return;
+        case SysYParser::RuleNumber:
+            values.push_back(visitor.number(static_cast<SysYParser::NumberContext*>(first)));
+            return;
+        case SysYParser::RuleExp:
+            if (children.size() == 3 && isToken(children[1]) && isRule(children[2])) {
+                size_t op = tokenType(children[1]);
+                Result out;
+                if (!visitor.enterBinary(ctx, op, out)) {
+                    values.push_back(out);
+                    return;
+                }
+                work.push_back({ctx, Task::Binary, op});
+                work.push_back({expAt(ctx, 2), Task::Visit, 0});
+                work.push_back({expAt(ctx, 0), Task::Visit, 0});
+                return;
+            }
+            values.push_back(visitor.unsupported(ctx));
+            return;
+        default:
+            values.push_back(visitor.unsupported(ctx));
+            return;
+        }
+    }
+
+    // lVal: IDENT (L_BRACK exp R_BRACK)*
+    void expandLVal(SysYParser::LValContext* ctx) {
+        const auto& children = ctx->children;
+        bool wellFormed = !children.empty() && isToken(children[0]) && (children.size() - 1) % 3 == 0;
+        for (size_t i = 2; wellFormed && i < children.size(); i += 3) {
+            wellFormed = isRule(children[i]);
+        }
+        if (!wellFormed) {
+            values.push_back(visitor.unsupported(ctx));
+            return;
+        }
+        Result out;
+        if (!visitor.enterLVal(ctx, out)) {
+            values.push_back(out);
+            return;
+        }
+        size_t count = (children.size() - 1) / 3;
+        work.push_back({ctx, Task::LVal, count});
+        for (size_t i = count; i-- > 0;) {
+            work.push_back({expAt(ctx, 2 + 3 * i), Task::Visit, 0});
+        }
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "IR.h"
+
+// Deep copies of functions: the way to keep a function as it was without a
+// ChangeJournal, and the baseline the journal is measured against (see
+// sysy-opt --undo).
+class FunctionCloner {
+public:
+    // A copy of `func` added at the end of its module under `name`: the same
+    // blocks and instructions, with the same names, and operands that refer
+    // to the function's own blocks and instructions pointing into the copy.
+    static Function* clone(Function& func, std::string_view name) {
+        Module& module = *func.getParent();
+        Arena& arena = module.getArena();
+        Function* copy = module.addFunction(func.getFunctionType(), name);
+        copy->linkage = func.linkage;
+
+        // Number the blocks and instructions, so their copies can be found
+        // by index (Value::number) rather than in a map.
+        std::vector<Value*> copies;
+        for (BasicBlock& block : func.blockList) {
+            block.number = static_cast<uint32_t>(copies.size());
+            copies.push_back(nullptr);
+            for (Instruction& inst : block.instList) {
+                inst.number = static_cast<uint32_t>(copies.size());
+                copies.push_back(nullptr);
+            }
+        }
+
+        // addFunction made an empty entry block; it becomes the first copy.
+        BasicBlock* entry = copy->getEntryBlock();
+        std::vector<Instruction*> forwardRefs; // copies with an operand defined further on
+        for (BasicBlock& block : func.blockList) {
+            BasicBlock* blockCopy = &block == func.getEntryBlock() ? entry : copy->appendBlock();
+            blockCopy->nameId = block.nameId;
+            copies[block.number] = blockCopy;
+            for (Instruction& inst : block.instList) {
+                Instruction* instCopy = inst.clone(arena);
+                instCopy->nameId = inst.nameId;
+                bool forward = false;
+                for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                    if (isLocal(inst.getOperand(i), func)) {
+                        Value* mapped = copies[inst.getOperand(i)->number];
+                        if (mapped) {
+                            instCopy->setOperand(i, mapped);
+                        } else {
+                            forward = true;
+                        }
+                    }
+                }
+                if (forward) {
+                    forwardRefs.push_back(instCopy);
+                }
+                copies[inst.number] = instCopy;
+                blockCopy->addInstruction(instCopy);
+            }
+        }
+        for (Instruction* inst : forwardRefs) {
+            for (size_t i = 0; i < inst->getNumOperands(); ++i) {
+                if (isLocal(inst->getOperand(i), func)) {
+                    inst->setOperand(i, copies[inst->getOperand(i)->number]);
+                }
+            }
+        }
+        return copy;
+    }
+
+private:
+    static bool isLocal(Value* value, const Function& func) {
+        if (!value) {
+            return false;
+        }
+        if (Instruction* inst = value->asInstruction()) {
+            return inst->getParent() && inst->getParent()->getParent() == &func;
+        }
+        BasicBlock* block = value->asBasicBlock();
+        return block && block->getParent() == &func;
+    }
+};
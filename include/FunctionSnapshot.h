@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "IR.h"
+
+// Compressed sparse rows: row r is list[start[r] .. start[r + 1]).
+struct CsrArray {
+    std::vector<uint32_t> start{0};
+    std::vector<uint32_t> list;
+
+    uint32_t numRows() const { return static_cast<uint32_t>(start.size() - 1); }
+    uint32_t size(uint32_t row) const { return start[row + 1] - start[row]; }
+    const uint32_t* begin(uint32_t row) const { return list.data() + start[row]; }
+    const uint32_t* end(uint32_t row) const { return list.data() + start[row + 1]; }
+
+    // Builds the transpose of `rows` with `numColumns` rows, keeping
+    // duplicates; each of its rows lists the original rows in order.
+    static CsrArray transpose(const CsrArray& rows, uint32_t numColumns) {
+        CsrArray result;
+        result.start.assign(numColumns + 1, 0);
+        for (uint32_t column : rows.list) {
+            ++result.start[column + 1];
+        }
+        for (uint32_t c = 0; c < numColumns; ++c) {
+            result.start[c + 1] += result.start[c];
+        }
+        result.list.resize(rows.list.size());
+        std::vector<uint32_t> next(result.start.begin(), result.start.end() - 1);
+        for (uint32_t r = 0; r < rows.numRows(); ++r) {
+            for (const uint32_t* c = rows.begin(r); c != rows.end(r); ++c) {
+                result.list[next[*c]++] = r;
+            }
+        }
+        return result;
+    }
+};
+
+// Open-addressing map from pointers to 32-bit indices, without a heap node
+// per entry.
+class PointerIndexMap {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    void reserve(size_t count) {
+        if (count * 2 > slots.size()) {
+            rehash(capacityFor(count));
+        }
+    }
+
+    // The index of `key`, inserting `index` if it is new; second is true if
+    // it was inserted.
+    std::pair<uint32_t, bool> insert(const void* key, uint32_t index) {
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(capacityFor(count + 1));
+        }
+        for (size_t i = hash(key);; i = (i + 1) & (slots.size() - 1)) {
+            if (slots[i].key == key) {
+                return {slots[i].index, false};
+            }
+            if (!slots[i].key) {
+                slots[i] = {key, index};
+                ++count;
+                return {index, true};
+            }
+        }
+    }
+
+    uint32_t find(const void* key) const {
+        if (slots.empty()) {
+            return NONE;
+        }
+        for (size_t i = hash(key);; i = (i + 1) & (slots.size() - 1)) {
+            if (slots[i].key == key) {
+                return slots[i].index;
+            }
+            if (!slots[i].key) {
+                return NONE;
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        const void* key = nullptr;
+        uint32_t index = NONE;
+    };
+    std::vector<Slot> slots; // size is zero or a power of two, at most half full
+    size_t count = 0;
+
+    size_t hash(const void* key) const {
+        // Fibonacci hashing; the low bits of an arena pointer carry no entropy.
+        return static_cast<size_t>((reinterpret_cast<uintptr_t>(key) >> 4) * 0x9E3779B97F4A7C15ull) &
+               (slots.size() - 1);
+    }
+
+    static size_t capacityFor(size_t count) {
+        size_t capacity = 16;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots);
+        count = 0;
+        for (const Slot& slot : old) {
+            if (slot.key) {
+                insert(slot.key, slot.index);
+            }
+        }
+    }
+};
+
+// Dense, index-based snapshot of one Function, for whole-function analyses
+// that would otherwise chase Value* and BasicBlock* pointers.
+//
+// Instructions are numbered 0..numInstructions()-1 in block order, and the
+// same numbers serve as their value IDs; taking a snapshot stores them in
+// Value::number. The other values they use (constants, globals,
+// blocks) are numbered after them, through a hash map. Blocks are numbered
+// in function order, and block b's instructions are the range
+// [blockStart[b], blockStart[b + 1]). Per-instruction facts are parallel
+// arrays; lists are CsrArrays of 32-bit indices. value() and block() map an
+// analysis result back to the pointer IR.
+//
+// The snapshot is not updated when the function changes; take a new one.
+class FunctionSnapshot {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    std::vector<Instruction::Opcode> opcode; // per instruction
+    std::vector<uint32_t> parentBlock;       // per instruction
+    std::vector<uint32_t> blockStart;        // per block, plus one past the end
+    CsrArray operands;                       // instruction -> value IDs
+    CsrArray users;                          // value ID -> instructions, once per use
+    CsrArray successors;                     // block -> blocks
+    CsrArray predecessors;                   // block -> blocks
+
+    explicit FunctionSnapshot(Function& func) : func(&func) {
+        for (BasicBlock& block : func.blockList) {
+            blockIndex.insert(&block, static_cast<uint32_t>(blocks.size()));
+            blocks.push_back(&block);
+            for (Instruction& inst : block.instList) {
+                inst.number = static_cast<uint32_t>(values.size());
+                values.push_back(&inst);
+            }
+        }
+        numInsts = static_cast<uint32_t>(values.size());
+        opcode.reserve(numInsts);
+        parentBlock.reserve(numInsts);
+        blockStart.reserve(blocks.size() + 1);
+
+        for (uint32_t b = 0; b < blocks.size(); ++b) {
+            blockStart.push_back(static_cast<uint32_t>(opcode.size()));
+            const Instruction* terminator = nullptr;
+            for (Instruction& inst : blocks[b]->instList) {
+                opcode.push_back(inst.opcode);
+                parentBlock.push_back(b);
+                for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                    operands.list.push_back(idOrAdd(inst.getOperand(i)));
+                }
+                operands.start.push_back(static_cast<uint32_t>(operands.list.size()));
+                terminator = &inst;
+            }
+            // A block's successors are the blocks its terminator names.
+            for (size_t i = 0; terminator && i < terminator->getNumOperands(); ++i) {
+                if (BasicBlock* target = terminator->getOperand(i)->asBasicBlock()) {
+                    uint32_t index = blockIndex.find(target);
+                    if (index != NONE) {
+                        successors.list.push_back(index);
+                    }
+                }
+            }
+            successors.start.push_back(static_cast<uint32_t>(successors.list.size()));
+        }
+        blockStart.push_back(numInsts);
+        users = CsrArray::transpose(operands, numValues());
+        predecessors = CsrArray::transpose(successors, numBlocks());
+    }
+
+    FunctionSnapshot(const FunctionSnapshot&) = delete;
+    FunctionSnapshot& operator=(const FunctionSnapshot&) = delete;
+
+    uint32_t numInstructions() const { return numInsts; }
+    uint32_t numValues() const { return static_cast<uint32_t>(values.size()); }
+    uint32_t numBlocks() const { return static_cast<uint32_t>(blocks.size()); }
+
+    bool isInstruction(uint32_t id) const { return id < numInsts; }
+    Value* value(uint32_t id) const { return values[id]; }
+    Instruction* instruction(uint32_t id) const { return static_cast<Instruction*>(values[id]); }
+    BasicBlock* block(uint32_t b) const { return blocks[b]; }
+
+    // The ID of an instruction of the function or a value it uses; NONE
+    // for anything else. Valid until the function changes.
+    uint32_t idOf(Value* value) const {
+        Instruction* inst = value->asInstruction();
+        return inst && inst->getParent() && inst->getParent()->getParent() == func ? inst->number : ids.find(value);
+    }
+
+private:
+    const Function* func;
+    uint32_t numInsts = 0;
+    std::vector<Value*> values;
+    std::vector<BasicBlock*> blocks;
+    PointerIndexMap ids;
+    PointerIndexMap blockIndex;
+
+    uint32_t idOrAdd(Value* value) {
+        uint32_t id = idOf(value);
+        if (id != NONE) {
+            return id;
+        }
+        id = static_cast<uint32_t>(values.size());
+        ids.insert(value, id);
+        values.push_back(value);
+        return id;
+    }
+};
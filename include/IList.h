@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+
+template <typename T, typename Parent>
+class IList;
+
+// What an IList<T, Parent> is told as nodes come and go; `owner` is the
+// Parent of the list. nodeInserted() follows the linking of `node`, and
+// nodeRemoved() precedes its unlinking, with `next` the node after it
+// (nullptr at the end). These do nothing; a specialization of IListTraits
+// that wants them overrides them.
+template <typename T, typename Parent>
+struct IListCallbacks {
+    static void nodeInserted(Parent*, T*) {}
+    static void nodeRemoved(Parent*, T*, T*) {}
+};
+
+// How an IList<T, Parent> frees the nodes it erases. `owner` is the Parent
+// of the list the node was in. Specialize it for nodes that do not come
+// from plain `new`.
+template <typename T, typename Parent>
+struct IListTraits : IListCallbacks<T, Parent> {
+    static void deleteNode(Parent*, T* node) { delete node; }
+};
+
+// The links of a node that sits in an IList<T, Parent>. A class T derives
+// from IListNode<T, Parent> to be able to sit in at most one such list at a
+// time; getParent() is the Parent that list belongs to (nullptr while the
+// node is in no list).
+template <typename T, typename Parent>
+class IListNode {
+public:
+    Parent* getParent() const { return parent; }
+
+protected:
+    IListNode() = default;
+    IListNode(const IListNode&) = delete;
+    IListNode& operator=(const IListNode&) = delete;
+    ~IListNode() = default;
+
+private:
+    friend class IList<T, Parent>;
+
+    IListNode* prev = nullptr;
+    IListNode* next = nullptr;
+    Parent* parent = nullptr;
+};
+
+// Owning intrusive doubly-linked list, in the spirit of LLVM's ilist.
+//
+// The links live in the nodes themselves, so insert, erase, remove and
+// moving a node to another list are O(1) and allocate nothing, and an
+// iterator stays valid until its own node is erased, however the list
+// around it changes. The list is circular through a sentinel, which end()
+// points at. It owns its nodes: erase() and the destructor free them through
+// IListTraits, and remove() hands one back to the caller.
+template <typename T, typename Parent>
+class IList {
+    using Node = IListNode<T, Parent>;
+
+public:
+    template <typename V>
+    class Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = V*;
+        using reference = V&;
+
+        Iterator() = default;
+        // iterator -> const_iterator
+        template <typename W>
+        Iterator(const Iterator<W>& other) : node(other.node) {}
+
+        V& operator*() const { return *static_cast<V*>(node); }
+        V* operator->() const { return static_cast<V*>(node); }
+        Iterator& operator++() {
+            node = node->next;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator old = *this;
+            node = node->next;
+            return old;
+        }
+        Iterator& operator--() {
+            node = node->prev;
+            return *this;
+        }
+        Iterator operator--(int) {
+            Iterator old = *this;
+            node = node->prev;
+            return old;
+        }
+        bool operator==(const Iterator& other) const { return node == other.node; }
+        bool operator!=(const Iterator& other) const { return node != other.node; }
+
+    private:
+        friend class IList;
+        template <typename W>
+        friend class Iterator;
+
+        explicit Iterator(Node* node) : node(node) {}
+
+        Node* node = nullptr;
+    };
+
+    using iterator = Iterator<T>;
+    using const_iterator = Iterator<const T>;
+
+    explicit IList(Parent* owner) : owner(owner) { sentinel.prev = sentinel.next = &sentinel; }
+    IList(const IList&) = delete;
+    IList& operator=(const IList&) = delete;
+    ~IList() { clear(); }
+
+    iterator begin() { return iterator(sentinel.next); }
+    iterator end() { return iterator(&sentinel); }
+    const_iterator begin() const { return const_iterator(sentinel.next); }
+    const_iterator end() const { return const_iterator(const_cast<Node*>(&sentinel)); }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    T& front() { return *begin(); }
+    T& back() { return *std::prev(end()); }
+    const T& front() const { return *begin(); }
+    const T& back() const { return *std::prev(end()); }
+
+    // The iterator of a node that is in some IList<T, Parent>.
+    static iterator iteratorTo(T* node) { return iterator(node); }
+
+    // Links `node` in before `pos` and takes ownership of it.
+    iterator insert(iterator pos, T* node) {
+        link(pos.node, node);
+        ++count;
+        Traits::nodeInserted(owner, node);
+        return iterator(node);
+    }
+
+    void push_back(T* node) { insert(end(), node); }
+    void push_front(T* node) { insert(begin(), node); }
+
+    // Unlinks the node at `pos` and hands it to the caller, who must insert
+    // it into a list again or free it with IListTraits<T, Parent>.
+    T* remove(iterator pos) {
+        Node* n = pos.node;
+        Traits::nodeRemoved(owner, static_cast<T*>(n), nextNode(n));
+        unlink(n);
+        n->parent = nullptr;
+        --count;
+        return static_cast<T*>(n);
+    }
+
+    // Unlinks and frees the node at `pos`; returns the iterator after it.
+    // The node keeps its parent while it is destroyed.
+    iterator erase(iterator pos) {
+        Node* n = pos.node;
+        iterator next(n->next);
+        Traits::nodeRemoved(owner, static_cast<T*>(n), nextNode(n));
+        unlink(n);
+        --count;
+        Traits::deleteNode(owner, static_cast<T*>(n));
+        return next;
+    }
+
+    void clear() {
+        while (!empty()) {
+            erase(begin());
+        }
+    }
+
+    // Moves the nodes [first, last) of `from` in before `pos`. `from` may be
+    // this list, as long as `pos` is not inside the range; `pos` at either
+    // end of it leaves the list as it is. Relinking is O(1);
+    // moving nodes between lists also re-parents them, which is O(moved).
+    // IListTraits is told of each node as removed and then inserted, in
+    // order, as if they were moved one at a time.
+    void splice(iterator pos, IList& from, iterator first, iterator last) {
+        if (first == last || pos == first || pos == last) {
+            return;
+        }
+        for (Node* n = first.node; n != last.node; n = n->next) {
+            Traits::nodeRemoved(from.owner, static_cast<T*>(n), from.nextNode(n));
+            Traits::nodeInserted(owner, static_cast<T*>(n));
+        }
+        if (&from != this) {
+            size_t moved = 0;
+            for (Node* n = first.node; n != last.node; n = n->next) {
+                n->parent = owner;
+                ++moved;
+            }
+            from.count -= moved;
+            count += moved;
+        }
+        Node* head = first.node;
+        Node* tail = last.node->prev;
+        // Cut [head, tail] out of `from`...
+        head->prev->next = last.node;
+        last.node->prev = head->prev;
+        // ...and link it in before pos.
+        Node* before = pos.node->prev;
+        before->next = head;
+        head->prev = before;
+        tail->next = pos.node;
+        pos.node->prev = tail;
+    }
+
+    // Moves the single node at `it` of `from` in before `pos`, in O(1).
+    void splice(iterator pos, IList& from, iterator it) { splice(pos, from, it, std::next(it)); }
+
+private:
+    using Traits = IListTraits<T, Parent>;
+
+    Node sentinel;
+    Parent* owner;
+    size_t count = 0;
+
+    T* nextNode(Node* n) { return n->next == &sentinel ? nullptr : static_cast<T*>(n->next); }
+
+    void link(Node* pos, Node* n) {
+        n->parent = owner;
+        n->next = pos;
+        n->prev = pos->prev;
+        pos->prev->next = n;
+        pos->prev = n;
+    }
+
+    static void unlink(Node* n) {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        n->prev = n->next = nullptr;
+    }
+};
@@ -1,131 +1,744 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <utility>
 #include <sstream>
+#include <stdexcept>
+#include <initializer_list>
 #include <iostream>
+#include <string_view>
 
-// --- 1. Type System (Minimal) ---
+#include "Arena.h"
+#include "IList.h"
+#include "Interner.h"
+
+// --- 1. Type System ---
+// Types are uniqued: the primitive ones are singletons and the derived ones
+// are hash-consed by IRContext, so two types are equal exactly when their
+// pointers are. A type holds only its structure; IRPrinter spells it out.
 class Type {
 public:
-    enum TypeID { IntTyID, VoidTyID, PointerTyID };
-    std::string irName;
+    enum TypeID { IntTyID, VoidTyID, PointerTyID, BoolTyID, ArrayTyID, FunctionTyID };
+    const TypeID id;
 
-    Type(TypeID id, const std::string& name) : id(id), irName(name) {}
+    explicit Type(TypeID id) : id(id) {}
+    Type(const Type&) = delete;
+    Type& operator=(const Type&) = delete;
     virtual ~Type() = default;
 
     static Type* getInt32Ty() {
-        static Type intType(IntTyID, "i32");
+        static Type intType(IntTyID);
         return &intType;
     }
+    static Type* getInt1Ty() {
+        static Type boolType(BoolTyID);
+        return &boolType;
+    }
     static Type* getVoidTy() {
-        static Type voidType(VoidTyID, "void");
+        static Type voidType(VoidTyID);
         return &voidType;
     }
-    const TypeID id;
+};
+
+// [numElements x elementType]; uniqued by IRContext::getArrayTy.
+class ArrayType : public Type {
+public:
+    Type* const elementType;
+    const uint64_t numElements;
+
+    ArrayType(Type* elementType, uint64_t numElements)
+        : Type(ArrayTyID), elementType(elementType), numElements(numElements) {}
+};
+
+// pointeeType*; uniqued by IRContext::getPointerTy.
+class PointerType : public Type {
+public:
+    Type* const pointeeType;
+
+    explicit PointerType(Type* pointeeType) : Type(PointerTyID), pointeeType(pointeeType) {}
+};
+
+// returnType (paramTypes...); uniqued by IRContext::getFunctionTy.
+class FunctionType : public Type {
+public:
+    Type* const returnType;
+    const std::vector<Type*> paramTypes;
+
+    FunctionType(Type* returnType, std::vector<Type*> paramTypes)
+        : Type(FunctionTyID), returnType(returnType), paramTypes(std::move(paramTypes)) {}
 };
 
 // --- 2. Value (Base Class) ---
+class BasicBlock;
+class ConstantInt;
+class Function;
+class Instruction;
+class UndefValue;
+class Use;
+class Value;
+
+// Told of every change to the body of the function it is attached to (see
+// Function::journal) as the change is made, so that it can be undone; see
+// ChangeJournal. Blocks and instructions erased meanwhile are handed to it,
+// unlinked, instead of being freed.
+class FunctionJournal {
+public:
+    virtual ~FunctionJournal() = default;
+
+    // `use` is about to point at another value.
+    virtual void operandChanged(Use* use) = 0;
+    // `inst` has just been linked into a block of the function.
+    virtual void instructionInserted(Instruction* inst) = 0;
+    // `inst` is about to be unlinked from its block; `next` follows it there
+    // (nullptr at the end).
+    virtual void instructionRemoved(Instruction* inst, Instruction* next) = 0;
+    virtual void blockInserted(BasicBlock* block) = 0;
+    virtual void blockRemoved(BasicBlock* block, BasicBlock* next) = 0;
+    virtual void instructionErased(Instruction* inst) = 0;
+    virtual void blockErased(BasicBlock* block) = 0;
+};
+
+// One operand slot of an Instruction: the edge from the instruction to the
+// Value it uses. Each Value threads the Uses that refer to it through an
+// intrusive doubly-linked list, so adding or dropping a use is O(1) and
+// replaceAllUsesWith() is O(number of uses).
+class Use {
+public:
+    Use() = default;
+    Use(const Use&) = delete;
+    Use& operator=(const Use&) = delete;
+    ~Use() { set(nullptr); }
+
+    Value* get() const { return val; }
+    Instruction* getUser() const { return user; }
+    // The next use of the same value, or nullptr.
+    Use* getNext() const { return next; }
+
+    // Points this operand at `value` (nullptr to clear it), moving it from
+    // the old value's use list to the new one's. Defined after Function, as
+    // the function's journal, if any, is told first.
+    inline void set(Value* value);
+
+private:
+    friend class Instruction;
+    friend class Value;
+
+    Value* val = nullptr;
+    Instruction* user = nullptr;
+    Use* next = nullptr;
+    Use** prev = nullptr; // the link that points at this Use
+};
+
+// Values carry no name string. Most are unnamed, and IRPrinter numbers
+// them (%0, %1, ...) as it prints; the few with a name in the source (a
+// function, a global, a local variable) hold its ID in their module's name
+// table (see Module::setName).
 class Value {
 public:
+    static constexpr uint32_t NO_NAME = Interner::NONE;
+
     Type* type;
-    std::string name;
+    uint32_t nameId = NO_NAME;
+    // Scratch number for whole-function passes, which number values here
+    // rather than in a hash map (see FunctionSnapshot and IRPrinter's
+    // SlotTracker). Only meaningful to the pass that last set it; mutable so
+    // that passes that only read the IR can use it too.
+    mutable uint32_t number = 0;
 
-    Value(Type* type, const std::string& name) : type(type), name(name) {}
-    virtual ~Value() = default;
-    virtual std::string to_string() const { return name; }
+    explicit Value(Type* type, uint32_t nameId = NO_NAME) : type(type), nameId(nameId) {}
+    Value(const Value&) = delete;
+    Value& operator=(const Value&) = delete;
+    // A value should outlive its uses; any left are cleared rather than
+    // left dangling.
+    virtual ~Value() {
+        for (Use* use = useList; use; use = use->next) {
+            use->val = nullptr;
+        }
+    }
+    // Checked downcasts without RTTI; non-null only for that class.
+    virtual ConstantInt* asConstantInt() { return nullptr; }
+    virtual UndefValue* asUndefValue() { return nullptr; }
+    virtual BasicBlock* asBasicBlock() { return nullptr; }
+    virtual Instruction* asInstruction() { return nullptr; }
+
+    // for (Use* use = value->firstUse(); use; use = use->getNext())
+    Use* firstUse() const { return useList; }
+    bool hasUses() const { return useList != nullptr; }
+    size_t getNumUses() const {
+        size_t count = 0;
+        for (Use* use = useList; use; use = use->next) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Makes every user of this value use `value` instead.
+    void replaceAllUsesWith(Value* value) {
+        if (value == this) {
+            return;
+        }
+        while (useList) {
+            useList->set(value);
+        }
+    }
+
+private:
+    friend class Use;
+    Use* useList = nullptr;
 };
 
+
 // Pointers for convenience
 using ValuePtr = Value*;
 using TypePtr = Type*;
 
-// --- 3. Instruction ---
-class Instruction : public Value {
+// --- 2b. Constants ---
+// Integer constant. Constants are uniqued per (type, value) by the module's
+// IRContext, so two constants are equal exactly when their pointers are.
+class ConstantInt : public Value {
+public:
+    const int64_t value;
+
+    ConstantInt(Type* type, int64_t value) : Value(type), value(value) {}
+
+    ConstantInt* asConstantInt() override { return this; }
+};
+
+// Placeholder for a value that could not be computed; one per type.
+class UndefValue : public Value {
 public:
-    std::string ir;
+    explicit UndefValue(Type* type) : Value(type) {}
+
+    UndefValue* asUndefValue() override { return this; }
+};
+
+// Owns the uniqued constants and derived types of a module; they live as
+// long as the module.
+class IRContext {
+public:
+    ConstantInt* getConstantInt(Type* type, int64_t value) {
+        std::unique_ptr<ConstantInt>& slot = constants[{type, value}];
+        if (!slot) {
+            slot = std::make_unique<ConstantInt>(type, value);
+        }
+        return slot.get();
+    }
+
+    ConstantInt* getInt32(int32_t value) { return getConstantInt(Type::getInt32Ty(), value); }
+
+    ArrayType* getArrayTy(Type* elementType, uint64_t numElements) {
+        std::unique_ptr<ArrayType>& slot = arrayTypes[{elementType, numElements}];
+        if (!slot) {
+            slot = std::make_unique<ArrayType>(elementType, numElements);
+        }
+        return slot.get();
+    }
 
-    Instruction(Type* type, const std::string& name, const std::string& irCode)
-        : Value(type, name), ir(irCode) {}
+    // elementType[dims[0]][dims[1]]...: [dims[0] x [dims[1] x ... elementType]].
+    // `dims` must not be empty.
+    template <typename N>
+    ArrayType* getArrayTy(Type* elementType, const std::vector<N>& dims) {
+        Type* type = elementType;
+        for (auto dim = dims.rbegin(); dim != dims.rend(); ++dim) {
+            type = getArrayTy(type, static_cast<uint64_t>(*dim));
+        }
+        return static_cast<ArrayType*>(type);
+    }
 
-    // For instructions that produce a result (like alloca, load)
-    std::string to_string() const override {
-        return name + " = " + ir;
+    PointerType* getPointerTy(Type* pointeeType) {
+        std::unique_ptr<PointerType>& slot = pointerTypes[pointeeType];
+        if (!slot) {
+            slot = std::make_unique<PointerType>(pointeeType);
+        }
+        return slot.get();
     }
-    // For instructions that don't produce a result (like store, ret)
-    std::string to_string_void() const {
-        return ir;
+
+    FunctionType* getFunctionTy(Type* returnType, const std::vector<Type*>& paramTypes) {
+        std::vector<Type*> key{returnType};
+        key.insert(key.end(), paramTypes.begin(), paramTypes.end());
+        std::unique_ptr<FunctionType>& slot = functionTypes[key];
+        if (!slot) {
+            slot = std::make_unique<FunctionType>(returnType, paramTypes);
+        }
+        return slot.get();
     }
+
+    UndefValue* getUndef(Type* type) {
+        std::unique_ptr<UndefValue>& slot = undefs[type];
+        if (!slot) {
+            slot = std::make_unique<UndefValue>(type);
+        }
+        return slot.get();
+    }
+
+private:
+    struct KeyHash {
+        template <typename N>
+        size_t operator()(const std::pair<Type*, N>& key) const {
+            return std::hash<const void*>()(key.first) * 31 + std::hash<N>()(key.second);
+        }
+        size_t operator()(const std::vector<Type*>& key) const {
+            size_t hash = key.size();
+            for (Type* type : key) {
+                hash = hash * 31 + std::hash<const void*>()(type);
+            }
+            return hash;
+        }
+    };
+    std::unordered_map<std::pair<Type*, int64_t>, std::unique_ptr<ConstantInt>, KeyHash> constants;
+    std::unordered_map<std::pair<Type*, uint64_t>, std::unique_ptr<ArrayType>, KeyHash> arrayTypes;
+    std::unordered_map<Type*, std::unique_ptr<PointerType>> pointerTypes;
+    std::unordered_map<std::vector<Type*>, std::unique_ptr<FunctionType>, KeyHash> functionTypes; // {ret, params...}
+    std::unordered_map<Type*, std::unique_ptr<UndefValue>> undefs;
 };
 
-// --- 4. BasicBlock ---
-class BasicBlock : public Value {
+// --- 2c. Global variables ---
+class Module;
+
+// A module-level variable; create one with Module::addGlobal. As a Value it
+// is the address of what it holds, so its type is a pointer to
+// getValueType().
+// Only read-only i32 data is emitted for now: const arrays, initialized
+// from a flattened row-major list of elements.
+class GlobalVariable : public Value {
 public:
-    std::vector<std::unique_ptr<Instruction>> instList;
+    std::string linkage; // e.g. "private unnamed_addr"; empty for external linkage
+    bool isConstant;
+    std::vector<int32_t> initializer;
+
+    GlobalVariable(Module* parent, PointerType* type, uint32_t nameId, const std::string& linkage,
+                   bool isConstant, std::vector<int32_t> initializer)
+        : Value(type, nameId), linkage(linkage), isConstant(isConstant), initializer(std::move(initializer)),
+          parent(parent) {}
+
+    Type* getValueType() const { return static_cast<PointerType*>(type)->pointeeType; }
+    Module* getParent() const { return parent; }
+
+private:
+    Module* parent;
+};
+
+// --- 3. Instruction ---
+class BasicBlock;
+class Function;
+
+// An opcode and a fixed list of operands. The instruction's type is that of
+// the value it produces (void for store and ret): a pointer for alloca and
+// getelementptr, which produce addresses. Text is produced only by
+// IRPrinter. getParent() is the block the instruction is in.
+//
+// Instructions, blocks and functions are allocated from their module's
+// Arena (see Module) and freed by the list that holds them. An instruction
+// is created with `new (arena, numOperands) Instruction(...)`, which makes
+// room for its operands right behind it: loads, stores and binary ops take
+// one allocation, not two.
+class Instruction : public Value, public IListNode<Instruction, BasicBlock> {
+public:
+    enum Opcode : uint8_t {
+        Alloca,        // ()
+        Load,          // (ptr)
+        Store,         // (value, ptr)
+        GetElementPtr, // (ptr, index...), inbounds
+        Add,           // (lhs, rhs)
+        Sub,
+        Mul,
+        SDiv,
+        SRem,
+        ICmp,          // (lhs, rhs), see ICmpInst
+        ZExt,          // (value)
+        Ret,           // () or (value)
+    };
+
+    // Up to this many operands are stored inline. Longer lists (a call with
+    // many arguments) spill to an array on the heap, which keeps inline
+    // instructions within the sizes the arena recycles.
+    static constexpr size_t MAX_INLINE_OPERANDS = 8;
+    // numOperands is 16 bits wide.
+    static constexpr size_t MAX_OPERANDS = UINT16_MAX;
+
+    const Opcode opcode;
+
+protected:
+    // State of a subclass (ICmpInst's predicate). Kept here rather than in
+    // the subclass, so every instruction with the same number of operands
+    // has the same size and erased ones can be recycled for each other.
+    uint8_t subclassData = 0;
+
+private:
+    uint16_t numOperands; // packed with the fields around it
+
+public:
+    static void* operator new(size_t size, Arena& arena, size_t numOperands) {
+        return arena.allocate(size + inlineOperandBytes(numOperands));
+    }
+    // Only reached if a constructor throws.
+    static void operator delete(void* p, Arena& arena, size_t numOperands) {
+        arena.recycle(p, sizeof(Instruction) + inlineOperandBytes(numOperands));
+    }
+    // The memory belongs to the arena, and IListTraits<Instruction,
+    // BasicBlock> recycles it; `delete` only runs the destructor.
+    static void operator delete(void*) {}
 
-    BasicBlock(const std::string& name) : Value(Type::getVoidTy(), name) {}
-    void addInstruction(std::unique_ptr<Instruction> inst) {
-        instList.push_back(std::move(inst));
+    // `numOperands` must be the count passed to operator new. More than
+    // MAX_OPERANDS throws std::length_error.
+    Instruction(Opcode opcode, Type* type, std::initializer_list<Value*> operands)
+        : Instruction(opcode, type, operands.begin(), operands.size()) {}
+
+    Instruction(Opcode opcode, Type* type, Value* const* operands, size_t numOperands)
+        : Value(type), opcode(opcode), numOperands(checkedOperandCount(numOperands)),
+          operandList(numOperands <= MAX_INLINE_OPERANDS ? inlineOperands() : new Use[numOperands]) {
+        for (size_t i = 0; i < numOperands; ++i) {
+            if (hasInlineOperands()) {
+                new (&operandList[i]) Use();
+            }
+            operandList[i].user = this;
+            operandList[i].set(operands[i]);
+        }
     }
 
-    std::string to_string() const override {
-        std::stringstream ss;
-        ss << name << ":\n";
-        for (const auto& inst : instList) {
-            ss << "  ";
-            if (inst->type->id != Type::VoidTyID && !inst->name.empty()) {
-                ss << inst->to_string() << "\n";
-            } else {
-                ss << inst->to_string_void() << "\n";
+    Instruction* asInstruction() override { return this; }
+
+    ~Instruction() override {
+        if (hasInlineOperands()) {
+            for (size_t i = 0; i < numOperands; ++i) {
+                operandList[i].~Use();
             }
+        } else {
+            delete[] operandList;
+        }
+    }
+
+    size_t getNumOperands() const { return numOperands; }
+    Value* getOperand(size_t i) const { return operandList[i].get(); }
+    void setOperand(size_t i, Value* value) { operandList[i].set(value); }
+    Use& getOperandUse(size_t i) { return operandList[i]; }
+
+    bool isBinaryOp() const { return opcode >= Add && opcode <= SRem; }
+
+    // Bytes taken in the arena, operands included.
+    size_t getAllocSize() const { return sizeof(Instruction) + inlineOperandBytes(numOperands); }
+
+    // A copy with the same operands, in no block yet, allocated from `arena`.
+    inline Instruction* clone(Arena& arena) const;
+
+    // The journal of the function this instruction is in, if it has one.
+    inline FunctionJournal* getJournal() const;
+
+    // Unlinks this instruction from its block and frees it.
+    inline void eraseFromParent();
+    // Unlinks this instruction from its block and hands it to the caller,
+    // who must insert it into a block of the same module again.
+    inline Instruction* removeFromParent();
+    // Moves this instruction in front of `pos`, which may be in another block.
+    inline void moveBefore(Instruction* pos);
+    // Moves this instruction to the end of `block`.
+    inline void moveToEnd(BasicBlock* block);
+
+    // Clears every operand, taking this instruction off the use lists of the
+    // values it uses. Done for a whole function before it is destroyed, so
+    // no instruction outlives the values it refers to.
+    void dropAllReferences() {
+        for (size_t i = 0; i < numOperands; ++i) {
+            operandList[i].set(nullptr);
+        }
+    }
+
+private:
+    Use* operandList; // inlineOperands() or a heap array
+
+    static uint16_t checkedOperandCount(size_t numOperands) {
+        if (numOperands > MAX_OPERANDS) {
+            throw std::length_error("Instruction: more than " + std::to_string(MAX_OPERANDS) + " operands");
         }
-        return ss.str();
+        return static_cast<uint16_t>(numOperands);
     }
-    const std::vector<std::unique_ptr<Instruction>>& getInstList() const { return instList; }
+
+    static size_t inlineOperandBytes(size_t numOperands) {
+        return numOperands <= MAX_INLINE_OPERANDS ? numOperands * sizeof(Use) : 0;
+    }
+    // Right behind the object; subclasses add no fields (see below).
+    Use* inlineOperands() { return reinterpret_cast<Use*>(reinterpret_cast<char*>(this) + sizeof(Instruction)); }
+    bool hasInlineOperands() { return operandList == inlineOperands(); }
 };
 
-// --- 5. Function ---
-class Function : public Value {
+// icmp <predicate> lhs, rhs; yields i1.
+class ICmpInst : public Instruction {
 public:
-    std::string linkage; 
-    std::vector<std::unique_ptr<BasicBlock>> blockList;
+    enum Predicate : uint8_t { EQ, NE, SGT, SGE, SLT, SLE };
 
-    Function(Type* retType, const std::string& name)
-        : Value(retType, "@" + name), linkage("define") {
-        blockList.push_back(std::make_unique<BasicBlock>("mainEntry"));
+    ICmpInst(Predicate predicate, Value* lhs, Value* rhs) : Instruction(ICmp, Type::getInt1Ty(), {lhs, rhs}) {
+        subclassData = predicate;
     }
 
-    std::string to_string() const override {
-        std::stringstream ss;
-        ss << linkage << " " << type->irName << " " << name << "() {\n";
-        for (const auto& block : blockList) {
-            ss << block->to_string();
+    Predicate getPredicate() const { return static_cast<Predicate>(subclassData); }
+};
+
+static_assert(sizeof(ICmpInst) == sizeof(Instruction), "instruction subclasses must not add fields");
+static_assert(sizeof(Instruction) % alignof(Use) == 0, "inline operands must be aligned");
+static_assert(sizeof(Instruction) == 72, "Instruction grew");
+
+template <>
+struct IListTraits<Instruction, BasicBlock> {
+    static inline void deleteNode(BasicBlock* owner, Instruction* inst);
+    static inline void nodeInserted(BasicBlock* owner, Instruction* inst);
+    static inline void nodeRemoved(BasicBlock* owner, Instruction* inst, Instruction* next);
+};
+
+// --- 4. BasicBlock ---
+// getParent() is the function the block is in.
+class BasicBlock : public Value, public IListNode<BasicBlock, Function> {
+public:
+    using InstListType = IList<Instruction, BasicBlock>;
+
+    InstListType instList{this};
+
+    explicit BasicBlock(uint32_t nameId = NO_NAME) : Value(Type::getVoidTy(), nameId) {}
+    BasicBlock* asBasicBlock() override { return this; }
+    ~BasicBlock() override {
+        for (Instruction& inst : instList) {
+            inst.dropAllReferences();
+        }
+    }
+
+    void addInstruction(Instruction* inst) { instList.push_back(inst); }
+
+    const InstListType& getInstList() const { return instList; }
+
+    // The journal of the function this block is in, if it has one.
+    inline FunctionJournal* getJournal() const;
+};
+
+inline void Instruction::eraseFromParent() {
+    getParent()->instList.erase(BasicBlock::InstListType::iteratorTo(this));
+}
+
+inline Instruction* Instruction::removeFromParent() {
+    return getParent()->instList.remove(BasicBlock::InstListType::iteratorTo(this));
+}
+
+inline void Instruction::moveBefore(Instruction* pos) {
+    auto it = BasicBlock::InstListType::iteratorTo(this);
+    pos->getParent()->instList.splice(BasicBlock::InstListType::iteratorTo(pos), getParent()->instList, it);
+}
+
+inline void Instruction::moveToEnd(BasicBlock* block) {
+    block->instList.splice(block->instList.end(), getParent()->instList, BasicBlock::InstListType::iteratorTo(this));
+}
+
+template <>
+struct IListTraits<BasicBlock, Function> {
+    static inline void deleteNode(Function* owner, BasicBlock* block);
+    static inline void nodeInserted(Function* owner, BasicBlock* block);
+    static inline void nodeRemoved(Function* owner, BasicBlock* block, BasicBlock* next);
+};
+
+// --- 5. Function ---
+// getParent() is the module the function is in; create one with
+// Module::addFunction. As a Value it is the function's address, so its type
+// is a pointer to getFunctionType().
+class Function : public Value, public IListNode<Function, Module> {
+public:
+    std::string linkage; 
+    IList<BasicBlock, Function> blockList{this};
+    // While set, told of each change to the blocks and instructions of the
+    // function (see ChangeJournal).
+    FunctionJournal* journal = nullptr;
+
+    Function(PointerType* type, uint32_t nameId) : Value(type, nameId), linkage("define") {}
+    ~Function() override {
+        assert(!journal && "function destroyed while a journal is attached");
+        // Uses may cross blocks: unlink all of them before any block goes.
+        for (BasicBlock& block : blockList) {
+            for (Instruction& inst : block.instList) {
+                inst.dropAllReferences();
+            }
         }
-        ss << "}\n";
-        return ss.str();
     }
-    BasicBlock* getEntryBlock() const { return blockList[0].get(); }
+
+    FunctionType* getFunctionType() const { return static_cast<FunctionType*>(static_cast<PointerType*>(type)->pointeeType); }
+    Type* getReturnType() const { return getFunctionType()->returnType; }
+
+    BasicBlock* getEntryBlock() { return &blockList.front(); }
+    const BasicBlock* getEntryBlock() const { return &blockList.front(); }
+
+    // Adds an empty block at the end of the function; unnamed blocks are
+    // numbered when printed.
+    inline BasicBlock* appendBlock(std::string_view name = {});
+    // Unlinks this function from its module and frees it.
+    inline void eraseFromParent();
+};
+
+template <>
+struct IListTraits<Function, Module> : IListCallbacks<Function, Module> {
+    static inline void deleteNode(Module* owner, Function* func);
 };
 
 // --- 6. Module (Top-Level Container) ---
 class Module {
+    // Declared first so constants outlive the functions that use them.
+    IRContext context;
+    // Holds every function, block and instruction of the module. Nodes that
+    // are erased go back to its free lists for reuse; the rest is released
+    // in bulk with the module, after the functions below are destroyed.
+    Arena arena;
+
 public:
-    std::vector<std::unique_ptr<Function>> funcList;
+    // Globals before functions, so they too are destroyed after their users.
+    std::vector<std::unique_ptr<GlobalVariable>> globalList;
+    IList<Function, Module> funcList{this};
 
-    void addFunction(std::unique_ptr<Function> func) {
-        funcList.push_back(std::move(func));
+    IRContext& getContext() { return context; }
+    Arena& getArena() { return arena; }
+
+    // Names are interned in a table of the module's own, so naming a value
+    // allocates nothing once its spelling has been seen. Local names need
+    // not be unique: IRPrinter tells repeats apart.
+    uint32_t internName(std::string_view name) { return name.empty() ? Value::NO_NAME : names.intern(name); }
+    void setName(Value* value, std::string_view name) { value->nameId = internName(name); }
+    // Empty for an unnamed value.
+    std::string_view getName(const Value* value) const {
+        return value->nameId == Value::NO_NAME ? std::string_view() : names.spelling(value->nameId);
+    }
+
+    // Adds a global, renaming it "<name>.<n>" if `name` is already taken.
+    GlobalVariable* addGlobal(Type* valueType, std::string_view name, const std::string& linkage,
+                              bool isConstant, std::vector<int32_t> initializer) {
+        uint32_t nameId = internName(name);
+        for (int n = 1; !globalNames.insert(nameId).second; ++n) {
+            nameId = internName(std::string(name) + "." + std::to_string(n));
+        }
+        globalList.push_back(std::make_unique<GlobalVariable>(this, context.getPointerTy(valueType), nameId,
+                                                              linkage, isConstant, std::move(initializer)));
+        return globalList.back().get();
     }
 
-    std::string to_string() const {
-        std::stringstream ss;
-        ss << "; ModuleID = 'moudle'\n";
-        ss << "source_filename = \"moudle\"\n\n";
+    // Adds a function with an empty entry block at the end of the module.
+    Function* addFunction(FunctionType* type, std::string_view name) {
+        Function* func = arena.create<Function>(context.getPointerTy(type), internName(name));
+        funcList.push_back(func);
+        func->appendBlock("mainEntry");
+        return func;
+    }
 
-        for (const auto& func : funcList) {
-            ss << func->to_string() << "\n";
+private:
+    Interner names;
+    std::unordered_set<uint32_t> globalNames; // name IDs
+};
+
+inline BasicBlock* Function::appendBlock(std::string_view name) {
+    Module* module = getParent();
+    BasicBlock* block = module->getArena().create<BasicBlock>(module->internName(name));
+    blockList.push_back(block);
+    return block;
+}
+
+inline void Function::eraseFromParent() {
+    getParent()->funcList.erase(IList<Function, Module>::iteratorTo(this));
+}
+
+inline void Use::set(Value* value) {
+    if (value != val && user) {
+        if (FunctionJournal* journal = user->getJournal()) {
+            journal->operandChanged(this);
+        }
+    }
+    if (val) {
+        *prev = next;
+        if (next) {
+            next->prev = prev;
         }
-        return ss.str();
     }
-};
\ No newline at end of file
+    val = value;
+    if (value) {
+        next = value->useList;
+        if (next) {
+            next->prev = &next;
+        }
+        prev = &value->useList;
+        value->useList = this;
+    }
+}
+
+inline Instruction* Instruction::clone(Arena& arena) const {
+    if (opcode == ICmp) {
+        return new (arena, 2) ICmpInst(static_cast<const ICmpInst*>(this)->getPredicate(), getOperand(0), getOperand(1));
+    }
+    Value* inlineOperands[MAX_INLINE_OPERANDS];
+    std::vector<Value*> spilled;
+    Value** operands = inlineOperands;
+    if (numOperands > MAX_INLINE_OPERANDS) {
+        spilled.resize(numOperands);
+        operands = spilled.data();
+    }
+    for (size_t i = 0; i < numOperands; ++i) {
+        operands[i] = getOperand(i);
+    }
+    return new (arena, numOperands) Instruction(opcode, type, operands, numOperands);
+}
+
+inline FunctionJournal* Instruction::getJournal() const {
+    BasicBlock* block = getParent();
+    return block ? block->getJournal() : nullptr;
+}
+
+inline FunctionJournal* BasicBlock::getJournal() const {
+    Function* func = getParent();
+    return func ? func->journal : nullptr;
+}
+
+// A node keeps its parent while it is erased, so the chain up to the module
+// is intact here. With a journal attached, erased nodes go to it instead.
+inline void IListTraits<Instruction, BasicBlock>::deleteNode(BasicBlock* owner, Instruction* inst) {
+    if (FunctionJournal* journal = owner->getJournal()) {
+        journal->instructionErased(inst);
+        return;
+    }
+    size_t size = inst->getAllocSize();
+    inst->~Instruction();
+    owner->getParent()->getParent()->getArena().recycle(inst, size);
+}
+
+inline void IListTraits<Instruction, BasicBlock>::nodeInserted(BasicBlock* owner, Instruction* inst) {
+    if (FunctionJournal* journal = owner->getJournal()) {
+        journal->instructionInserted(inst);
+    }
+}
+
+inline void IListTraits<Instruction, BasicBlock>::nodeRemoved(BasicBlock* owner, Instruction* inst,
+                                                              Instruction* next) {
+    if (FunctionJournal* journal = owner->getJournal()) {
+        journal->instructionRemoved(inst, next);
+    }
+}
+
+inline void IListTraits<BasicBlock, Function>::deleteNode(Function* owner, BasicBlock* block) {
+    if (owner->journal) {
+        owner->journal->blockErased(block);
+        return;
+    }
+    owner->getParent()->getArena().destroy(block);
+}
+
+inline void IListTraits<BasicBlock, Function>::nodeInserted(Function* owner, BasicBlock* block) {
+    if (owner->journal) {
+        owner->journal->blockInserted(block);
+    }
+}
+
+inline void IListTraits<BasicBlock, Function>::nodeRemoved(Function* owner, BasicBlock* block, BasicBlock* next) {
+    if (owner->journal) {
+        owner->journal->blockRemoved(block, next);
+    }
+}
+
+inline void IListTraits<Function, Module>::deleteNode(Module* owner, Function* func) {
+    owner->getArena().destroy(func);
+}
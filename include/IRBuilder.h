@@ -1,7 +1,10 @@
 #pragma once
 
 #include "IR.h"
-#include <string>
+#include <initializer_list>
+#include <memory>
+#include <string_view>
+#include <vector>
 
 // Forward declarations
 class Function;
@@ -10,64 +13,85 @@ class BasicBlock;
 class IRBuilder {
 private:
     BasicBlock* currentBlock = nullptr;
-    int regCounter = 0;
-
-    // Helper to generate unique virtual register names like %1, %2, %a1, etc.
-    std::string nextName() {
-        return "%" + std::to_string(regCounter++);
-    }
 
 public:
+    // Results are created unnamed; IRPrinter numbers them (%0, %1, ...).
     void setInsertPoint(BasicBlock* block) {
         currentBlock = block;
     }
 
-    void reset() {
-        regCounter = 0;
+    // 1. ALLOCA (Allocate memory for local variables): %a = alloca i32
+    ValuePtr CreateAlloca(TypePtr type, std::string_view varName = {}) {
+        // The result is the address, of type `type`*. It is named after the
+        // variable (%a); the name is interned, not copied.
+        ValuePtr address = insert(Instruction::Alloca, context().getPointerTy(type), {});
+        module().setName(address, varName);
+        return address;
     }
 
-    // 1. ALLOCA (Allocate memory for local variables)
-    ValuePtr CreateAlloca(TypePtr type, const std::string& varName) {
-        // Alloca result is an i32* (pointer to i32).
-        // For simplicity, we use the variable name as the LLVM address name (%a).
-        std::string name = "%" + varName;
-        std::string irCode = "alloca i32, align 4";
-        
-        // We set the instruction's *result* type to i32 (the pointer target is implicit in the instruction).
-        auto inst = std::make_unique<Instruction>(Type::getInt32Ty(), name, irCode); 
-        ValuePtr result = inst.get();
-        currentBlock->addInstruction(std::move(inst));
-        return result;
+    // 2. STORE (Saves a value to an address): store i32 %v, i32* %a
+    void CreateStore(ValuePtr value, ValuePtr ptr) {
+        insert(Instruction::Store, Type::getVoidTy(), {value, ptr});
+    }
+
+    // 3. LOAD (Loads a value from an address): %n = load i32, i32* %a
+    ValuePtr CreateLoad(ValuePtr ptr) {
+        // The result has the type the address points to.
+        return insert(Instruction::Load, static_cast<PointerType*>(ptr->type)->pointeeType, {ptr});
     }
 
-    // 2. STORE (Saves a value to an address)
-    void CreateStore(int constantValue, ValuePtr ptr) {
-        // ptr->to_string() gets the name of the memory location, e.g., %a
-        // The pointer type is implicitly i32* in our simplified world.
-        std::string irCode = "store i32 " + std::to_string(constantValue) + 
-                             ", i32* " + ptr->to_string() + ", align 4";
-        currentBlock->addInstruction(std::make_unique<Instruction>(Type::getVoidTy(), "", irCode));
+    // 4. RET (Returns a value from the function): ret i32 %v
+    void CreateRet(ValuePtr value) {
+        insert(Instruction::Ret, Type::getVoidTy(), {value});
     }
 
+    // ret void
+    void CreateRetVoid() {
+        insert(Instruction::Ret, Type::getVoidTy(), {});
+    }
 
-    // 3. LOAD (Loads a value from an address)
-    ValuePtr CreateLoad(ValuePtr ptr) {
-        // The result of load is the value itself (i32).
-        TypePtr loadedType = Type::getInt32Ty(); 
-        std::string name = nextName(); // Generates %a1, %a2 etc.
-        // ptr->to_string() gets the name of the address (%a)
-        std::string irCode = "load i32, i32* " + ptr->to_string() + ", align 4";
-
-        auto inst = std::make_unique<Instruction>(loadedType, name, irCode);
-        ValuePtr result = inst.get();
-        currentBlock->addInstruction(std::move(inst));
-        return result;
+    // 5. Binary arithmetic: %n = add i32 %a, %b (Add, Sub, Mul, SDiv, SRem)
+    ValuePtr CreateBinary(Instruction::Opcode opcode, ValuePtr lhs, ValuePtr rhs) {
+        return insert(opcode, Type::getInt32Ty(), {lhs, rhs});
     }
 
-    // 4. RET (Returns a value from the function)
-    void CreateRet(ValuePtr value) {
-        // value->to_string() gets the value name, e.g., %a1
-        std::string irCode = "ret i32 " + value->to_string();
-        currentBlock->addInstruction(std::make_unique<Instruction>(Type::getVoidTy(), "", irCode));
+    // 6. Integer compare: %n = icmp slt i32 %a, %b (result is i1)
+    ValuePtr CreateICmp(ICmpInst::Predicate predicate, ValuePtr lhs, ValuePtr rhs) {
+        return insert(new (arena(), 2) ICmpInst(predicate, lhs, rhs));
     }
-};
\ No newline at end of file
+
+    // 7. Widen an i1 to i32: %n = zext i1 %c to i32
+    ValuePtr CreateZExt(ValuePtr value) {
+        return insert(Instruction::ZExt, Type::getInt32Ty(), {value});
+    }
+
+    // 8. Element address: %n = getelementptr inbounds [4 x i32], [4 x i32]* @a, i32 0, i32 %i
+    // `ptr` points to a `sourceType`. The result points to that type with one
+    // array level stripped per index after the first.
+    ValuePtr CreateInBoundsGEP(TypePtr sourceType, ValuePtr ptr, const std::vector<ValuePtr>& indices) {
+        TypePtr resultType = sourceType;
+        for (size_t i = 1; i < indices.size() && resultType->id == Type::ArrayTyID; ++i) {
+            resultType = static_cast<ArrayType*>(resultType)->elementType;
+        }
+        std::vector<ValuePtr> operands{ptr};
+        operands.insert(operands.end(), indices.begin(), indices.end());
+        TypePtr type = context().getPointerTy(resultType);
+        return insert(new (arena(), operands.size())
+                          Instruction(Instruction::GetElementPtr, type, operands.data(), operands.size()));
+    }
+
+private:
+    ValuePtr insert(Instruction::Opcode opcode, TypePtr type, std::initializer_list<ValuePtr> operands) {
+        return insert(new (arena(), operands.size()) Instruction(opcode, type, operands));
+    }
+
+    ValuePtr insert(Instruction* inst) {
+        currentBlock->addInstruction(inst);
+        return inst;
+    }
+
+    // Instructions are allocated from the module's arena.
+    Module& module() { return *currentBlock->getParent()->getParent(); }
+    Arena& arena() { return module().getArena(); }
+    IRContext& context() { return module().getContext(); }
+};
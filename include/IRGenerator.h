@@ -1,7 +1,15 @@
 #pragma once
 #include <any>
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include "ConstEvaluator.h"
+#include "ExpWalker.h"
 #include "IR.h"
 #include "IRBuilder.h"
+#include "IRPrinter.h"
+#include "Interner.h"
+#include "SlabTokenStream.h"
 #include "SymbolTable.h"
 
 // ANTLR Generated Headers (Assuming you ran 'make antlr')
@@ -11,27 +19,77 @@
 
 class IRGenerator : public SysYParserBaseVisitor {
 public:
-    IRGenerator() : module(std::make_unique<Module>()) {}
+    // Identifiers are keyed by their ID in `interner`. When the tree was
+    // parsed from a SlabTokenStream built over the same interner, pass it as
+    // `tokens` and the IDs assigned at lex time are used as they are.
+    explicit IRGenerator(Interner& interner, SlabTokenStream* tokens = nullptr)
+        : module(std::make_unique<Module>()), interner(interner), tokens(tokens),
+          evaluator([this](antlr4::tree::TerminalNode* ident) -> const ConstValue* {
+              SymbolInfo* info = symbolTable.lookup(getSymbol(ident));
+              return info ? info->constant : nullptr;
+          }) {}
     
     std::string getIR() const {
-        return module->to_string();
+        return IRPrinter::toString(*module);
+    }
+
+    // Writes the whole module to `os`, without building it as a string.
+    void printIR(OutputStream& os) const {
+        IRPrinter::print(*module, os);
+    }
+
+    const Module& getModule() const { return *module; }
+
+    // Streaming mode: lowers one top-level decl / funcDef the way
+    // visitCompUnit would, writes the finished function to `os` and drops it
+    // from the module. IRPrinter::header() is the caller's to write.
+    // Globals (const arrays) are written as they are created; they stay in
+    // the module because later items refer to them.
+    void emitTopLevel(antlr4::ParserRuleContext* item, OutputStream& os) {
+        bool isFunction = item->getRuleIndex() == SysYParser::RuleFuncDef;
+        if (!isFunction && item->getRuleIndex() != SysYParser::RuleDecl) {
+            return;
+        }
+        visit(item);
+        for (; globalsWritten < module->globalList.size(); ++globalsWritten) {
+            IRPrinter::print(*module->globalList[globalsWritten], os);
+            os << "\n";
+            globalsPending = true;
+        }
+        if (isFunction) {
+            if (globalsPending) {
+                os << "\n"; // as in IRPrinter::print(const Module&)
+                globalsPending = false;
+            }
+            Function& func = module->funcList.back();
+            IRPrinter::print(func, os);
+            os << "\n";
+            func.eraseFromParent();
+        }
     }
 
 private:
     std::unique_ptr<Module> module;
     IRBuilder builder;
+    Interner& interner;
+    SlabTokenStream* tokens;
     SymbolTable symbolTable;
+    std::deque<ConstValue> constants; // referenced by SymbolInfo::constant
+    ConstEvaluator evaluator;
     Function* currentFunction = nullptr;
+    size_t globalsWritten = 0; // emitTopLevel
+    bool globalsPending = false;
 
     // Helper: Gets the text of a terminal node (e.g., IDENT, IntConst)
     std::string getTokenText(antlr4::tree::TerminalNode* node) {
         return node->getSymbol()->getText();
     }
 
-    // Helper: Extracts integer value from IntConst token
-    int getIntValue(antlr4::tree::TerminalNode* node) {
-        std::string text = getTokenText(node);
-        return std::stoi(text); // Basic decimal integer parsing
+    // Helper: Gets the interned ID of an IDENT node
+    uint32_t getSymbol(antlr4::tree::TerminalNode* node) {
+        antlr4::Token* token = node->getSymbol();
+        uint32_t symbol = tokens ? tokens->symbolOf(token) : Interner::NONE;
+        return symbol != Interner::NONE ? symbol : interner.intern(token->getText());
     }
 
 public:
@@ -39,9 +97,11 @@ public:
     
     // Visit CompUnit: Top-level node
     antlrcpp::Any visitCompUnit(SysYParser::CompUnitContext *ctx) override {
-        // Only interested in funcDef for now
-        for (auto funcDef : ctx->funcDef()) {
-            visit(funcDef);
+        // In source order, so functions see the consts declared before them
+        for (auto child : ctx->children) {
+            if (isRule(child)) {
+                visit(child);
+            }
         }
         return nullptr; 
     }
@@ -49,16 +109,13 @@ public:
     // Visit FuncDef: int main() { ... }
     antlrcpp::Any visitFuncDef(SysYParser::FuncDefContext *ctx) override {
         TypePtr retType = (ctx->funcType()->VOID() != nullptr) ? Type::getVoidTy() : Type::getInt32Ty();
-        std::string funcName = getTokenText(ctx->IDENT());
+        std::string_view funcName = interner.spelling(getSymbol(ctx->IDENT()));
         
         // 1. Create Function object
-        auto func = std::make_unique<Function>(retType, funcName);
-        currentFunction = func.get();
-        module->addFunction(std::move(func));
+        currentFunction = module->addFunction(module->getContext().getFunctionTy(retType, {}), funcName);
 
         // 2. Setup Scope and Builder
         symbolTable.enterScope(); 
-        builder.reset();
         builder.setInsertPoint(currentFunction->getEntryBlock());
 
         // 3. Visit the function block
@@ -82,6 +139,14 @@ public:
     
     // Visit VarDecl: int a = 1;
     antlrcpp::Any visitVarDecl(SysYParser::VarDeclContext *ctx) override {
+        if (!currentFunction) {
+            // Global variables are not lowered yet; uses of them then report
+            // undefined variables.
+            for (auto varDef : ctx->varDef()) {
+                std::cerr << "Error: Unsupported global variable " << interner.spelling(getSymbol(varDef->IDENT())) << std::endl;
+            }
+            return nullptr;
+        }
         // SysY allows multiple varDefs in one varDecl, loop through them
         for (auto varDef : ctx->varDef()) {
             visit(varDef);
@@ -93,38 +158,85 @@ public:
     antlrcpp::Any visitVarDef(SysYParser::VarDefContext *ctx) override {
         // Check for initialization (ASSIGN token presence)
         if (ctx->ASSIGN()) { 
-            std::string varName = getTokenText(ctx->IDENT());
+            uint32_t symbol = getSymbol(ctx->IDENT());
+            std::string_view varName = interner.spelling(symbol);
             TypePtr varType = Type::getInt32Ty();
 
             // 1. Allocate memory for the local variable: %a = alloca i32
             ValuePtr varAddress = builder.CreateAlloca(varType, varName);
             
-            // 2. We assume the initVal is a direct integer constant expression (for this simple step)
-            // ctx->initVal()->exp() is guaranteed to exist if ASSIGN is present.
+            // 2. Scalar initializer: evaluate the expression and store it
+            // ctx->initVal()->exp() is null for a braced initializer list.
             SysYParser::ExpContext* expCtx = ctx->initVal()->exp();
-            
-            // We check if the expression is a simple number literal (NumberExp context)
-            if (auto numExpCtx = dynamic_cast<SysYParser::NumberExpContext*>(expCtx)) {
-                int initVal = getIntValue(numExpCtx->number()->IntConst());
-                // 3. Store the initial value: store i32 1, i32* %a
-                builder.CreateStore(initVal, varAddress);
-            } 
-            // TODO: For a complete implementation, recursive visit(ctx->initVal()) is needed.
+            if (expCtx) {
+                // 3. Store the initial value: store i32 %v, i32* %a
+                builder.CreateStore(lowerExp(expCtx), varAddress);
+            }
+            // TODO: Braced initializer lists (arrays) are not lowered yet.
             
             // 4. Add the variable's address to the symbol table
-            if (!symbolTable.addSymbol(varName, varType, varAddress)) {
+            if (!symbolTable.addSymbol(symbol, varType, varAddress)) {
                 std::cerr << "Error: Redefinition of local variable " << varName << std::endl;
             }
         }
         return nullptr;
     }
 
+    // Visit ConstDecl: const int N = 10, A[N] = {...};
+    antlrcpp::Any visitConstDecl(SysYParser::ConstDeclContext *ctx) override {
+        for (auto constDef : ctx->constDef()) {
+            visit(constDef);
+        }
+        return nullptr;
+    }
+
+    // Visit ConstDef: evaluated entirely at compile time. A scalar becomes an
+    // immediate wherever it is used; an array becomes read-only global data.
+    antlrcpp::Any visitConstDef(SysYParser::ConstDefContext *ctx) override {
+        std::string name = getTokenText(ctx->IDENT());
+        ConstValue value;
+        size_t elements = 1;
+        for (auto dimCtx : ctx->constExp()) {
+            int32_t dim;
+            if (!evaluator.eval(dimCtx->exp(), dim) || dim <= 0 ||
+                elements * static_cast<size_t>(dim) > static_cast<size_t>(INT32_MAX)) {
+                std::cerr << "Error: Invalid array dimension " << dimCtx->getText() << " of " << name << std::endl;
+                return nullptr;
+            }
+            value.dims.push_back(static_cast<uint32_t>(dim));
+            elements *= static_cast<size_t>(dim);
+        }
+        if (!evaluator.evalInitializer(ctx->constInitVal(), value)) {
+            std::cerr << "Error: Initializer of const " << name << " is not a compile-time constant" << std::endl;
+            return nullptr;
+        }
+        constants.push_back(std::move(value));
+        const ConstValue& constant = constants.back();
+
+        TypePtr type = Type::getInt32Ty();
+        ValuePtr storage;
+        if (constant.dims.empty()) {
+            storage = getConstant(constant.elements[0]);
+        } else {
+            type = module->getContext().getArrayTy(type, constant.dims);
+            // Local const arrays are hoisted the way clang does it.
+            storage = currentFunction
+                ? module->addGlobal(type, "__const." + std::string(module->getName(currentFunction)) + "." + name,
+                                    "private unnamed_addr", true, constant.elements)
+                : module->addGlobal(type, name, "", true, constant.elements);
+        }
+        if (!symbolTable.addSymbol(getSymbol(ctx->IDENT()), type, storage, &constant)) {
+            std::cerr << "Error: Redefinition of const " << name << std::endl;
+        }
+        return nullptr;
+    }
+
     // Visit ReturnStmt: return exp;
     antlrcpp::Any visitReturnStmt(SysYParser::ReturnStmtContext *ctx) override {
         // Assumes integer function return
         if (ctx->exp()) {
-            // 1. Visit the expression (e.g., 'a' in 'return a;') to get its value
-            ValuePtr returnVal = std::any_cast<ValuePtr>(visit(ctx->exp()));
+            // 1. Lower the expression (e.g., 'a' in 'return a;') to get its value
+            ValuePtr returnVal = lowerExp(ctx->exp());
 
             // 2. Generate the return instruction: ret i32 %a1
             builder.CreateRet(returnVal);
@@ -132,34 +244,197 @@ public:
         return nullptr;
     }
 
-    // --- Expression Implementations (Minimal for the example) ---
+    // Statements this generator does not lower yet are still walked for
+    // the declarations inside them, but never into an expression: those are
+    // only lowered through lowerExp(), and descending into a deep one here
+    // would recurse once per nesting level.
+    antlrcpp::Any visitChildren(antlr4::tree::ParseTree *node) override {
+        if (isRule(node) && static_cast<antlr4::ParserRuleContext*>(node)->getRuleIndex() == SysYParser::RuleExp) {
+            return defaultResult();
+        }
+        return SysYParserBaseVisitor::visitChildren(node);
+    }
+
+    // --- Expressions ---
+    //
+    // Expressions are not lowered through the std::any visitor but by an
+    // ExpWalker, which reads children by position (no boxing, no RTTI, no
+    // dynamic_cast in the generated accessors) and keeps pending operands on
+    // a heap stack, so nesting depth costs no native stack. The member
+    // functions below are its visitor callbacks.
+    ValuePtr lowerExp(SysYParser::ExpContext* ctx) {
+        return expWalker.walk(ctx);
+    }
+
+private:
+    friend class ExpWalker<IRGenerator>;
+    using Result = ValuePtr;
+
+    ExpWalker<IRGenerator> expWalker{*this};
+
+    static bool isToken(antlr4::tree::ParseTree* node) {
+        return node->getTreeType() == antlr4::tree::ParseTreeType::TERMINAL;
+    }
+    static bool isRule(antlr4::tree::ParseTree* node) {
+        return node->getTreeType() == antlr4::tree::ParseTreeType::RULE;
+    }
+
+    // Same text as ctx->getText() (the tokens' text, concatenated), gathered
+    // without recursion.
+    static std::string textOf(antlr4::ParserRuleContext* ctx) {
+        std::string text;
+        std::vector<antlr4::tree::ParseTree*> pending{ctx};
+        while (!pending.empty()) {
+            antlr4::tree::ParseTree* node = pending.back();
+            pending.pop_back();
+            if (isRule(node)) {
+                pending.insert(pending.end(), node->children.rbegin(), node->children.rend());
+            } else {
+                text += node->getText();
+            }
+        }
+        return text;
+    }
+
+    ValuePtr unsupported(antlr4::ParserRuleContext* ctx) {
+        std::cerr << "Error: Unsupported expression " << textOf(ctx) << std::endl;
+        return module->getContext().getUndef(Type::getInt32Ty());
+    }
+
+    // lVal: a variable access (e.g., 'a' in 'return a;'). Returns true when
+    // the index expressions are needed, i.e. for an element of a const array;
+    // lVal() then takes it from there.
+    bool enterLVal(SysYParser::LValContext* ctx, ValuePtr& out) {
+        uint32_t symbol = getSymbol(static_cast<antlr4::tree::TerminalNode*>(ctx->children[0]));
 
-    // Visit LValExp: expression is a variable access (e.g., 'a' in 'return a;')
-    antlrcpp::Any visitLValExp(SysYParser::LValExpContext *ctx) override {
-        // Note: For this simple stage, we assume lVal is a simple identifier without array access
-        std::string varName = getTokenText(ctx->lVal()->IDENT());
-        
         // 1. Look up the variable's memory address (%a)
-        SymbolInfo* info = symbolTable.lookup(varName);
+        SymbolInfo* info = symbolTable.lookup(symbol);
+        if (!info) {
+            std::cerr << "Error: Undefined variable reference " << interner.spelling(symbol) << std::endl;
+            out = module->getContext().getUndef(Type::getInt32Ty());
+            return false;
+        }
+        if (info->constant) {
+            // A const scalar is its immediate.
+            if (ctx->children.size() != 1 + 3 * info->constant->dims.size()) {
+                out = unsupported(ctx); // partially indexed arrays are not lowered yet
+                return false;
+            }
+            out = info->value;
+            return !info->constant->dims.empty();
+        }
+        // Note: For this simple stage, lVal must be a plain identifier without array access
+        if (ctx->children.size() != 1) {
+            out = unsupported(ctx);
+            return false;
+        }
+        // 2. Generate LOAD instruction: %a1 = load i32, i32* %a
+        out = builder.CreateLoad(info->value);
+        return false;
+    }
 
-        if (info) {
-            // 2. Generate LOAD instruction: %a1 = load i32, i32* %a
-            ValuePtr value = builder.CreateLoad(info->value);
-            return value; // Return the loaded value (%a1)
-        } else {
-            std::cerr << "Error: Undefined variable reference " << varName << std::endl;
-            // Throw an error or return a placeholder in a real compiler
-            return new Value(Type::getInt32Ty(), "undef");
+    // An element of a const array: folded when every index is constant, and
+    // loaded from the global data otherwise.
+    ValuePtr lVal(SysYParser::LValContext* ctx, const ValuePtr* indexValues, size_t count) {
+        const SymbolInfo& info = *symbolTable.lookup(getSymbol(static_cast<antlr4::tree::TerminalNode*>(ctx->children[0])));
+        const ConstValue& constant = *info.constant;
+        std::vector<ValuePtr> indices{getConstant(0)};
+        size_t offset = 0;
+        bool folded = true;
+        for (size_t d = 0; d < count; ++d) {
+            ConstantInt* constIndex = indexValues[d]->asConstantInt();
+            folded = folded && constIndex && constIndex->value >= 0 && constIndex->value < constant.dims[d];
+            if (folded) {
+                offset = offset * constant.dims[d] + static_cast<size_t>(constIndex->value);
+            }
+            indices.push_back(indexValues[d]);
+        }
+        if (folded) {
+            return getConstant(constant.elements[offset]);
         }
+        return builder.CreateLoad(builder.CreateInBoundsGEP(info.type, info.value, indices));
     }
 
-    // Visit NumberExp: expression is a constant number (e.g., 1)
-    antlrcpp::Any visitNumberExp(SysYParser::NumberExpContext *ctx) override {
-        // Get the integer literal value.
-        std::string text = getTokenText(ctx->number()->IntConst());
-        
-        // In LLVM IR, a constant is its own Value.
-        // We return a temporary Value object representing the constant.
-        return (ValuePtr) new Value(Type::getInt32Ty(), text); 
+    // number: an integer literal, which in LLVM IR is its own (uniqued) Value
+    ValuePtr number(SysYParser::NumberContext* ctx) {
+        if (ctx->children.empty() || !isToken(ctx->children[0])) {
+            return unsupported(ctx);
+        }
+        // IntConst is decimal digits only; wrap modulo 2^32 like the i32 it
+        // becomes (2147483648 in -2147483648 is INT_MIN).
+        uint32_t value = 0;
+        for (char c : getTokenText(static_cast<antlr4::tree::TerminalNode*>(ctx->children[0]))) {
+            value = value * 10 + static_cast<uint32_t>(c - '0');
+        }
+        return getConstant(static_cast<int32_t>(value));
+    }
+
+    ValuePtr getConstant(int32_t value) { return module->getContext().getInt32(value); }
+
+    // (PLUS | MINUS | NOT) exp
+    ValuePtr unary(size_t op, ValuePtr operand) {
+        if (ConstantInt* constant = operand->asConstantInt()) {
+            return getConstant(ConstEvaluator::applyUnary(op, static_cast<int32_t>(constant->value)));
+        }
+        switch (op) {
+        case SysYParser::MINUS:
+            return builder.CreateBinary(Instruction::Sub, getConstant(0), operand);
+        case SysYParser::NOT:
+            return builder.CreateZExt(builder.CreateICmp(ICmpInst::EQ, operand, getConstant(0)));
+        default: // PLUS
+            return operand;
+        }
+    }
+
+    // The instruction for a binary operator: an arithmetic opcode, or ICmp
+    // with a predicate. False for && and ||.
+    static bool binaryInstruction(size_t op, Instruction::Opcode& opcode, ICmpInst::Predicate& predicate) {
+        opcode = Instruction::ICmp;
+        predicate = ICmpInst::EQ;
+        switch (op) {
+        case SysYParser::PLUS: opcode = Instruction::Add; break;
+        case SysYParser::MINUS: opcode = Instruction::Sub; break;
+        case SysYParser::MUL: opcode = Instruction::Mul; break;
+        case SysYParser::DIV: opcode = Instruction::SDiv; break;
+        case SysYParser::MOD: opcode = Instruction::SRem; break;
+        case SysYParser::LT: predicate = ICmpInst::SLT; break;
+        case SysYParser::GT: predicate = ICmpInst::SGT; break;
+        case SysYParser::LE: predicate = ICmpInst::SLE; break;
+        case SysYParser::GE: predicate = ICmpInst::SGE; break;
+        case SysYParser::EQ: predicate = ICmpInst::EQ; break;
+        case SysYParser::NEQ: predicate = ICmpInst::NE; break;
+        default: return false;
+        }
+        return true;
+    }
+
+    bool enterBinary(SysYParser::ExpContext* ctx, size_t op, ValuePtr& out) {
+        Instruction::Opcode opcode;
+        ICmpInst::Predicate predicate;
+        if (!binaryInstruction(op, opcode, predicate)) {
+            out = unsupported(ctx); // && and || need short-circuit control flow
+            return false;
+        }
+        return true;
+    }
+
+    // exp op exp: arithmetic yields i32; comparisons yield i1, widened back
+    // to i32 since SysY has no boolean type.
+    ValuePtr binary(SysYParser::ExpContext*, size_t op, ValuePtr lhs, ValuePtr rhs) {
+        // Constant operands fold, as in LLVM's IRBuilder (not x / 0, which stays an sdiv)
+        ConstantInt* lhsConst = lhs->asConstantInt();
+        ConstantInt* rhsConst = rhs->asConstantInt();
+        int32_t folded;
+        if (lhsConst && rhsConst &&
+            ConstEvaluator::applyBinary(op, static_cast<int32_t>(lhsConst->value), static_cast<int32_t>(rhsConst->value), folded)) {
+            return getConstant(folded);
+        }
+        Instruction::Opcode opcode;
+        ICmpInst::Predicate predicate;
+        binaryInstruction(op, opcode, predicate);
+        if (opcode != Instruction::ICmp) {
+            return builder.CreateBinary(opcode, lhs, rhs);
+        }
+        return builder.CreateZExt(builder.CreateICmp(predicate, lhs, rhs));
     }
-};
\ No newline at end of file
+};
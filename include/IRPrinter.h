@@ -0,0 +1,455 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "IR.h"
+#include "OutputStream.h"
+
+// Names the blocks and instructions of one function as they are printed,
+// the way LLVM's printer does. Unnamed blocks and unnamed non-void
+// instructions are numbered %0, %1, ... in order. Named ones keep their
+// name, except that a name seen before in the function gets a ".<n>"
+// suffix that no other local has (a variable redeclared in a nested scope
+// becomes %a, %a.1, ...). Each value's number, or the index of its spelled
+// out name, is kept in Value::number, so printing a reference to it is a
+// load and a write; the tracker is valid until the function changes.
+class SlotTracker {
+public:
+    explicit SlotTracker(const Function& func) : func(func), module(*func.getParent()) {
+        std::unordered_set<uint32_t> seen;             // name IDs
+        std::unordered_set<std::string_view> taken;    // every name in the function, once there is a repeat
+        std::unordered_map<uint32_t, uint32_t> suffix; // name ID -> last suffix tried
+        uint32_t slot = 0;
+        forEachLocal([&](const Value& value) {
+            if (value.nameId == Value::NO_NAME) {
+                value.number = slot++;
+                return;
+            }
+            std::string_view name = module.getName(&value);
+            if (!seen.insert(value.nameId).second) {
+                if (taken.empty()) {
+                    forEachLocal([&](const Value& other) {
+                        if (other.nameId != Value::NO_NAME) {
+                            taken.insert(module.getName(&other));
+                        }
+                    });
+                }
+                uint32_t& n = suffix[value.nameId];
+                std::string unique;
+                do {
+                    unique = std::string(name) + "." + std::to_string(++n);
+                } while (taken.count(unique));
+                renamed.push_back(std::move(unique));
+                taken.insert(renamed.back());
+                name = renamed.back();
+            }
+            value.number = NAMED | static_cast<uint32_t>(spellingStart.size() - 1);
+            namedLocals.emplace_back(&value, name);
+            spellings += '%';
+            appendName(spellings, name);
+            spellingStart.push_back(static_cast<uint32_t>(spellings.size()));
+        });
+    }
+
+    SlotTracker(const SlotTracker&) = delete;
+    SlotTracker& operator=(const SlotTracker&) = delete;
+
+    const Module& getModule() const { return module; }
+
+    // Each named block and instruction with the name it is printed under,
+    // unquoted, in function order.
+    const std::vector<std::pair<const Value*, std::string_view>>& getNamedLocals() const { return namedLocals; }
+
+    // "%name" or "%N" for an instruction or block of the function.
+    void printLocal(const Instruction& inst, OutputStream& os) const {
+        const BasicBlock* block = inst.getParent();
+        if (!block || block->getParent() != &func || inst.type->id == Type::VoidTyID) {
+            os << "<badref>";
+        } else {
+            printSlot(inst.number, os);
+        }
+    }
+    void printLocal(const BasicBlock& block, OutputStream& os) const {
+        if (block.getParent() != &func) {
+            os << "<badref>";
+        } else {
+            printSlot(block.number, os);
+        }
+    }
+
+    // "name" or "N", as a block's label.
+    void printLabel(const BasicBlock& block, OutputStream& os) const {
+        if (block.number & NAMED) {
+            std::string_view spelling = spelled(block.number & ~NAMED);
+            os << spelling.substr(1);
+        } else {
+            os << block.number;
+        }
+    }
+
+    // A global's name, spelled as appendName() does.
+    static void printName(std::string_view name, OutputStream& os) {
+        if (isPlain(name)) {
+            os << name;
+        } else {
+            std::string quoted;
+            appendName(quoted, name);
+            os << quoted;
+        }
+    }
+
+private:
+    static constexpr uint32_t NAMED = 1u << 31; // Value::number is an index into spellings
+
+    const Function& func;
+    const Module& module;
+    std::string spellings;                   // "%name" for each named value, back to back
+    std::vector<uint32_t> spellingStart{0}; // where each starts, plus the end
+    std::deque<std::string> renamed;         // names with a suffix; views into it stay valid
+    std::vector<std::pair<const Value*, std::string_view>> namedLocals;
+
+    std::string_view spelled(uint32_t index) const {
+        return std::string_view(spellings).substr(spellingStart[index], spellingStart[index + 1] - spellingStart[index]);
+    }
+
+    template <typename F>
+    void forEachLocal(F f) const {
+        for (const BasicBlock& block : func.blockList) {
+            f(block);
+            for (const Instruction& inst : block.instList) {
+                if (inst.type->id != Type::VoidTyID) {
+                    f(inst);
+                }
+            }
+        }
+    }
+
+    void printSlot(uint32_t number, OutputStream& os) const {
+        if (number & NAMED) {
+            os << spelled(number & ~NAMED);
+        } else {
+            os << '%' << number;
+        }
+    }
+
+    // Appends `name`, in quotes if it is not a plain identifier (one that
+    // starts with a digit would read as a number).
+    static void appendName(std::string& out, std::string_view name) {
+        if (isPlain(name)) {
+            out += name;
+            return;
+        }
+        static const char hex[] = "0123456789ABCDEF";
+        out += '"';
+        for (char c : name) {
+            auto byte = static_cast<unsigned char>(c);
+            if (byte >= 0x20 && byte < 0x7F && c != '"' && c != '\\') {
+                out += c;
+            } else {
+                out += '\\';
+                out += hex[byte >> 4];
+                out += hex[byte & 15];
+            }
+        }
+        out += '"';
+    }
+
+    static bool isPlain(std::string_view name) {
+        return !name.empty() && !isDigit(name[0]) &&
+               std::all_of(name.begin(), name.end(), [](char c) { return isIdentifierChar(c); });
+    }
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static bool isIdentifierChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isDigit(c) || c == '-' || c == '$' || c == '.' ||
+               c == '_';
+    }
+};
+
+// Writes IR as LLVM assembly (.ll) straight into an OutputStream. The IR
+// classes hold only structure; all of the textual syntax lives here, and
+// local values get their names or numbers from a SlotTracker only now.
+class IRPrinter {
+public:
+    // Printed once at the top of the module, before any global or function.
+    static const char* header() {
+        return "; ModuleID = 'moudle'\nsource_filename = \"moudle\"\n\n";
+    }
+
+    static void print(const Module& module, OutputStream& os) {
+        os << header();
+        for (const auto& global : module.globalList) {
+            print(*global, os);
+            os << "\n";
+        }
+        if (!module.globalList.empty()) {
+            os << "\n";
+        }
+        for (const Function& func : module.funcList) {
+            print(func, os);
+            os << "\n";
+        }
+    }
+
+    static std::string toString(const Module& module) {
+        std::string text;
+        {
+            StringOutputStream os(text);
+            print(module, os);
+        }
+        return text;
+    }
+
+    // One line, without the newline.
+    static void print(const GlobalVariable& global, OutputStream& os) {
+        os << '@';
+        SlotTracker::printName(global.getParent()->getName(&global), os);
+        os << " = ";
+        if (!global.linkage.empty()) {
+            os << global.linkage << " ";
+        }
+        os << (global.isConstant ? "constant " : "global ");
+        printType(global.getValueType(), os);
+        os << " ";
+        printInitializer(global, global.getValueType(), 0, os);
+        os << ", align 4";
+    }
+
+    // The function must be in its module, which holds the names.
+    static void print(const Function& func, OutputStream& os) {
+        SlotTracker slots(func);
+        os << func.linkage << " ";
+        printType(func.getReturnType(), os);
+        os << " @";
+        SlotTracker::printName(slots.getModule().getName(&func), os);
+        os << "(";
+        const std::vector<Type*>& params = func.getFunctionType()->paramTypes;
+        for (size_t i = 0; i < params.size(); ++i) {
+            os << (i ? ", " : "");
+            printType(params[i], os);
+        }
+        os << ") {\n";
+        for (const BasicBlock& block : func.blockList) {
+            print(block, slots, os);
+        }
+        os << "}\n";
+    }
+
+    // A block or instruction on its own is numbered as part of its whole
+    // function, which takes a pass over the function.
+    static void print(const BasicBlock& block, OutputStream& os) { print(block, SlotTracker(*block.getParent()), os); }
+
+    // One line, without the indent or the newline.
+    static void print(const Instruction& inst, OutputStream& os) {
+        print(inst, SlotTracker(*inst.getParent()->getParent()), os);
+    }
+
+    static void print(const BasicBlock& block, const SlotTracker& slots, OutputStream& os) {
+        slots.printLabel(block, os);
+        os << ":\n";
+        for (const Instruction& inst : block.instList) {
+            os << "  ";
+            print(inst, slots, os);
+            os << "\n";
+        }
+    }
+
+    static void print(const Instruction& inst, const SlotTracker& slots, OutputStream& os) {
+        if (inst.type->id != Type::VoidTyID) {
+            slots.printLocal(inst, os);
+            os << " = ";
+        }
+        switch (inst.opcode) {
+        case Instruction::Alloca:
+            os << "alloca ";
+            printType(pointeeType(&inst), os);
+            os << ", align 4";
+            break;
+        case Instruction::Load:
+            os << "load ";
+            printType(inst.type, os);
+            os << ", ";
+            printOperand(inst.getOperand(0), slots, os);
+            os << ", align 4";
+            break;
+        case Instruction::Store:
+            os << "store ";
+            printOperand(inst.getOperand(0), slots, os);
+            os << ", ";
+            printOperand(inst.getOperand(1), slots, os);
+            os << ", align 4";
+            break;
+        case Instruction::GetElementPtr: {
+            Value* ptr = inst.getOperand(0);
+            os << "getelementptr inbounds ";
+            printType(pointeeType(ptr), os);
+            os << ", ";
+            printOperand(ptr, slots, os);
+            for (size_t i = 1; i < inst.getNumOperands(); ++i) {
+                os << ", ";
+                printOperand(inst.getOperand(i), slots, os);
+            }
+            break;
+        }
+        case Instruction::Add:
+        case Instruction::Sub:
+        case Instruction::Mul:
+        case Instruction::SDiv:
+        case Instruction::SRem:
+            os << opcodeName(inst.opcode) << " ";
+            printOperand(inst.getOperand(0), slots, os);
+            os << ", ";
+            printValueName(inst.getOperand(1), slots, os);
+            break;
+        case Instruction::ICmp:
+            os << "icmp " << predicateName(static_cast<const ICmpInst&>(inst).getPredicate()) << " ";
+            printOperand(inst.getOperand(0), slots, os);
+            os << ", ";
+            printValueName(inst.getOperand(1), slots, os);
+            break;
+        case Instruction::ZExt:
+            os << "zext ";
+            printOperand(inst.getOperand(0), slots, os);
+            os << " to ";
+            printType(inst.type, os);
+            break;
+        case Instruction::Ret:
+            if (inst.getNumOperands() == 0) {
+                os << "ret void";
+            } else {
+                os << "ret ";
+                printOperand(inst.getOperand(0), slots, os);
+            }
+            break;
+        }
+    }
+
+    static const char* opcodeName(Instruction::Opcode opcode) {
+        switch (opcode) {
+        case Instruction::Alloca: return "alloca";
+        case Instruction::Load: return "load";
+        case Instruction::Store: return "store";
+        case Instruction::GetElementPtr: return "getelementptr";
+        case Instruction::Add: return "add";
+        case Instruction::Sub: return "sub";
+        case Instruction::Mul: return "mul";
+        case Instruction::SDiv: return "sdiv";
+        case Instruction::SRem: return "srem";
+        case Instruction::ICmp: return "icmp";
+        case Instruction::ZExt: return "zext";
+        case Instruction::Ret: return "ret";
+        }
+        return "";
+    }
+
+    static const char* predicateName(ICmpInst::Predicate predicate) {
+        switch (predicate) {
+        case ICmpInst::EQ: return "eq";
+        case ICmpInst::NE: return "ne";
+        case ICmpInst::SGT: return "sgt";
+        case ICmpInst::SGE: return "sge";
+        case ICmpInst::SLT: return "slt";
+        case ICmpInst::SLE: return "sle";
+        }
+        return "";
+    }
+
+    // Types are spelled out only here, as they are printed.
+    static void printType(const Type* type, OutputStream& os) {
+        switch (type->id) {
+        case Type::IntTyID:
+            os << "i32";
+            break;
+        case Type::BoolTyID:
+            os << "i1";
+            break;
+        case Type::VoidTyID:
+            os << "void";
+            break;
+        case Type::ArrayTyID: {
+            auto* array = static_cast<const ArrayType*>(type);
+            os << "[" << array->numElements << " x ";
+            printType(array->elementType, os);
+            os << "]";
+            break;
+        }
+        case Type::PointerTyID:
+            printType(static_cast<const PointerType*>(type)->pointeeType, os);
+            os << "*";
+            break;
+        case Type::FunctionTyID: {
+            auto* function = static_cast<const FunctionType*>(type);
+            printType(function->returnType, os);
+            os << " (";
+            for (size_t i = 0; i < function->paramTypes.size(); ++i) {
+                os << (i ? ", " : "");
+                printType(function->paramTypes[i], os);
+            }
+            os << ")";
+            break;
+        }
+        }
+    }
+
+private:
+    // "i32 %v"
+    static void printOperand(const Value* value, const SlotTracker& slots, OutputStream& os) {
+        printType(value->type, os);
+        os << " ";
+        printValueName(value, slots, os);
+    }
+
+    // "%v", "@g", "42" or "undef"
+    static void printValueName(const Value* value, const SlotTracker& slots, OutputStream& os) {
+        auto* v = const_cast<Value*>(value); // the asX() casts are not const
+        if (Instruction* inst = v->asInstruction()) {
+            slots.printLocal(*inst, os);
+        } else if (ConstantInt* constant = v->asConstantInt()) {
+            os << constant->value;
+        } else if (BasicBlock* block = v->asBasicBlock()) {
+            slots.printLocal(*block, os);
+        } else if (v->asUndefValue()) {
+            os << "undef";
+        } else {
+            os << '@';
+            SlotTracker::printName(slots.getModule().getName(value), os);
+        }
+    }
+
+    static Type* pointeeType(const Value* ptr) { return static_cast<PointerType*>(ptr->type)->pointeeType; }
+
+    // Writes the initializer of the aggregate of `type` whose first element
+    // is global.initializer[offset], in LLVM constant syntax.
+    static void printInitializer(const GlobalVariable& global, Type* type, size_t offset, OutputStream& os) {
+        if (type->id != Type::ArrayTyID) {
+            os << global.initializer[offset];
+            return;
+        }
+        auto* array = static_cast<ArrayType*>(type);
+        size_t stride = 1;
+        for (Type* t = array->elementType; t->id == Type::ArrayTyID; t = static_cast<ArrayType*>(t)->elementType) {
+            stride *= static_cast<ArrayType*>(t)->numElements;
+        }
+        auto first = global.initializer.begin() + static_cast<std::ptrdiff_t>(offset);
+        auto last = first + static_cast<std::ptrdiff_t>(stride * array->numElements);
+        if (std::all_of(first, last, [](int32_t v) { return v == 0; })) {
+            os << "zeroinitializer";
+            return;
+        }
+        os << "[";
+        for (uint64_t i = 0; i < array->numElements; ++i) {
+            os << (i ? ", " : "");
+            printType(array->elementType, os);
+            os << " ";
+            printInitializer(global, array->elementType, offset + i * stride, os);
+        }
+        os << "]";
+    }
+};
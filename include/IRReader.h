@@ -0,0 +1,686 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "IR.h"
+#include "IRBuilder.h"
+#include "IRPrinter.h"
+#include "OutputStream.h"
+
+// Reads LLVM assembly back into a Module: the subset IRPrinter writes, i.e.
+// globals with i32 initializers and functions made of the instructions in
+// Instruction::Opcode. Printing what it reads from the printer's output
+// gives the same text, so IR can be saved once and fed to passes
+// (tools/sysy-opt.cpp) without running the frontend again.
+//
+// Like LLVM's parser it checks what it reads: values are defined before
+// they are used and with the type the use spells out, names are not
+// redefined, and unnamed values are numbered in order (%0, %1, ...). Unlike
+// it, a block runs to the next label or the closing brace, terminator or
+// not, as blocks may in a Module. The first error ends the parse.
+class IRReader {
+public:
+    // The module in `text`, or nullptr with `error` set to
+    // "<line>:<column>: <message>".
+    static std::unique_ptr<Module> parse(std::string_view text, std::string& error) {
+        IRReader reader(text);
+        try {
+            reader.parseModule();
+        } catch (const ParseError& e) {
+            error = reader.location(e.pos) + ": " + e.message;
+            return nullptr;
+        }
+        return std::move(reader.module);
+    }
+
+private:
+    struct ParseError {
+        size_t pos;
+        std::string message;
+    };
+
+    // A name after its sigil or as a label; `text` views the input, or
+    // `scratch` if the name was quoted.
+    struct Name {
+        std::string_view text;
+        bool quoted;
+
+        bool isNumber() const {
+            return !quoted && !text.empty() && text.find_first_not_of("0123456789") == std::string_view::npos;
+        }
+    };
+
+    std::string_view text;
+    size_t pos = 0;
+    std::unique_ptr<Module> module = std::make_unique<Module>();
+    IRBuilder builder;
+    std::unordered_map<std::string_view, Value*> globals; // globals and functions; keys view the module's names
+    std::string scratch;                                 // the last quoted name, unescaped
+
+    // The function being read.
+    Function* func = nullptr;
+    std::unordered_map<std::string_view, Value*> locals; // named blocks and instructions
+    std::vector<Value*> numbered;                        // %0, %1, ...
+
+    explicit IRReader(std::string_view text) : text(text) {}
+
+    IRContext& context() { return module->getContext(); }
+
+    // --- Errors ---
+
+    [[noreturn]] void fail(std::string message) { failAt(pos, std::move(message)); }
+    [[noreturn]] void failAt(size_t at, std::string message) { throw ParseError{at, std::move(message)}; }
+
+    std::string location(size_t at) const {
+        size_t line = 1;
+        size_t lineStart = 0;
+        for (size_t i = 0; i < at && i < text.size(); ++i) {
+            if (text[i] == '\n') {
+                ++line;
+                lineStart = i + 1;
+            }
+        }
+        return std::to_string(line) + ":" + std::to_string(at - lineStart + 1);
+    }
+
+    static std::string typeName(const Type* type) {
+        std::string name;
+        StringOutputStream os(name);
+        IRPrinter::printType(type, os);
+        return os.str();
+    }
+
+    // --- Tokens ---
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static bool isWordChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isDigit(c) || c == '_' || c == '.';
+    }
+    // As in SlotTracker::isIdentifierChar.
+    static bool isNameChar(char c) { return isWordChar(c) || c == '-' || c == '$'; }
+    static int hexValue(char c) {
+        if (isDigit(c)) {
+            return c - '0';
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    }
+
+    // Skips blanks, line breaks and ; comments.
+    void skipSpace() {
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                ++pos;
+            } else if (c == ';') {
+                while (pos < text.size() && text[pos] != '\n') {
+                    ++pos;
+                }
+            } else {
+                break;
+            }
+        }
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return pos == text.size();
+    }
+
+    char peek() {
+        skipSpace();
+        return pos < text.size() ? text[pos] : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    // A keyword or type name; empty if there is none here.
+    std::string_view word() {
+        skipSpace();
+        size_t start = pos;
+        while (pos < text.size() && isWordChar(text[pos])) {
+            ++pos;
+        }
+        return text.substr(start, pos - start);
+    }
+
+    bool consumeWord(std::string_view expected) {
+        size_t start = pos;
+        if (word() == expected) {
+            return true;
+        }
+        pos = start;
+        return false;
+    }
+
+    void expectWord(std::string_view expected) {
+        if (!consumeWord(expected)) {
+            fail("expected '" + std::string(expected) + "'");
+        }
+    }
+
+    int64_t integer() {
+        skipSpace();
+        size_t start = pos;
+        bool negative = pos < text.size() && text[pos] == '-';
+        pos += negative;
+        size_t digits = pos;
+        uint64_t magnitude = 0;
+        while (pos < text.size() && isDigit(text[pos])) {
+            if (magnitude > (uint64_t(INT64_MAX) - 9) / 10) {
+                failAt(start, "integer constant is too large");
+            }
+            magnitude = magnitude * 10 + static_cast<uint64_t>(text[pos++] - '0');
+        }
+        if (pos == digits) {
+            failAt(start, "expected integer");
+        }
+        return negative ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+    }
+
+    // The name right after a sigil, or a label: a run of identifier
+    // characters, or a quoted string with \XX escapes.
+    Name name() {
+        if (pos < text.size() && text[pos] == '"') {
+            size_t start = pos++;
+            scratch.clear();
+            for (;;) {
+                if (pos >= text.size() || text[pos] == '\n') {
+                    failAt(start, "unterminated name");
+                }
+                char c = text[pos++];
+                if (c == '"') {
+                    break;
+                }
+                if (c != '\\') {
+                    scratch += c;
+                } else if (pos + 1 < text.size() && hexValue(text[pos]) >= 0 && hexValue(text[pos + 1]) >= 0) {
+                    scratch += static_cast<char>(hexValue(text[pos]) * 16 + hexValue(text[pos + 1]));
+                    pos += 2;
+                } else {
+                    fail("invalid escape in name");
+                }
+            }
+            if (scratch.empty()) {
+                failAt(start, "empty name");
+            }
+            return {scratch, true};
+        }
+        size_t start = pos;
+        while (pos < text.size() && isNameChar(text[pos])) {
+            ++pos;
+        }
+        if (pos == start) {
+            fail("expected name");
+        }
+        return {text.substr(start, pos - start), false};
+    }
+
+    // A label ("name:") if one starts here; otherwise nothing is consumed.
+    std::optional<Name> label() {
+        skipSpace();
+        size_t start = pos;
+        if (pos < text.size() && (text[pos] == '"' || isNameChar(text[pos]))) {
+            Name result = name();
+            if (pos < text.size() && text[pos] == ':') {
+                ++pos;
+                return result;
+            }
+        }
+        pos = start;
+        return std::nullopt;
+    }
+
+    // --- Types and values ---
+
+    Type* type() {
+        skipSpace();
+        size_t start = pos;
+        Type* result = nullptr;
+        if (consume('[')) {
+            int64_t count = integer();
+            if (count < 0) {
+                failAt(start, "invalid array size");
+            }
+            expectWord("x");
+            Type* element = type();
+            if (element->id == Type::VoidTyID || element->id == Type::FunctionTyID) {
+                failAt(start, "invalid array element type");
+            }
+            expect(']');
+            result = context().getArrayTy(element, static_cast<uint64_t>(count));
+        } else {
+            std::string_view w = word();
+            if (w == "i32") {
+                result = Type::getInt32Ty();
+            } else if (w == "i1") {
+                result = Type::getInt1Ty();
+            } else if (w == "void") {
+                result = Type::getVoidTy();
+            } else {
+                failAt(start, "expected type");
+            }
+        }
+        for (;;) {
+            if (consume('*')) {
+                if (result->id == Type::VoidTyID) {
+                    failAt(start, "pointers to void are invalid");
+                }
+                result = context().getPointerTy(result);
+            } else if (consume('(')) {
+                std::vector<Type*> params;
+                if (!consume(')')) {
+                    do {
+                        params.push_back(type());
+                    } while (consume(','));
+                    expect(')');
+                }
+                result = context().getFunctionTy(result, params);
+            } else {
+                return result;
+            }
+        }
+    }
+
+    // A value of type `type`: a local, a global, an integer or undef.
+    Value* value(Type* type) {
+        skipSpace();
+        size_t start = pos;
+        Value* result = nullptr;
+        if (consume('%')) {
+            result = local(name(), start);
+        } else if (consume('@')) {
+            Name n = name();
+            auto found = globals.find(n.text);
+            if (found == globals.end()) {
+                failAt(start, "use of undefined value '@" + std::string(n.text) + "'");
+            }
+            result = found->second;
+        } else if (peek() == '-' || isDigit(peek())) {
+            return constant(type, integer(), start);
+        } else {
+            std::string_view w = word();
+            if (w == "undef") {
+                if (type->id == Type::VoidTyID || type->id == Type::FunctionTyID) {
+                    failAt(start, "invalid type for undef");
+                }
+                return context().getUndef(type);
+            }
+            if (w == "true" || w == "false") {
+                return constant(type, w == "true", start);
+            }
+            failAt(start, "expected value");
+        }
+        if (result->type != type) {
+            failAt(start, "'" + std::string(text.substr(start, pos - start)) + "' defined with type '" +
+                              typeName(result->type) + "' but expected '" + typeName(type) + "'");
+        }
+        return result;
+    }
+
+    Value* constant(Type* type, int64_t value, size_t at) {
+        if (type == Type::getInt32Ty()) {
+            if (value < INT32_MIN || value > UINT32_MAX) {
+                failAt(at, "integer constant does not fit in i32");
+            }
+            return context().getInt32(static_cast<int32_t>(static_cast<uint32_t>(value)));
+        }
+        if (type == Type::getInt1Ty()) {
+            if (value < -1 || value > 1) {
+                failAt(at, "integer constant does not fit in i1");
+            }
+            return context().getConstantInt(type, value & 1);
+        }
+        failAt(at, "integer constant must have integer type");
+    }
+
+    // A pointer to `pointee` and the value it spells out.
+    Value* pointer(Type* pointee) {
+        skipSpace();
+        size_t start = pos;
+        Type* expected = context().getPointerTy(pointee);
+        if (type() != expected) {
+            failAt(start, "expected '" + typeName(expected) + "'");
+        }
+        return value(expected);
+    }
+
+    Value* local(Name n, size_t at) {
+        if (n.isNumber()) {
+            size_t index = std::stoul(std::string(n.text));
+            if (index < numbered.size()) {
+                return numbered[index];
+            }
+        } else if (auto found = locals.find(n.text); found != locals.end()) {
+            return found->second;
+        }
+        failAt(at, "use of undefined value '%" + std::string(n.text) + "'");
+    }
+
+    // Gives a block or instruction of the function its name, or its number.
+    void defineLocal(Value* value, Name n, size_t at) {
+        if (n.isNumber()) {
+            if (n.text != std::to_string(numbered.size())) {
+                failAt(at, "value expected to be numbered '%" + std::to_string(numbered.size()) + "'");
+            }
+            module->setName(value, {});
+            numbered.push_back(value);
+            return;
+        }
+        if (locals.count(n.text)) {
+            failAt(at, "multiple definition of local value named '" + std::string(n.text) + "'");
+        }
+        module->setName(value, n.text);
+        locals.emplace(module->getName(value), value);
+    }
+
+    void optionalAlign() {
+        if (consume(',')) {
+            expectWord("align");
+            integer();
+        }
+    }
+
+    // --- Module ---
+
+    void parseModule() {
+        while (!atEnd()) {
+            size_t start = pos;
+            if (text[pos] == '@') {
+                parseGlobal();
+                continue;
+            }
+            std::string_view w = word();
+            if (w == "define") {
+                parseFunction();
+            } else if (w == "source_filename") {
+                expect('=');
+                skipSpace();
+                if (consume('"')) {
+                    pos = text.find('"', pos);
+                }
+                if (pos == std::string_view::npos) {
+                    failAt(start, "unterminated string");
+                }
+                expect('"');
+            } else {
+                failAt(start, "expected top-level entity");
+            }
+        }
+    }
+
+    // @name = [linkage...] (global | constant) <type> <initializer>[, align N]
+    void parseGlobal() {
+        size_t start = pos++;
+        std::string name(this->name().text);
+        if (globals.count(name)) {
+            failAt(start, "redefinition of global '@" + name + "'");
+        }
+        expect('=');
+        std::string linkage;
+        bool isConstant = false;
+        for (;;) {
+            skipSpace();
+            size_t wordStart = pos;
+            std::string_view w = word();
+            if (w == "global" || w == "constant") {
+                isConstant = w == "constant";
+                break;
+            }
+            // The words GlobalVariable::linkage may hold.
+            if (w != "private" && w != "internal" && w != "unnamed_addr" && w != "local_unnamed_addr") {
+                failAt(wordStart, "expected 'global' or 'constant'");
+            }
+            linkage += linkage.empty() ? "" : " ";
+            linkage += w;
+        }
+        skipSpace();
+        size_t typeStart = pos;
+        Type* valueType = type();
+        if (valueType->id == Type::VoidTyID || valueType->id == Type::FunctionTyID) {
+            failAt(typeStart, "invalid type for global variable");
+        }
+        std::vector<int32_t> initializer;
+        parseInitializer(valueType, initializer);
+        optionalAlign();
+        GlobalVariable* global = module->addGlobal(valueType, name, linkage, isConstant, std::move(initializer));
+        globals.emplace(module->getName(global), global);
+    }
+
+    // Appends the initializer, flattened row-major as in GlobalVariable.
+    void parseInitializer(Type* type, std::vector<int32_t>& out) {
+        skipSpace();
+        size_t start = pos;
+        if (consumeWord("zeroinitializer")) {
+            size_t count = 1;
+            for (Type* t = type; t->id == Type::ArrayTyID; t = static_cast<ArrayType*>(t)->elementType) {
+                count *= static_cast<ArrayType*>(t)->numElements;
+            }
+            out.resize(out.size() + count, 0);
+            return;
+        }
+        if (type->id == Type::ArrayTyID) {
+            auto* array = static_cast<ArrayType*>(type);
+            expect('[');
+            for (uint64_t i = 0; i < array->numElements; ++i) {
+                if (i > 0) {
+                    expect(',');
+                }
+                skipSpace();
+                size_t elementStart = pos;
+                if (this->type() != array->elementType) {
+                    failAt(elementStart, "element type does not match the array, '" + typeName(array->elementType) + "'");
+                }
+                parseInitializer(array->elementType, out);
+            }
+            expect(']');
+            return;
+        }
+        if (type != Type::getInt32Ty()) {
+            failAt(start, "only i32 data can initialize a global");
+        }
+        out.push_back(static_cast<ConstantInt*>(constant(type, integer(), start))->value);
+    }
+
+    // define <type> @name(<param types>) { <blocks> }
+    // A Function has no argument values, so parameters are types alone and
+    // the function's locals are numbered from %0, as IRPrinter numbers them.
+    void parseFunction() {
+        Type* returnType = type();
+        skipSpace();
+        size_t start = pos;
+        expect('@');
+        std::string name(this->name().text);
+        if (globals.count(name)) {
+            failAt(start, "redefinition of global '@" + name + "'");
+        }
+        expect('(');
+        std::vector<Type*> params;
+        if (!consume(')')) {
+            do {
+                params.push_back(type());
+            } while (consume(','));
+            expect(')');
+        }
+        expect('{');
+        func = module->addFunction(context().getFunctionTy(returnType, params), name);
+        globals.emplace(module->getName(func), func);
+        locals.clear();
+        numbered.clear();
+
+        // addFunction made the entry block, as "mainEntry"; it takes the
+        // first label, or is numbered if there is none.
+        BasicBlock* block = func->getEntryBlock();
+        skipSpace();
+        size_t labelStart = pos;
+        if (std::optional<Name> first = label()) {
+            defineLocal(block, *first, labelStart);
+        } else {
+            defineLocal(block, {"0", false}, labelStart);
+        }
+        builder.setInsertPoint(block);
+        while (!consume('}')) {
+            if (atEnd()) {
+                fail("expected '}' at end of function");
+            }
+            labelStart = pos;
+            if (std::optional<Name> next = label()) {
+                block = func->appendBlock();
+                defineLocal(block, *next, labelStart);
+                builder.setInsertPoint(block);
+            } else {
+                parseInstruction();
+            }
+        }
+        func = nullptr;
+    }
+
+    void parseInstruction() {
+        size_t start = pos;
+        std::optional<Name> result;
+        std::string resultText; // the result's name, if quoted: operands reuse `scratch`
+        if (consume('%')) {
+            result = name();
+            if (result->quoted) {
+                resultText = result->text;
+                result->text = resultText;
+            }
+            expect('=');
+        }
+        skipSpace();
+        size_t opcodeStart = pos;
+        std::string_view opcode = word();
+        Value* inst = nullptr;
+        if (opcode == "alloca") {
+            inst = builder.CreateAlloca(type());
+            optionalAlign();
+        } else if (opcode == "load") {
+            Type* loaded = type();
+            expect(',');
+            inst = builder.CreateLoad(pointer(loaded));
+            optionalAlign();
+        } else if (opcode == "store") {
+            Value* stored = value(type());
+            expect(',');
+            builder.CreateStore(stored, pointer(stored->type));
+            optionalAlign();
+        } else if (opcode == "getelementptr") {
+            expectWord("inbounds");
+            Type* source = type();
+            expect(',');
+            Value* base = pointer(source);
+            std::vector<Value*> indices;
+            Type* indexed = source; // what the next index after the first steps into
+            while (consume(',')) {
+                skipSpace();
+                size_t indexStart = pos;
+                Type* indexType = type();
+                if (indexType != Type::getInt32Ty()) {
+                    failAt(indexStart, "getelementptr indices must be i32 here");
+                }
+                if (!indices.empty()) {
+                    if (indexed->id != Type::ArrayTyID) {
+                        failAt(indexStart, "getelementptr index into a non-array type");
+                    }
+                    indexed = static_cast<ArrayType*>(indexed)->elementType;
+                }
+                indices.push_back(value(indexType));
+            }
+            inst = builder.CreateInBoundsGEP(source, base, indices);
+        } else if (std::optional<Instruction::Opcode> binary = binaryOpcode(opcode)) {
+            skipSpace();
+            size_t typeStart = pos;
+            Type* operandType = type();
+            if (operandType != Type::getInt32Ty()) {
+                failAt(typeStart, "binary operators take i32 here");
+            }
+            Value* lhs = value(operandType);
+            expect(',');
+            inst = builder.CreateBinary(*binary, lhs, value(operandType));
+        } else if (opcode == "icmp") {
+            skipSpace();
+            size_t predicateStart = pos;
+            std::optional<ICmpInst::Predicate> predicate = icmpPredicate(word());
+            if (!predicate) {
+                failAt(predicateStart, "expected icmp predicate");
+            }
+            Type* operandType = type();
+            Value* lhs = value(operandType);
+            expect(',');
+            inst = builder.CreateICmp(*predicate, lhs, value(operandType));
+        } else if (opcode == "zext") {
+            skipSpace();
+            size_t typeStart = pos;
+            Value* operand = value(type());
+            expectWord("to");
+            if (operand->type != Type::getInt1Ty() || type() != Type::getInt32Ty()) {
+                failAt(typeStart, "only zext from i1 to i32 is supported");
+            }
+            inst = builder.CreateZExt(operand);
+        } else if (opcode == "ret") {
+            skipSpace();
+            size_t typeStart = pos;
+            Type* returnType = type();
+            if (returnType != func->getReturnType()) {
+                failAt(typeStart, "value doesn't match function result type '" + typeName(func->getReturnType()) + "'");
+            }
+            if (returnType->id == Type::VoidTyID) {
+                builder.CreateRetVoid();
+            } else {
+                builder.CreateRet(value(returnType));
+            }
+        } else {
+            failAt(opcodeStart, "expected instruction opcode");
+        }
+
+        if (!inst) {
+            if (result) {
+                failAt(start, "instructions returning void cannot have a name");
+            }
+        } else if (result) {
+            defineLocal(inst, *result, start);
+        } else {
+            numbered.push_back(inst);
+        }
+    }
+
+    static std::optional<Instruction::Opcode> binaryOpcode(std::string_view name) {
+        for (Instruction::Opcode opcode :
+             {Instruction::Add, Instruction::Sub, Instruction::Mul, Instruction::SDiv, Instruction::SRem}) {
+            if (name == IRPrinter::opcodeName(opcode)) {
+                return opcode;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static std::optional<ICmpInst::Predicate> icmpPredicate(std::string_view name) {
+        for (ICmpInst::Predicate predicate :
+             {ICmpInst::EQ, ICmpInst::NE, ICmpInst::SGT, ICmpInst::SGE, ICmpInst::SLT, ICmpInst::SLE}) {
+            if (name == IRPrinter::predicateName(predicate)) {
+                return predicate;
+            }
+        }
+        return std::nullopt;
+    }
+};
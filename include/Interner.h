@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Interns identifier spellings as dense integer IDs (0, 1, 2, ...).
+//
+// Spellings are hashed into an open-addressed table with linear probing;
+// each slot keeps the full hash, so a probe only compares strings on a hash
+// match. The spellings are copied into append-only blocks, so the views
+// returned by spelling() stay valid for the Interner's lifetime.
+class Interner {
+public:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    Interner() : slots(INITIAL_SLOTS) {}
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    uint32_t intern(std::string_view text) {
+        uint32_t hash = hashOf(text);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.id == NONE) {
+                uint32_t id = static_cast<uint32_t>(spellings.size());
+                spellings.push_back(copy(text));
+                slot = {hash, id};
+                if (spellings.size() * 2 > slots.size()) {
+                    rehash(slots.size() * 2);
+                }
+                return id;
+            }
+            if (slot.hash == hash && spellings[slot.id] == text) {
+                return slot.id;
+            }
+        }
+    }
+
+    std::string_view spelling(uint32_t id) const { return spellings[id]; }
+    size_t size() const { return spellings.size(); }
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t id = NONE;
+    };
+
+    static constexpr size_t INITIAL_SLOTS = 256; // power of two
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    std::vector<Slot> slots;
+    std::vector<std::string_view> spellings; // indexed by ID
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockUsed = 0; // bytes used in blocks.back()
+    std::vector<std::unique_ptr<char[]>> longBlocks;
+
+    // FNV-1a
+    static uint32_t hashOf(std::string_view text) {
+        uint32_t hash = 2166136261u;
+        for (char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        return hash;
+    }
+
+    std::string_view copy(std::string_view text) {
+        if (text.size() > BLOCK_SIZE / 4) {
+            // Long spellings get a block of their own, kept apart so that
+            // blocks.back() stays the block short spellings are packed into.
+            longBlocks.emplace_back(new char[text.size()]);
+            std::memcpy(longBlocks.back().get(), text.data(), text.size());
+            return {longBlocks.back().get(), text.size()};
+        }
+        if (blocks.empty() || blockUsed + text.size() > BLOCK_SIZE) {
+            blocks.emplace_back(new char[BLOCK_SIZE]);
+            blockUsed = 0;
+        }
+        char* dst = blocks.back().get() + blockUsed;
+        std::memcpy(dst, text.data(), text.size());
+        blockUsed += text.size();
+        return {dst, text.size()};
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity);
+        old.swap(slots);
+        size_t mask = capacity - 1;
+        for (const Slot& slot : old) {
+            if (slot.id == NONE) {
+                continue;
+            }
+            size_t i = slot.hash & mask;
+            while (slots[i].id != NONE) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+        }
+    }
+};
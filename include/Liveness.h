@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "FunctionSnapshot.h"
+
+// Which instruction results are live where, computed on a FunctionSnapshot.
+//
+// Only results used outside their own block can be live across a block
+// boundary, so only those get a bit in the per-block sets (semi-pruned
+// liveness). The sets then cost blocks x cross-block values bits, not
+// blocks x instructions. They are solved by the usual backward dataflow,
+// iterated to a fixed point:
+//   liveOut(b) = union of liveIn(s) over the successors s of b
+//   liveIn(b)  = uses(b) + (liveOut(b) - defs(b))
+// A backward scan of each block then gives the pressure at every point.
+class Liveness {
+public:
+    explicit Liveness(const FunctionSnapshot& snapshot) : snapshot(snapshot) {
+        numberCrossBlockValues();
+        words = (crossBlock.size() + 63) / 64;
+        liveInSets.assign(size_t(snapshot.numBlocks()) * words, 0);
+        liveOutSets.assign(size_t(snapshot.numBlocks()) * words, 0);
+        solve();
+        computePressure();
+    }
+
+    Liveness(const Liveness&) = delete;
+    Liveness& operator=(const Liveness&) = delete;
+
+    // Whether the result of instruction `inst` is live on entry to / exit
+    // from `block` (snapshot numbering).
+    bool isLiveIn(uint32_t block, uint32_t inst) const { return test(liveInSets, block, inst); }
+    bool isLiveOut(uint32_t block, uint32_t inst) const { return test(liveOutSets, block, inst); }
+
+    // The instructions whose results are live out of `block`.
+    std::vector<Instruction*> liveOut(uint32_t block) const {
+        std::vector<Instruction*> result;
+        for (uint32_t g = 0; g < crossBlock.size(); ++g) {
+            if (liveOutSets[size_t(block) * words + g / 64] >> (g % 64) & 1) {
+                result.push_back(snapshot.instruction(crossBlock[g]));
+            }
+        }
+        return result;
+    }
+
+    // The most results live at once at any point of the function: a lower
+    // bound on the registers it needs without spilling.
+    uint32_t maxPressure() const { return pressure; }
+
+private:
+    const FunctionSnapshot& snapshot;
+    std::vector<uint32_t> crossBlock;  // bit -> instruction
+    std::vector<uint32_t> crossIndex;  // instruction -> bit, or NONE
+    size_t words = 0;                  // per set
+    std::vector<uint64_t> liveInSets;  // block-major
+    std::vector<uint64_t> liveOutSets;
+    uint32_t pressure = 0;
+
+    void numberCrossBlockValues() {
+        crossIndex.assign(snapshot.numInstructions(), FunctionSnapshot::NONE);
+        for (uint32_t i = 0; i < snapshot.numInstructions(); ++i) {
+            for (const uint32_t* user = snapshot.users.begin(i); user != snapshot.users.end(i); ++user) {
+                if (snapshot.parentBlock[*user] != snapshot.parentBlock[i]) {
+                    crossIndex[i] = static_cast<uint32_t>(crossBlock.size());
+                    crossBlock.push_back(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool test(const std::vector<uint64_t>& sets, uint32_t block, uint32_t inst) const {
+        uint32_t g = crossIndex[inst];
+        return g != FunctionSnapshot::NONE && (sets[size_t(block) * words + g / 64] >> (g % 64) & 1);
+    }
+
+    void solve() {
+        if (words == 0) {
+            return;
+        }
+        std::vector<uint64_t> in(words);
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (uint32_t b = snapshot.numBlocks(); b-- > 0;) {
+                uint64_t* out = &liveOutSets[size_t(b) * words];
+                for (const uint32_t* s = snapshot.successors.begin(b); s != snapshot.successors.end(b); ++s) {
+                    const uint64_t* succIn = &liveInSets[size_t(*s) * words];
+                    for (size_t w = 0; w < words; ++w) {
+                        out[w] |= succIn[w];
+                    }
+                }
+                std::copy(out, out + words, in.begin());
+                for (uint32_t i = snapshot.blockStart[b + 1]; i-- > snapshot.blockStart[b];) {
+                    if (uint32_t g = crossIndex[i]; g != FunctionSnapshot::NONE) {
+                        in[g / 64] &= ~(uint64_t(1) << (g % 64));
+                    }
+                    for (const uint32_t* op = snapshot.operands.begin(i); op != snapshot.operands.end(i); ++op) {
+                        if (snapshot.isInstruction(*op) && crossIndex[*op] != FunctionSnapshot::NONE) {
+                            uint32_t g = crossIndex[*op];
+                            in[g / 64] |= uint64_t(1) << (g % 64);
+                        }
+                    }
+                }
+                uint64_t* oldIn = &liveInSets[size_t(b) * words];
+                if (!std::equal(in.begin(), in.end(), oldIn)) {
+                    std::copy(in.begin(), in.end(), oldIn);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // Scans each block backward from its live-out set, tracking every live
+    // result, local ones included, in one bit vector over all instructions.
+    void computePressure() {
+        std::vector<uint64_t> live((snapshot.numInstructions() + 63) / 64);
+        auto set = [&](uint32_t i) {
+            uint64_t& word = live[i / 64];
+            uint64_t bit = uint64_t(1) << (i % 64);
+            bool added = !(word & bit);
+            word |= bit;
+            return added;
+        };
+        auto clear = [&](uint32_t i) {
+            uint64_t& word = live[i / 64];
+            uint64_t bit = uint64_t(1) << (i % 64);
+            bool removed = word & bit;
+            word &= ~bit;
+            return removed;
+        };
+        for (uint32_t b = 0; b < snapshot.numBlocks(); ++b) {
+            uint32_t count = 0;
+            for (uint32_t g = 0; g < crossBlock.size(); ++g) {
+                if (liveOutSets[size_t(b) * words + g / 64] >> (g % 64) & 1) {
+                    count += set(crossBlock[g]);
+                }
+            }
+            pressure = std::max(pressure, count);
+            for (uint32_t i = snapshot.blockStart[b + 1]; i-- > snapshot.blockStart[b];) {
+                count -= clear(i);
+                for (const uint32_t* op = snapshot.operands.begin(i); op != snapshot.operands.end(i); ++op) {
+                    if (snapshot.isInstruction(*op)) {
+                        count += set(*op);
+                    }
+                }
+                pressure = std::max(pressure, count);
+            }
+            // What is left is the block's live-in set; clear it for the next block.
+            for (uint32_t g = 0; g < crossBlock.size(); ++g) {
+                clear(crossBlock[g]);
+            }
+        }
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Buffered text output, in the spirit of LLVM's raw_ostream.
+//
+// Everything written is appended to one buffer, allocated once, that is
+// handed to flushBuffer() only when it is full or flush() is called; a
+// piece larger than the buffer bypasses it. Unlike std::ostream there is no
+// sentry, locale or virtual call per insertion, and integers are formatted
+// with std::to_chars straight into the buffer.
+class OutputStream {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = size_t(256) << 10;
+
+    explicit OutputStream(size_t bufferSize = DEFAULT_BUFFER_SIZE)
+        : buffer(new char[bufferSize]), cur(buffer.get()), end(buffer.get() + bufferSize) {}
+    OutputStream(const OutputStream&) = delete;
+    OutputStream& operator=(const OutputStream&) = delete;
+    // Subclasses flush in their own destructor, while flushBuffer() still
+    // reaches them.
+    virtual ~OutputStream() = default;
+
+    OutputStream& write(const char* data, size_t size) {
+        if (size <= static_cast<size_t>(end - cur)) {
+            std::memcpy(cur, data, size);
+            cur += size;
+            return *this;
+        }
+        flush();
+        if (size >= bufferSize()) {
+            flushBuffer(data, size);
+        } else {
+            std::memcpy(cur, data, size);
+            cur += size;
+        }
+        return *this;
+    }
+
+    OutputStream& operator<<(char c) {
+        if (cur == end) {
+            flush();
+        }
+        *cur++ = c;
+        return *this;
+    }
+    OutputStream& operator<<(std::string_view text) { return write(text.data(), text.size()); }
+    OutputStream& operator<<(const char* text) { return write(text, std::strlen(text)); }
+    OutputStream& operator<<(const std::string& text) { return write(text.data(), text.size()); }
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> &&
+                                               !std::is_same_v<T, bool>, int> = 0>
+    OutputStream& operator<<(T value) {
+        constexpr size_t MAX_DIGITS = 24; // 20 digits and a sign, with room to spare
+        if (static_cast<size_t>(end - cur) < MAX_DIGITS) {
+            flush();
+        }
+        cur = std::to_chars(cur, end, value).ptr;
+        return *this;
+    }
+
+    // Hands what is buffered to flushBuffer().
+    void flush() {
+        if (cur != buffer.get()) {
+            size_t size = static_cast<size_t>(cur - buffer.get());
+            cur = buffer.get();
+            flushBuffer(buffer.get(), size);
+        }
+    }
+
+protected:
+    virtual void flushBuffer(const char* data, size_t size) = 0;
+
+    // Drops what is buffered without writing it.
+    void discardBuffer() { cur = buffer.get(); }
+
+private:
+    std::unique_ptr<char[]> buffer;
+    char* cur;
+    char* end;
+
+    size_t bufferSize() const { return static_cast<size_t>(end - buffer.get()); }
+};
+
+// Writes to a file with write(2), a buffer at a time.
+class FileOutputStream : public OutputStream {
+public:
+    FileOutputStream() = default;
+    explicit FileOutputStream(const std::string& path) { open(path); }
+    ~FileOutputStream() override { close(); }
+
+    // Creates or truncates `path`, closing the file open before.
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        failed = fd < 0;
+        return fd >= 0;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    // Flushes and closes the file; false if anything written since open()
+    // did not reach it.
+    bool close() {
+        if (fd < 0) {
+            discardBuffer();
+            return !failed;
+        }
+        flush();
+        if (::close(fd) != 0) {
+            failed = true;
+        }
+        fd = -1;
+        return !failed;
+    }
+
+protected:
+    void flushBuffer(const char* data, size_t size) override {
+        while (size > 0 && fd >= 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                failed = true;
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+private:
+    int fd = -1;
+    bool failed = false;
+};
+
+// Appends to a std::string, e.g. for IRPrinter::toString.
+class StringOutputStream : public OutputStream {
+public:
+    explicit StringOutputStream(std::string& target) : OutputStream(size_t(4) << 10), target(target) {}
+    ~StringOutputStream() override { flush(); }
+
+    // Flushes first, so the string is up to date.
+    std::string& str() {
+        flush();
+        return target;
+    }
+
+protected:
+    void flushBuffer(const char* data, size_t size) override { target.append(data, size); }
+
+private:
+    std::string& target;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "DescentParser.h"
+#include "SlabTokenStream.h"
+#include "SysYParser.h"
+
+// Parses a compUnit with DescentParser on several threads.
+//
+// Top-level decls and funcDefs parse independently: SysY has no typedefs,
+// so parsing never depends on what a name was declared as. A pre-scan over
+// the token types splits the input at top-level item boundaries by brace
+// depth alone. A decl ends at a `;` outside braces (its initializer braces
+// are closed by then). A funcDef ends at the `}` that closes its body. The
+// items are grouped into chunks of roughly equal token counts. Each chunk is
+// parsed by its own DescentParser on its own SlabTokenCursor, the first on
+// the calling thread. The items are then stitched under one
+// CompUnitContext in source order. The tree is the one DescentParser::compUnit()
+// would build.
+//
+// The token stream must be fully scanned (not streaming). Nodes are owned by
+// the chunks' parsers and live until the ParallelParser is destroyed.
+class ParallelParser {
+public:
+    // Below this many tokens per thread, starting a thread costs more than
+    // it saves; smaller inputs use fewer chunks, down to one (no threads).
+    static constexpr size_t MIN_CHUNK_TOKENS = size_t(1) << 15;
+
+    ParallelParser(SlabTokenStream& tokens, unsigned threads) : tokens(tokens), threads(std::max(1u, threads)) {}
+
+    ParallelParser(const ParallelParser&) = delete;
+    ParallelParser& operator=(const ParallelParser&) = delete;
+
+    // Like DescentParser::compUnit(): nullptr at the first syntax error, so
+    // the caller can re-parse with SysYParser.
+    SysYParser::CompUnitContext* compUnit() {
+        std::vector<size_t> bounds = chunkBounds();
+        chunks.clear();
+        chunks.resize(bounds.size() - 1);
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            chunks[i].cursor = std::make_unique<SlabTokenCursor>(tokens, bounds[i]);
+            chunks[i].parser = std::make_unique<DescentParser>(chunks[i].cursor.get());
+            chunks[i].stop = bounds[i + 1];
+        }
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < chunks.size(); ++i) {
+            try {
+                workers.emplace_back([this, i] { parse(chunks[i]); });
+            } catch (const std::system_error&) {
+                parse(chunks[i]); // no more threads: parse it here
+            }
+        }
+        parse(chunks[0]);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        std::vector<antlr4::ParserRuleContext*> items;
+        for (Chunk& chunk : chunks) {
+            if (chunk.error) {
+                std::rethrow_exception(chunk.error);
+            }
+            if (!chunk.ok) {
+                return nullptr;
+            }
+            items.insert(items.end(), chunk.items.begin(), chunk.items.end());
+        }
+        rootCursor = std::make_unique<SlabTokenCursor>(tokens, 0);
+        root = std::make_unique<DescentParser>(rootCursor.get());
+        return root->compUnitFrom(items);
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<SlabTokenCursor> cursor;
+        std::unique_ptr<DescentParser> parser;
+        size_t stop = 0; // index of the first token after the chunk
+        std::vector<antlr4::ParserRuleContext*> items;
+        bool ok = false;
+        std::exception_ptr error;
+    };
+
+    SlabTokenStream& tokens;
+    unsigned threads;
+    std::vector<Chunk> chunks;
+    std::unique_ptr<SlabTokenCursor> rootCursor;
+    std::unique_ptr<DescentParser> root;
+
+    static void parse(Chunk& chunk) {
+        try {
+            chunk.ok = chunk.parser->topLevelItems(chunk.stop, chunk.items);
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+    }
+
+    size_t typeAt(size_t i) { return tokens.get(std::min(i, tokens.size() - 1))->getType(); }
+
+    // Same test as DescentParser::topLevel().
+    bool startsFuncDef(size_t i) {
+        return typeAt(i) == SysYParser::VOID ||
+               (typeAt(i) == SysYParser::INT && typeAt(i + 1) == SysYParser::IDENT &&
+                typeAt(i + 2) == SysYParser::L_PAREN);
+    }
+
+    // The first token index of each chunk, followed by the EOF token's index.
+    // A chunk boundary is the first item boundary past an equal share of the
+    // tokens. Unbalanced braces only misplace boundaries: a chunk parser then
+    // fails, as DescentParser would have on the same input.
+    std::vector<size_t> chunkBounds() {
+        size_t eof = tokens.size() - 1;
+        size_t count = std::min<size_t>(threads, std::max<size_t>(1, eof / MIN_CHUNK_TOKENS));
+        std::vector<size_t> bounds{0};
+        bool funcDef = startsFuncDef(0);
+        size_t depth = 0;
+        for (size_t i = 0; i < eof && bounds.size() < count; ++i) {
+            bool itemEnd = false;
+            switch (typeAt(i)) {
+            case SysYParser::L_BRACE:
+                ++depth;
+                break;
+            case SysYParser::R_BRACE:
+                if (depth > 0) {
+                    --depth;
+                }
+                itemEnd = funcDef && depth == 0;
+                break;
+            case SysYParser::SEMICOLON:
+                itemEnd = !funcDef && depth == 0;
+                break;
+            default:
+                break;
+            }
+            if (itemEnd) {
+                funcDef = startsFuncDef(i + 1);
+                if (i + 1 >= bounds.size() * eof / count && i + 1 < eof) {
+                    bounds.push_back(i + 1);
+                }
+            }
+        }
+        bounds.push_back(eof);
+        return bounds;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "ConstantFolding.h"
+#include "DeadCodeElimination.h"
+#include "DominatorTree.h"
+#include "FunctionSnapshot.h"
+#include "IR.h"
+#include "Liveness.h"
+
+// A pass tools/sysy-opt.cpp can run by name. run() takes the whole module
+// and returns how many instructions it changed; analyses change nothing,
+// return 0 and print what they found on stderr.
+struct PassInfo {
+    const char* name;
+    const char* description;
+    size_t (*run)(Module&);
+};
+
+class PassRegistry {
+public:
+    static const std::vector<PassInfo>& passes() {
+        static const std::vector<PassInfo> list = {
+            {"constfold", "fold instructions whose operands are constants",
+             [](Module& module) { return forEachFunction(module, ConstantFolding::run); }},
+            {"dce", "erase unused instructions that have no side effects",
+             [](Module& module) { return forEachFunction(module, DeadCodeElimination::run); }},
+            {"snapshot", "build the index-based FunctionSnapshot of each function (analysis)",
+             [](Module& module) {
+                 return forEachFunction(module, [](Function& func) {
+                     FunctionSnapshot snapshot(func);
+                     return size_t(0);
+                 });
+             }},
+            {"liveness", "print the maximum register pressure of each function (analysis)",
+             [](Module& module) {
+                 return forEachFunction(module, [&module](Function& func) {
+                     FunctionSnapshot snapshot(func);
+                     Liveness liveness(snapshot);
+                     std::cerr << "@" << module.getName(&func) << ": max pressure " << liveness.maxPressure() << "\n";
+                     return size_t(0);
+                 });
+             }},
+            {"domtree", "print the depth of each function's dominator and post-dominator trees (analysis)",
+             [](Module& module) {
+                 return forEachFunction(module, [&module](Function& func) {
+                     FunctionSnapshot snapshot(func);
+                     DominatorTree dominators(snapshot);
+                     DominatorTree postDominators(snapshot, true);
+                     std::cerr << "@" << module.getName(&func) << ": " << snapshot.numBlocks() << " blocks, depth "
+                               << depthOf(dominators) << ", post-dominator depth " << depthOf(postDominators) << "\n";
+                     return size_t(0);
+                 });
+             }},
+        };
+        return list;
+    }
+
+    // The pass called `name`, or nullptr.
+    static const PassInfo* find(std::string_view name) {
+        for (const PassInfo& pass : passes()) {
+            if (name == pass.name) {
+                return &pass;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    static uint32_t depthOf(const DominatorTree& tree) {
+        uint32_t depth = 0;
+        for (uint32_t b = 0; b < tree.numBlocks(); ++b) {
+            if (tree.isReachable(b)) {
+                depth = std::max(depth, tree.level(b));
+            }
+        }
+        return depth;
+    }
+
+    template <typename Pass>
+    static size_t forEachFunction(Module& module, Pass pass) {
+        size_t changed = 0;
+        for (Function& func : module.funcList) {
+            changed += pass(func);
+        }
+        return changed;
+    }
+};
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Only the token type numbering is taken from the generated lexer, so that
+// types agree with SysYLexer.g4 / SysYParser.
+#include "SysYLexer.h"
+
+// Hand-written lexer for SysY.
+//
+// Recognizes exactly the token set of SysYLexer.g4 (same types, same
+// longest-match / first-rule-wins resolution, same skip rules), but runs a
+// direct-coded DFA over a raw byte buffer instead of the ANTLR ATN simulator.
+// Whitespace runs and comment bodies are skipped 16 bytes at a time with SSE2
+// when available.
+//
+// The Scanner itself knows nothing about ANTLR tokens: it hands out Lexemes
+// whose text is a view into the input buffer (see SourceFile). The
+// ScannerTokenSource adapter wraps it for CommonTokenStream. Differences from
+// SysYLexer:
+//   - offsets and columns are byte based (SysYLexer counts code points);
+//     both agree on ASCII input.
+//   - the buffer must outlive the Scanner and every text() view; it is not
+//     copied.
+class Scanner {
+public:
+    // A single token as produced by the DFA.
+    struct Lexeme {
+        size_t type;
+        size_t start;   // byte offset of the first character
+        size_t length;  // length in bytes
+        size_t line;
+        size_t column;
+    };
+
+    Scanner(const char* data, size_t size, const std::string& sourceName = "<input>")
+        : begin(data), cur(data), end(data + size), lineStart(data), reportedTo(data), sourceName(sourceName) {}
+
+    // Scans the next non-skipped token. Returns false (and fills `out` with an
+    // EOF lexeme) once the input is exhausted.
+    bool next(Lexeme& out) {
+        for (;;) {
+            skipWhitespace();
+            if (cur >= end) {
+                out = {antlr4::Token::EOF, offset(cur), 0, line, column(cur)};
+                return false;
+            }
+
+            const char* start = cur;
+            size_t startLine = line;
+            size_t startColumn = column(cur);
+            size_t type = scanToken();
+            if (type == SKIPPED) {
+                continue;
+            }
+            if (type == antlr4::Token::INVALID_TYPE) {
+                reportError(start, startLine, startColumn);
+                continue;
+            }
+            out = {type, offset(start), static_cast<size_t>(cur - start), startLine, startColumn};
+            return true;
+        }
+    }
+
+    // Restarts scanning from the start of the buffer. Errors in the part that
+    // was already scanned have been reported once and are not reported (or
+    // counted) again.
+    void rewind() {
+        if (cur > reportedTo) {
+            reportedTo = cur;
+        }
+        cur = begin;
+        lineStart = begin;
+        line = 1;
+    }
+
+    // The lexeme's text, viewed in place in the input buffer.
+    std::string_view text(const Lexeme& lex) const { return {begin + lex.start, lex.length}; }
+
+    size_t getNumberOfSyntaxErrors() const { return syntaxErrors; }
+    size_t getLine() const { return line; }
+    size_t getColumn() const { return column(cur); }
+    const std::string& getSourceName() const { return sourceName; }
+    std::string_view getInput() const { return {begin, static_cast<size_t>(end - begin)}; }
+
+private:
+    // Internal marker for WS / comments; never a real token type.
+    static constexpr size_t SKIPPED = static_cast<size_t>(-2);
+
+    const char* begin;
+    const char* cur;
+    const char* end;
+    const char* lineStart; // first byte of the current line
+    const char* reportedTo; // errors before this were reported by an earlier pass
+    size_t line = 1;
+    size_t syntaxErrors = 0;
+    std::string sourceName;
+
+    size_t offset(const char* p) const { return static_cast<size_t>(p - begin); }
+    size_t column(const char* p) const { return static_cast<size_t>(p - lineStart); }
+
+    static bool isIdentStart(unsigned char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+    static bool isIdentPart(unsigned char c) {
+        return isIdentStart(c) || (c >= '0' && c <= '9');
+    }
+    static bool isWhitespace(unsigned char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Line bookkeeping for a newline found at p.
+    void newlineAt(const char* p) {
+        ++line;
+        lineStart = p + 1;
+    }
+
+    // WS: [ \t\r\n]+ -> skip
+    void skipWhitespace() {
+#if defined(__SSE2__)
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i nl = _mm_set1_epi8('\n');
+        while (end - cur >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+            __m128i isNl = _mm_cmpeq_epi8(chunk, nl);
+            __m128i isWs = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), isNl));
+            unsigned wsMask = static_cast<unsigned>(_mm_movemask_epi8(isWs));
+            unsigned nlMask = static_cast<unsigned>(_mm_movemask_epi8(isNl));
+            // Only whitespace strictly before the first non-whitespace byte counts.
+            unsigned run = (wsMask == 0xFFFFu) ? 16u : static_cast<unsigned>(__builtin_ctz(~wsMask));
+            if (run < 16) {
+                nlMask &= (1u << run) - 1u;
+            }
+            if (nlMask) {
+                line += static_cast<size_t>(__builtin_popcount(nlMask));
+                lineStart = cur + (31 - __builtin_clz(nlMask)) + 1;
+            }
+            cur += run;
+            if (run < 16) {
+                return;
+            }
+        }
+#endif
+        while (cur < end && isWhitespace(static_cast<unsigned char>(*cur))) {
+            if (*cur == '\n') {
+                newlineAt(cur);
+            }
+            ++cur;
+        }
+    }
+
+    // Returns the first occurrence of `target` in [from, end), or end. Newlines
+    // crossed on the way are accounted for, so this also serves comment bodies.
+    const char* findByte(const char* from, char target) {
+        const char* p = from;
+#if defined(__SSE2__)
+        const __m128i want = _mm_set1_epi8(target);
+        const __m128i nl = _mm_set1_epi8('\n');
+        while (end - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            unsigned hitMask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, want)));
+            unsigned nlMask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl)));
+            unsigned run = hitMask ? static_cast<unsigned>(__builtin_ctz(hitMask)) : 16u;
+            if (run < 16) {
+                nlMask &= (1u << run) - 1u;
+            }
+            if (nlMask) {
+                line += static_cast<size_t>(__builtin_popcount(nlMask));
+                lineStart = p + (31 - __builtin_clz(nlMask)) + 1;
+            }
+            p += run;
+            if (run < 16) {
+                return p;
+            }
+        }
+#endif
+        while (p < end && *p != target) {
+            if (*p == '\n') {
+                newlineAt(p);
+            }
+            ++p;
+        }
+        return p;
+    }
+
+    // Keyword table lookup for an IDENT-shaped lexeme; keywords win over IDENT
+    // at equal length because they are listed first in SysYLexer.g4.
+    static size_t keywordOrIdent(const char* s, size_t n) {
+        switch (n) {
+        case 2:
+            if (s[0] == 'i' && s[1] == 'f') return SysYLexer::IF;
+            break;
+        case 3:
+            if (std::memcmp(s, "int", 3) == 0) return SysYLexer::INT;
+            break;
+        case 4:
+            if (std::memcmp(s, "void", 4) == 0) return SysYLexer::VOID;
+            if (std::memcmp(s, "else", 4) == 0) return SysYLexer::ELSE;
+            break;
+        case 5:
+            if (std::memcmp(s, "const", 5) == 0) return SysYLexer::CONST;
+            if (std::memcmp(s, "while", 5) == 0) return SysYLexer::WHILE;
+            if (std::memcmp(s, "break", 5) == 0) return SysYLexer::BREAK;
+            break;
+        case 6:
+            if (std::memcmp(s, "return", 6) == 0) return SysYLexer::RETURN;
+            break;
+        case 8:
+            if (std::memcmp(s, "continue", 8) == 0) return SysYLexer::CONTINUE;
+            break;
+        }
+        return SysYLexer::IDENT;
+    }
+
+    // Runs the DFA from `cur` (a non-whitespace byte), advances `cur` past the
+    // longest match and returns its type, SKIPPED for comments, or
+    // INVALID_TYPE when no rule matches (cur then points at the failing byte).
+    size_t scanToken() {
+        const char* start = cur;
+        unsigned char c = static_cast<unsigned char>(*cur);
+
+        if (isIdentStart(c)) {
+            ++cur;
+            while (cur < end && isIdentPart(static_cast<unsigned char>(*cur))) {
+                ++cur;
+            }
+            return keywordOrIdent(start, static_cast<size_t>(cur - start));
+        }
+        if (c >= '0' && c <= '9') {
+            ++cur;
+            // IntConst: '0' | [1-9][0-9]*  ("012" lexes as "0" "12")
+            if (c != '0') {
+                while (cur < end && *cur >= '0' && *cur <= '9') {
+                    ++cur;
+                }
+            }
+            return SysYLexer::IntConst;
+        }
+
+        ++cur;
+        switch (c) {
+        case '(': return SysYLexer::L_PAREN;
+        case ')': return SysYLexer::R_PAREN;
+        case '[': return SysYLexer::L_BRACK;
+        case ']': return SysYLexer::R_BRACK;
+        case '{': return SysYLexer::L_BRACE;
+        case '}': return SysYLexer::R_BRACE;
+        case ',': return SysYLexer::COMMA;
+        case ';': return SysYLexer::SEMICOLON;
+        case '+': return SysYLexer::PLUS;
+        case '-': return SysYLexer::MINUS;
+        case '*': return SysYLexer::MUL;
+        case '%': return SysYLexer::MOD;
+        case '=': return match('=') ? SysYLexer::EQ : SysYLexer::ASSIGN;
+        case '!': return match('=') ? SysYLexer::NEQ : SysYLexer::NOT;
+        case '<': return match('=') ? SysYLexer::LE : SysYLexer::LT;
+        case '>': return match('=') ? SysYLexer::GE : SysYLexer::GT;
+        case '&': return match('&') ? size_t(SysYLexer::AND) : size_t(antlr4::Token::INVALID_TYPE);
+        case '|': return match('|') ? size_t(SysYLexer::OR) : size_t(antlr4::Token::INVALID_TYPE);
+        case '/': return scanSlash();
+        default:
+            cur = start; // nothing consumed: the error is at the first byte
+            return antlr4::Token::INVALID_TYPE;
+        }
+    }
+
+    bool match(char expected) {
+        if (cur < end && *cur == expected) {
+            ++cur;
+            return true;
+        }
+        return false;
+    }
+
+    // After '/': LINE_COMMENT, BLOCK_COMMENT or DIV. An unterminated comment
+    // does not match its rule, so the lexer falls back to DIV (last accept).
+    size_t scanSlash() {
+        const char* afterSlash = cur;
+        size_t savedLine = line;
+        const char* savedLineStart = lineStart;
+
+        if (cur < end && *cur == '/') {
+            // LINE_COMMENT: '//' .*? '\n'
+            const char* nl = findByte(cur + 1, '\n');
+            if (nl < end) {
+                newlineAt(nl);
+                cur = nl + 1;
+                return SKIPPED;
+            }
+        } else if (cur < end && *cur == '*') {
+            // BLOCK_COMMENT: '/*' .*? '*/'
+            const char* p = cur + 1;
+            for (;;) {
+                const char* star = findByte(p, '*');
+                if (star >= end) {
+                    break;
+                }
+                if (star + 1 < end && star[1] == '/') {
+                    cur = star + 2;
+                    return SKIPPED;
+                }
+                p = star + 1;
+            }
+        } else {
+            return SysYLexer::DIV;
+        }
+
+        cur = afterSlash;
+        line = savedLine;
+        lineStart = savedLineStart;
+        return SysYLexer::DIV;
+    }
+
+    // Mirrors antlr4::Lexer::notifyListeners + recover: the offending text runs
+    // from the token start through the byte where the DFA failed, and that
+    // byte is consumed before scanning resumes.
+    void reportError(const char* start, size_t startLine, size_t startColumn) {
+        if (start < reportedTo) {
+            skipErrorByte();
+            return;
+        }
+        ++syntaxErrors;
+        const char* stop = (cur < end) ? cur + 1 : end;
+        std::string display;
+        for (const char* p = start; p < stop; ++p) {
+            switch (*p) {
+            case '\n': display += "\\n"; break;
+            case '\t': display += "\\t"; break;
+            case '\r': display += "\\r"; break;
+            default: display += *p; break;
+            }
+        }
+        std::cerr << "line " << startLine << ":" << startColumn
+                  << " token recognition error at: '" << display << "'" << std::endl;
+        skipErrorByte();
+    }
+
+    void skipErrorByte() {
+        if (cur < end) {
+            if (*cur == '\n') {
+                newlineAt(cur);
+            }
+            ++cur;
+        }
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "antlr4-runtime.h"
+#include "Scanner.h"
+
+// Adapter that exposes a Scanner as an antlr4::TokenSource, so it can be
+// dropped in under a CommonTokenStream in place of SysYLexer. This is the
+// only place where Scanner lexemes become ANTLR tokens.
+class ScannerTokenSource : public antlr4::TokenSource {
+public:
+    explicit ScannerTokenSource(Scanner& scanner) : scanner(scanner) {}
+
+    std::unique_ptr<antlr4::Token> nextToken() override {
+        Scanner::Lexeme lex;
+        bool more = scanner.next(lex);
+        size_t stop = lex.start + lex.length - 1; // EOF: stop = start - 1, as in antlr4::Lexer
+        auto token = std::make_unique<antlr4::CommonToken>(
+            std::make_pair<antlr4::TokenSource*, antlr4::CharStream*>(this, nullptr),
+            lex.type, antlr4::Token::DEFAULT_CHANNEL, lex.start, stop);
+        token->setLine(lex.line);
+        token->setCharPositionInLine(lex.column);
+        token->setText(more ? std::string(scanner.text(lex)) : std::string("<EOF>"));
+        return token;
+    }
+
+    Scanner& getScanner() const { return scanner; }
+
+    size_t getLine() const override { return scanner.getLine(); }
+    size_t getCharPositionInLine() override { return scanner.getColumn(); }
+    antlr4::CharStream* getInputStream() override { return nullptr; }
+    std::string getSourceName() override { return scanner.getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override {
+        return antlr4::CommonTokenFactory::DEFAULT.get();
+    }
+
+private:
+    Scanner& scanner;
+};
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+
+class SlabTokenStream;
+
+// A token that references the source buffer instead of owning its text.
+//
+// Only what cannot be recomputed is stored: type, byte offset, length, the
+// interned symbol ID of an identifier and the token's index, packed with the
+// owning stream pointer into 32 bytes (a CommonToken is ~120 bytes plus a
+// separate heap block, and its text is another allocation once it exceeds the
+// small-string buffer). getText() materializes the text from the buffer on
+// demand; line and column are looked up in the stream's line table.
+class SlabToken final : public antlr4::Token {
+public:
+    SlabToken(const SlabTokenStream* stream, size_t type, uint32_t offset, uint32_t length, uint32_t symbol,
+              uint32_t index)
+        : stream(stream), offset(offset), symbol(symbol), index(index),
+          packedType(type == EOF ? EOF_CODE : static_cast<uint32_t>(type)),
+          packedLength(std::min<uint32_t>(length, LONG_LENGTH)) {}
+
+    std::string getText() const override;
+    size_t getType() const override { return packedType == EOF_CODE ? EOF : packedType; }
+    size_t getLine() const override;
+    size_t getCharPositionInLine() const override;
+    size_t getChannel() const override { return DEFAULT_CHANNEL; }
+    size_t getTokenIndex() const override { return index; }
+    size_t getStartIndex() const override { return offset; }
+    size_t getStopIndex() const override { return offset + length() - 1; } // EOF: start - 1
+    antlr4::TokenSource* getTokenSource() const override;
+    antlr4::CharStream* getInputStream() const override { return nullptr; }
+    std::string toString() const override;
+
+    // The token's text as a view into the source buffer ("" for EOF).
+    std::string_view view() const;
+    size_t length() const;
+    // Interned ID of an IDENT token's spelling; Interner::NONE for other types.
+    uint32_t getSymbol() const { return symbol; }
+
+private:
+    friend class SlabTokenStream;
+
+    static constexpr uint32_t EOF_CODE = 0xFF;
+    // Lengths that do not fit in 24 bits are kept in the stream's side table.
+    static constexpr uint32_t LONG_LENGTH = (1u << 24) - 1;
+
+    const SlabTokenStream* stream;
+    uint32_t offset;
+    uint32_t symbol;
+    uint32_t index;
+    uint32_t packedType : 8;
+    uint32_t packedLength : 24;
+};
+
+// Token stream over the Scanner that allocates tokens in contiguous slabs.
+//
+// This stands in for CommonTokenStream + a TokenFactory. Tokens are placed
+// in fixed-size slabs of SLAB_SIZE tokens, so there is one allocation per
+// 4096 tokens instead of one (or two) per token, and a token's address never
+// changes while its slab is alive. All tokens are on the default channel,
+// so LT/LA are plain index arithmetic. Tokens conjured by error recovery
+// still come from the adapter's CommonTokenFactory and are owned by the
+// error strategy.
+//
+// Identifiers are interned as they are scanned, so later phases key symbols
+// by integer ID instead of by string (see symbolOf()).
+//
+// By default the whole input is scanned up front. In streaming mode tokens
+// are scanned on demand and releaseConsumed() frees the slabs behind the
+// current position, so memory is bounded by the lookahead window.
+class SlabTokenStream : public antlr4::TokenStream {
+public:
+    static constexpr size_t SLAB_BITS = 12;
+    static constexpr size_t SLAB_SIZE = size_t(1) << SLAB_BITS;
+
+    SlabTokenStream(ScannerTokenSource& source, Interner& interner, bool streaming = false)
+        : source(source), scanner(source.getScanner()), interner(interner) {
+        std::string_view input = scanner.getInput();
+        if (input.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("SlabTokenStream: input larger than 4 GiB");
+        }
+        buffer = input.data();
+        if (!streaming) {
+            while (!done) {
+                scanOne();
+            }
+        }
+    }
+
+    // Streaming mode: frees the slabs that lie entirely before LT(1), with
+    // the line table entries for lines before them. Tokens before LT(1) must
+    // no longer be referenced; seek() cannot go back past them.
+    void releaseConsumed() {
+        size_t current = p >> SLAB_BITS;
+        if (current == firstSlab) {
+            return;
+        }
+        while (firstSlab < current) {
+            slabs.pop_front();
+            ++firstSlab;
+        }
+        lineStarts.erase(lineStarts.begin(), lineOf(tokenAt(released()).offset));
+        for (auto it = longLengths.begin(); it != longLengths.end();) {
+            it = it->first < released() ? longLengths.erase(it) : std::next(it);
+        }
+    }
+
+    // --- antlr4::IntStream ---
+
+    void consume() override {
+        if (LA(1) == antlr4::Token::EOF) {
+            throw antlr4::IllegalStateException("cannot consume EOF");
+        }
+        ++p;
+    }
+
+    size_t LA(ssize_t i) override {
+        antlr4::Token* t = LT(i);
+        return t ? t->getType() : antlr4::Token::INVALID_TYPE;
+    }
+
+    ssize_t mark() override { return 0; }
+    void release(ssize_t /*marker*/) override {}
+    size_t index() override { return p; }
+    void seek(size_t i) override {
+        if (i < released()) {
+            throw antlr4::IllegalStateException("cannot seek before released tokens");
+        }
+        p = fill(i);
+    }
+    size_t size() override { return count; }
+    std::string getSourceName() const override { return scanner.getSourceName(); }
+
+    // --- antlr4::TokenStream ---
+
+    antlr4::Token* LT(ssize_t k) override {
+        if (k == 0) {
+            return nullptr;
+        }
+        if (k < 0) {
+            size_t back = static_cast<size_t>(-k);
+            return back > p || p - back < released() ? nullptr : &tokenAt(p - back);
+        }
+        return &tokenAt(fill(p + static_cast<size_t>(k) - 1));
+    }
+
+    antlr4::Token* get(size_t i) const override {
+        auto* self = const_cast<SlabTokenStream*>(this);
+        if (i < released() || self->fill(i) != i) {
+            throw antlr4::IndexOutOfBoundsException("token index " + std::to_string(i) + " out of range " +
+                                                    std::to_string(released()) + ".." + std::to_string(count - 1));
+        }
+        return &self->tokenAt(i);
+    }
+
+    antlr4::TokenSource* getTokenSource() const override { return &source; }
+
+    // The interned ID of an identifier token from this stream, or
+    // Interner::NONE if the token is not an identifier or not one of ours
+    // (e.g. conjured by error recovery).
+    uint32_t symbolOf(const antlr4::Token* token) {
+        size_t i = token->getTokenIndex();
+        if (i < released() || i >= count || &tokenAt(i) != token) {
+            return Interner::NONE;
+        }
+        return static_cast<const SlabToken*>(token)->getSymbol();
+    }
+
+    std::string getText(const antlr4::misc::Interval& interval) override {
+        if (interval.a < 0 || interval.b < 0) {
+            return "";
+        }
+        std::string text;
+        size_t stop = fill(static_cast<size_t>(interval.b));
+        for (size_t i = std::max(static_cast<size_t>(interval.a), released()); i <= stop; ++i) {
+            const SlabToken& token = tokenAt(i);
+            if (token.getType() == antlr4::Token::EOF) {
+                break;
+            }
+            text += token.view();
+        }
+        return text;
+    }
+
+    std::string getText() override { return getText(antlr4::misc::Interval(0, static_cast<ssize_t>(fill(SIZE_MAX)))); }
+    std::string getText(antlr4::RuleContext* ctx) override { return getText(ctx->getSourceInterval()); }
+    std::string getText(antlr4::Token* start, antlr4::Token* stop) override {
+        if (!start || !stop) {
+            return "";
+        }
+        return getText(antlr4::misc::Interval(start->getTokenIndex(), stop->getTokenIndex()));
+    }
+
+private:
+    friend class SlabToken;
+
+    ScannerTokenSource& source;
+    Scanner& scanner;
+    Interner& interner;
+    const char* buffer = nullptr;
+    std::deque<std::vector<SlabToken>> slabs; // each reserved to SLAB_SIZE, never reallocated
+    size_t firstSlab = 0;                     // global index of slabs.front()
+    size_t count = 0;                         // tokens scanned so far
+    bool done = false;                        // EOF has been scanned
+    // (line, offset of the line's first byte) for every line holding a token.
+    std::vector<std::pair<uint32_t, uint32_t>> lineStarts;
+    std::unordered_map<uint32_t, uint32_t> longLengths;
+    size_t p = 0;
+
+    size_t released() const { return firstSlab << SLAB_BITS; }
+
+    SlabToken& tokenAt(size_t i) { return slabs[(i >> SLAB_BITS) - firstSlab][i & (SLAB_SIZE - 1)]; }
+
+    // Scans up to token i; returns i, or the EOF token's index if the input
+    // ends first.
+    size_t fill(size_t i) {
+        while (count <= i && !done) {
+            scanOne();
+        }
+        return std::min(i, count - 1);
+    }
+
+    void scanOne() {
+        Scanner::Lexeme lex;
+        done = !scanner.next(lex);
+        if (slabs.empty() || slabs.back().size() == SLAB_SIZE) {
+            slabs.emplace_back().reserve(SLAB_SIZE);
+        }
+        uint32_t i = static_cast<uint32_t>(count++);
+        uint32_t line = static_cast<uint32_t>(lex.line);
+        if (lineStarts.empty() || lineStarts.back().first != line) {
+            lineStarts.emplace_back(line, static_cast<uint32_t>(lex.start - lex.column));
+        }
+        if (lex.length >= SlabToken::LONG_LENGTH) {
+            longLengths.emplace(i, static_cast<uint32_t>(lex.length));
+        }
+        uint32_t symbol = lex.type == SysYLexer::IDENT ? interner.intern(scanner.text(lex)) : Interner::NONE;
+        slabs.back().emplace_back(this, lex.type, static_cast<uint32_t>(lex.start), static_cast<uint32_t>(lex.length),
+                                  symbol, i);
+    }
+
+    // The line table entry of the line holding the byte at `offset`. Tokens
+    // never span lines, so that is the last entry starting at or before it.
+    std::vector<std::pair<uint32_t, uint32_t>>::const_iterator lineOf(uint32_t offset) const {
+        auto it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset,
+                                   [](uint32_t o, const std::pair<uint32_t, uint32_t>& entry) { return o < entry.second; });
+        return it == lineStarts.begin() ? it : std::prev(it);
+    }
+};
+
+// An independent read position over a fully scanned SlabTokenStream.
+//
+// Once the whole input is scanned, reading a SlabTokenStream's tokens does not
+// modify it, so several cursors can walk the same tokens concurrently, each
+// with its own index (see ParallelParser). The tokens are the stream's own,
+// so symbolOf() and the line table work for them as usual.
+class SlabTokenCursor : public antlr4::TokenStream {
+public:
+    SlabTokenCursor(SlabTokenStream& tokens, size_t start) : tokens(tokens), p(start) {}
+
+    // --- antlr4::IntStream ---
+
+    void consume() override {
+        if (LA(1) == antlr4::Token::EOF) {
+            throw antlr4::IllegalStateException("cannot consume EOF");
+        }
+        ++p;
+    }
+
+    size_t LA(ssize_t i) override {
+        antlr4::Token* t = LT(i);
+        return t ? t->getType() : antlr4::Token::INVALID_TYPE;
+    }
+
+    ssize_t mark() override { return 0; }
+    void release(ssize_t /*marker*/) override {}
+    size_t index() override { return p; }
+    void seek(size_t i) override { p = std::min(i, tokens.size() - 1); }
+    size_t size() override { return tokens.size(); }
+    std::string getSourceName() const override { return tokens.getSourceName(); }
+
+    // --- antlr4::TokenStream ---
+
+    antlr4::Token* LT(ssize_t k) override {
+        if (k == 0) {
+            return nullptr;
+        }
+        if (k < 0) {
+            size_t back = static_cast<size_t>(-k);
+            return back > p ? nullptr : tokens.get(p - back);
+        }
+        return tokens.get(std::min(p + static_cast<size_t>(k) - 1, tokens.size() - 1));
+    }
+
+    antlr4::Token* get(size_t i) const override { return tokens.get(i); }
+    antlr4::TokenSource* getTokenSource() const override { return tokens.getTokenSource(); }
+    std::string getText(const antlr4::misc::Interval& interval) override { return tokens.getText(interval); }
+    std::string getText() override { return tokens.getText(); }
+    std::string getText(antlr4::RuleContext* ctx) override { return tokens.getText(ctx); }
+    std::string getText(antlr4::Token* start, antlr4::Token* stop) override { return tokens.getText(start, stop); }
+
+private:
+    SlabTokenStream& tokens;
+    size_t p;
+};
+
+inline size_t SlabToken::length() const {
+    return packedLength == LONG_LENGTH ? stream->longLengths.at(index) : packedLength;
+}
+
+inline std::string_view SlabToken::view() const { return {stream->buffer + offset, length()}; }
+
+inline std::string SlabToken::getText() const {
+    return packedType == EOF_CODE ? std::string("<EOF>") : std::string(view());
+}
+
+inline size_t SlabToken::getLine() const { return stream->lineOf(offset)->first; }
+
+inline size_t SlabToken::getCharPositionInLine() const { return offset - stream->lineOf(offset)->second; }
+
+inline antlr4::TokenSource* SlabToken::getTokenSource() const { return &stream->source; }
+
+inline std::string SlabToken::toString() const {
+    // Same layout as CommonToken::toString.
+    std::string text = getText();
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        case '\t': escaped += "\\t"; break;
+        default: escaped += c; break;
+        }
+    }
+    return "[@" + std::to_string(index) + "," + std::to_string(offset) + ":" +
+           std::to_string(static_cast<ssize_t>(getStopIndex())) + "='" + escaped + "',<" +
+           std::to_string(static_cast<ssize_t>(getType())) + ">," + std::to_string(getLine()) + ":" +
+           std::to_string(getCharPositionInLine()) + "]";
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of a source file.
+//
+// Regular files are memory-mapped, so lexing runs straight over the page
+// cache: nothing is copied and the bytes are never widened to code points.
+// Anything that cannot be mapped (pipes, /dev/stdin, empty files) is read
+// into an owned buffer instead. Either way data() stays valid, and
+// unchanged, for the lifetime of the SourceFile; every token text and
+// identifier handed out by the Scanner is a view into it.
+class SourceFile {
+public:
+    explicit SourceFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                mapping = static_cast<const char*>(p);
+                length = static_cast<size_t>(st.st_size);
+                opened = true;
+                ::close(fd);
+                return;
+            }
+        }
+        opened = readAll(fd);
+        ::close(fd);
+    }
+
+    ~SourceFile() {
+        if (mapping) {
+            ::munmap(const_cast<char*>(mapping), length);
+        }
+    }
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    bool isMapped() const { return mapping != nullptr; }
+
+    const char* data() const { return mapping ? mapping : owned.data(); }
+    size_t size() const { return mapping ? length : owned.size(); }
+    std::string_view text() const { return {data(), size()}; }
+
+    // Hints that the bytes before `offset` will not be read again, so their
+    // pages can leave the resident set. Reading them later is still valid:
+    // the pages fault back in from the file.
+    void releaseBefore(size_t offset) {
+        if (!mapping) {
+            return;
+        }
+        size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t bytes = std::min(offset, length) / pageSize * pageSize;
+        if (bytes > releasedTo) {
+            ::madvise(const_cast<char*>(mapping) + releasedTo, bytes - releasedTo, MADV_DONTNEED);
+            releasedTo = bytes;
+        }
+    }
+
+private:
+    const char* mapping = nullptr;
+    size_t length = 0;
+    size_t releasedTo = 0;
+    std::string owned; // fallback when the file cannot be mapped
+    bool opened = false;
+
+    bool readAll(int fd) {
+        char chunk[1 << 16];
+        for (;;) {
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n == 0) {
+                return true;
+            }
+            if (n < 0) {
+                return false;
+            }
+            owned.append(chunk, static_cast<size_t>(n));
+        }
+    }
+};
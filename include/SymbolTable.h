@@ -1,53 +1,84 @@
 #pragma once
 
 #include "IR.h"
-#include <map>
+#include <cstdint>
 #include <vector>
-#include <string>
-#include <algorithm>
+
+struct ConstValue;
 
 // Holds information about a defined symbol (variable, function, etc.)
 struct SymbolInfo {
     TypePtr type;
     ValuePtr value; // Pointer to the Value (usually the address/alloca instruction result for variables)
+    const ConstValue* constant = nullptr; // compile-time value of a const declaration
 };
 
+// Scoped symbol table keyed by interned identifier IDs (see Interner).
+//
+// All live bindings sit on one stack, which doubles as the undo log: each
+// binding remembers the binding of the same ID it shadows, and innermost[id]
+// is the index of the binding currently visible for that ID. Interned IDs are
+// dense, so innermost is a flat array indexed by ID rather than a hash map:
+// lookup is a single load, with no hashing and no string compares, however
+// deeply scopes nest. exitScope() pops the scope's bindings and restores the
+// ones they shadowed, so it costs O(bindings made in that scope).
 class SymbolTable {
-private:
-    // Vector of symbol maps, simulating nested scopes (from global to current inner)
-    std::vector<std::map<std::string, SymbolInfo>> scopes;
-
 public:
     SymbolTable() {
         enterScope(); // Global scope always exists
     }
 
     void enterScope() {
-        scopes.emplace_back(); // Add a new empty map for the new scope
+        scopeStarts.push_back(static_cast<uint32_t>(bindings.size()));
     }
 
     void exitScope() {
-        if (scopes.size() > 1) { 
-            scopes.pop_back();
+        if (scopeStarts.size() <= 1) {
+            return;
+        }
+        uint32_t start = scopeStarts.back();
+        scopeStarts.pop_back();
+        while (bindings.size() > start) {
+            const Binding& binding = bindings.back();
+            innermost[binding.symbol] = binding.shadowed;
+            bindings.pop_back();
         }
     }
 
-    // Adds a symbol to the current scope.
-    bool addSymbol(const std::string& name, TypePtr type, ValuePtr value) {
-        if (scopes.empty() || scopes.back().count(name)) return false; 
-        
-        scopes.back()[name] = {type, value};
+    // Adds a symbol to the current scope. Fails if the current scope already
+    // binds it; bindings in outer scopes are shadowed.
+    bool addSymbol(uint32_t symbol, TypePtr type, ValuePtr value, const ConstValue* constant = nullptr) {
+        if (symbol >= innermost.size()) {
+            innermost.resize(symbol + 1, NONE);
+        }
+        uint32_t visible = innermost[symbol];
+        if (visible != NONE && visible >= scopeStarts.back()) {
+            return false;
+        }
+        innermost[symbol] = static_cast<uint32_t>(bindings.size());
+        bindings.push_back({{type, value, constant}, symbol, visible});
         return true;
     }
 
-    // Looks up a symbol, starting from the current inner scope and moving outwards.
-    SymbolInfo* lookup(const std::string& name) {
-        // Iterate backwards from the innermost scope
-        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-            if (it->count(name)) {
-                return &it->at(name); // Found
-            }
+    // Returns the innermost binding of the symbol, or nullptr. The pointer is
+    // valid until the next addSymbol() or exitScope().
+    SymbolInfo* lookup(uint32_t symbol) {
+        if (symbol >= innermost.size() || innermost[symbol] == NONE) {
+            return nullptr;
         }
-        return nullptr; // Not found
+        return &bindings[innermost[symbol]].info;
     }
-};
\ No newline at end of file
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    struct Binding {
+        SymbolInfo info;
+        uint32_t symbol;
+        uint32_t shadowed; // index of the binding this one hides, or NONE
+    };
+
+    std::vector<Binding> bindings;     // innermost last; the undo log
+    std::vector<uint32_t> scopeStarts; // bindings.size() when each open scope began
+    std::vector<uint32_t> innermost;   // symbol ID -> index into bindings, or NONE
+};
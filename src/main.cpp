@@ -1,60 +1,328 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
+#include <sstream>
 #include <string>
+#include <memory>
+#include <thread>
 
 // ANTLR headers
 #include "antlr4-runtime.h"
 #include "SysYLexer.h"
 #include "SysYParser.h"
+// 构建时由 CMake 从 SysYParser.interp 生成的规则名常量表
+#include "SysYRuleNames.h"
+// 手写词法分析器（默认前端）及其 ANTLR 适配器
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+// 引用源文件缓冲区的紧凑 token 流
+#include "SlabTokenStream.h"
+// 源文件只读映射
+#include "SourceFile.h"
+// 手写递归下降语法分析器（默认前端）
+#include "DescentParser.h"
+// 按顶层项切分、多线程并行的递归下降解析
+#include "ParallelParser.h"
+// SysYParser 预测 DFA 的磁盘缓存
+#include "DFACache.h"
 // 引入您新增的 IRGenerator
-#include "IRGenerator.h" 
+#include "IRGenerator.h"
+// 以 write(2) 整块写出的输出缓冲区
+#include "OutputStream.h"
+// 不依赖 LLVM 库直接写出 LLVM bitcode
+#include "BitcodeWriter.h"
 
 using namespace antlr4;
 
+static void printUsage() {
+  std::cerr << "Usage: ./compiler [options] <input-file> <output-file>\n"
+            << "Options:\n"
+            << "  --lexer=scanner   hand-written DFA lexer (default)\n"
+            << "  --lexer=antlr     ANTLR-generated SysYLexer\n"
+            << "  --parser=descent  hand-written recursive-descent parser (default)\n"
+            << "  --parser=antlr    ANTLR-generated SysYParser\n"
+            << "  --parse-jobs=N    parse top-level items on up to N threads (default: one per core)\n"
+            << "  --dump-tokens     write the token stream instead of IR\n"
+            << "  --dfa-cache=FILE  load/save SysYParser's prediction DFA from/to FILE\n"
+            << "  --time-phases     report the time spent in each phase on stderr\n"
+            << "  --stream          lower each top-level item as soon as it is parsed, then free it\n"
+            << "  --emit=ll         write textual LLVM IR (default)\n"
+            << "  --emit=bc         write LLVM bitcode; needs the whole module, so --stream is ignored\n"
+            << "  --dump-tree       write the parse tree (LISP form) instead of IR"
+            << std::endl;
+}
+
+// One token per line: <type> <line>:<column> <text>
+static void dumpTokens(Scanner &scanner, OutputStream &os) {
+  Scanner::Lexeme lex;
+  while (scanner.next(lex)) {
+    os << lex.type << " " << lex.line << ":" << lex.column << " " << scanner.text(lex) << "\n";
+  }
+}
+
+static void dumpTokens(TokenSource &source, OutputStream &os) {
+  for (;;) {
+    std::unique_ptr<Token> token = source.nextToken();
+    if (token->getType() == Token::EOF) {
+      break;
+    }
+    os << token->getType() << " " << token->getLine() << ":"
+       << token->getCharPositionInLine() << " " << token->getText() << "\n";
+  }
+}
+
+// --time-phases: 各阶段耗时输出到 stderr
+class PhaseTimer {
+public:
+  explicit PhaseTimer(bool enabled) : enabled(enabled), last(std::chrono::steady_clock::now()) {}
+
+  void lap(const char *phase) {
+    if (!enabled) {
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::cerr << phase << ": " << std::chrono::duration<double, std::milli>(now - last).count() << " ms" << std::endl;
+    last = now;
+  }
+
+private:
+  bool enabled;
+  std::chrono::steady_clock::time_point last;
+};
+
+// 两阶段 ANTLR 解析：先以 SLL 预测 + BailErrorStrategy 解析，
+// 只有 SLL 失败（语法错误或需要完整上下文）时才以完整 LL 模式重新解析。
+// trySLL 为 false 时（已知输入有语法错误）直接使用 LL，保留完整的错误报告与恢复。
+static SysYParser::CompUnitContext *parseTwoStage(TokenStream &tokens, SysYParser &parser, bool trySLL) {
+  auto *interpreter = parser.getInterpreter<atn::ParserATNSimulator>();
+  if (trySLL) {
+    interpreter->setPredictionMode(atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
+    parser.removeErrorListeners();
+    try {
+      return parser.compUnit();
+    } catch (ParseCancellationException &) {
+      tokens.seek(0);
+      parser.reset();
+      parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+      parser.addErrorListener(&ConsoleErrorListener::INSTANCE);
+    }
+  }
+  interpreter->setPredictionMode(atn::PredictionMode::LL);
+  return parser.compUnit();
+}
+
 int main(int argc, const char *argv[]) {
-  if (argc < 3) {
-    std::cerr << "Usage: ./compiler <input-file> <output-file>"
-              << std::endl;
+  bool useAntlrLexer = false;
+  bool useAntlrParser = false;
+  bool onlyDumpTokens = false;
+  bool onlyDumpTree = false;
+  bool timePhases = false;
+  bool streamIR = false;
+  bool emitBitcode = false;
+  unsigned parseJobs = std::max(1u, std::thread::hardware_concurrency());
+  std::string dfaCacheFile;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--lexer=antlr") {
+      useAntlrLexer = true;
+    } else if (arg == "--lexer=scanner") {
+      useAntlrLexer = false;
+    } else if (arg == "--parser=antlr") {
+      useAntlrParser = true;
+    } else if (arg == "--parser=descent") {
+      useAntlrParser = false;
+    } else if (arg == "--dump-tokens") {
+      onlyDumpTokens = true;
+    } else if (arg == "--dump-tree") {
+      onlyDumpTree = true;
+    } else if (arg == "--time-phases") {
+      timePhases = true;
+    } else if (arg == "--stream") {
+      streamIR = true;
+    } else if (arg == "--emit=ll") {
+      emitBitcode = false;
+    } else if (arg == "--emit=bc") {
+      emitBitcode = true;
+    } else if (arg.rfind("--parse-jobs=", 0) == 0) {
+      parseJobs = static_cast<unsigned>(std::max(1, std::atoi(arg.c_str() + std::string("--parse-jobs=").size())));
+    } else if (arg.rfind("--dfa-cache=", 0) == 0) {
+      dfaCacheFile = arg.substr(std::string("--dfa-cache=").size());
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option " << arg << std::endl;
+      printUsage();
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() < 2) {
+    printUsage();
     return 1;
   }
-  
+
+  PhaseTimer timer(timePhases);
+
   // 1. 文件输入设置
-  std::string inputFile = argv[1];
-  std::string outputFile = argv[2];
+  std::string inputFile = positional[0];
+  std::string outputFile = positional[1];
 
-  std::ifstream is;
-  is.open(inputFile);
-  if (!is.is_open()) {
+  SourceFile source(inputFile);
+  if (!source.isOpen()) {
       std::cerr << "Could not open input file " << inputFile << std::endl;
       return 1;
   }
 
-  // 2. ANTLR 前端: Lexer & Parser
-  ANTLRInputStream input(is);
-  SysYLexer lexer(&input);
-  CommonTokenStream tokens(&lexer);
-  SysYParser parser(&tokens);
-  
-  // 3. 开始解析
-  SysYParser::CompUnitContext* tree = parser.compUnit();
+  // 所有输出先写入同一块缓冲区，写满或结束时才以 write(2) 写入文件
+  FileOutputStream os(outputFile);
+  if (!os.isOpen()) {
+      std::cerr << "Could not open output file " << outputFile << std::endl;
+      return 1;
+  }
+
+  // 2. 词法分析：手写 Scanner 直接扫描映射的源文件；
+  //    ANTLR SysYLexer 需要先把源文件解码为 UTF-32 的 ANTLRInputStream
+  Scanner scanner(source.data(), source.size(), inputFile);
+  ScannerTokenSource scannerSource(scanner);
+  std::unique_ptr<ANTLRInputStream> input;
+  std::unique_ptr<SysYLexer> antlrLexer;
+  if (useAntlrLexer) {
+    input = std::make_unique<ANTLRInputStream>(source.text());
+    antlrLexer = std::make_unique<SysYLexer>(input.get());
+  }
+
+  timer.lap("read");
+
+  if (onlyDumpTokens) {
+    if (useAntlrLexer) {
+      dumpTokens(*antlrLexer, os);
+    } else {
+      dumpTokens(scanner, os);
+    }
+    return 0;
+  }
+
+  // 流式模式：每个顶层 decl/funcDef 解析完即生成并输出 IR，随后释放其解析子树、
+  // 已消耗的 token 与源文件页，峰值内存只取决于最大的单个顶层项。
+  // 仅适用于默认的 Scanner + 递归下降前端；bitcode 的类型表与函数原型
+  // 须写在所有函数体之前，因此 --emit=bc 时不走流式模式。
+  bool descentFailed = false;
+  if (streamIR && !emitBitcode && !useAntlrLexer && !useAntlrParser && !onlyDumpTree) {
+    Interner interner;
+    SlabTokenStream stream(scannerSource, interner, /*streaming=*/true);
+    DescentParser streamParser(&stream);
+    IRGenerator generator(interner, &stream);
+    // IRGenerator 的诊断信息暂存，结束时再输出，与常规流程一样排在词法错误之后
+    std::ostringstream diagnostics;
+    os << IRPrinter::header();
+    bool ok = streamParser.compUnit([&](ParserRuleContext *item) {
+      std::streambuf *err = std::cerr.rdbuf(diagnostics.rdbuf());
+      try {
+        generator.emitTopLevel(item, os);
+      } catch (...) {
+        std::cerr.rdbuf(err);
+        std::cerr << diagnostics.str();
+        throw;
+      }
+      std::cerr.rdbuf(err);
+      stream.releaseConsumed();
+      source.releaseBefore(stream.LT(1)->getStartIndex());
+    });
+    if (ok) {
+      std::cerr << diagnostics.str();
+      if (!os.close()) {
+        std::cerr << "Could not write output file " << outputFile << std::endl;
+        return 1;
+      }
+      timer.lap("stream");
+      return 0;
+    }
+    // 语法错误：丢弃已输出的 IR，按常规流程从头重新处理以获得完整的错误报告
+    os.close();
+    os.open(outputFile);
+    scanner.rewind();
+    descentFailed = true;
+  }
+
+  // Scanner 的 token 分配在连续的 slab 中，文本按需从源文件缓冲区取出
+  // 标识符在扫描时即驻留为整数 ID，符号表按 ID 查找
+  Interner interner;
+  std::unique_ptr<TokenStream> tokens;
+  SlabTokenStream *slabTokens = nullptr;
+  if (useAntlrLexer) {
+    auto common = std::make_unique<CommonTokenStream>(antlrLexer.get());
+    common->fill();
+    tokens = std::move(common);
+  } else {
+    auto slab = std::make_unique<SlabTokenStream>(scannerSource, interner);
+    slabTokens = slab.get();
+    tokens = std::move(slab);
+  }
+  timer.lap("lex");
+
+  // 3. 语法分析：递归下降分析器遇到第一个语法错误即放弃，
+  //    此时回退到 ANTLR SysYParser 以获得完整的错误报告与恢复。
+  //    Scanner 的 token 流已完整扫描，可按顶层项切块、多线程并行解析
+  DescentParser descent(tokens.get());
+  std::unique_ptr<ParallelParser> parallel;
+  std::unique_ptr<SysYParser> parser;
+  SysYParser::CompUnitContext* tree = nullptr;
+  if (!useAntlrParser && !descentFailed) {
+    if (slabTokens && parseJobs > 1) {
+      parallel = std::make_unique<ParallelParser>(*slabTokens, parseJobs);
+      tree = parallel->compUnit();
+    } else {
+      tree = descent.compUnit();
+    }
+  }
+  if (!tree) {
+    tokens->seek(0);
+    parser = std::make_unique<SysYParser>(tokens.get());
+    timer.lap("parser init");
+    size_t dfaStates = 0;
+    if (!dfaCacheFile.empty()) {
+      DFACache::load(*parser, dfaCacheFile);
+      dfaStates = DFACache::stateCount(*parser);
+      timer.lap("dfa-cache load");
+    }
+    tree = parseTwoStage(*tokens, *parser, useAntlrParser);
+    if (!dfaCacheFile.empty() && DFACache::stateCount(*parser) != dfaStates) {
+      DFACache::save(*parser, dfaCacheFile);
+    }
+  }
+  timer.lap("parse");
+
+  if (onlyDumpTree) {
+    if (parser) {
+      os << tree->toStringTree(parser.get()) << "\n";
+    } else {
+      // 规则名取自生成的常量表，不必为此构造 SysYParser、反序列化其 ATN
+      std::vector<std::string> ruleNames(std::begin(SYSY_RULE_NAMES), std::end(SYSY_RULE_NAMES));
+      os << tree->toStringTree(ruleNames) << "\n";
+    }
+    return 0;
+  }
 
   // 4. IR 生成（核心翻译部分）
-  IRGenerator generator;
+  IRGenerator generator(interner, slabTokens);
   generator.visit(tree); // 遍历解析树并生成 IR
+  timer.lap("irgen");
 
-  // 5. 输出 IR 到文件
-  std::string irCode = generator.getIR();
-
-  std::ofstream os;
-  os.open(outputFile);
-  if (!os.is_open()) {
-      std::cerr << "Could not open output file " << outputFile << std::endl;
-      return 1;
+  // 5. 输出 IR 到文件：直接打印进输出缓冲区，不先拼成完整的字符串；
+  //    --emit=bc 时写出等价的 bitcode
+  if (emitBitcode) {
+    BitcodeWriter::write(generator.getModule(), os);
+  } else {
+    generator.printIR(os);
+  }
+  if (!os.close()) {
+    std::cerr << "Could not write output file " << outputFile << std::endl;
+    return 1;
   }
-  
-  os << irCode;
-  os.close();
+  timer.lap("emit");
 
   // 成功
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,136 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "SysYParser.h"
+#include "DFACache.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SourceFile.h"
+#include "SysYSource.h"
+
+// SysYParser's first parse in a new process, with a cold prediction DFA and
+// with the DFA loaded from a --dfa-cache file. The cache is trained the way
+// the compiler fills it: by parsing every input once and saving. Each input
+// is then parsed (SLL, as the compiler's first stage) after clearing the
+// decision DFAs, which stands in for a fresh process, and after clearing
+// and loading the cache; the load is timed on its own. Best of 5 runs.
+//
+//   DFACacheBench FILE...        the given .sy files
+//   DFACacheBench                synthetic programs of 4 KB and 64 KB
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Input {
+    std::string name;
+    std::string source;
+};
+
+class Parse {
+public:
+    explicit Parse(const Input& input)
+        : scanner(input.source.data(), input.source.size(), input.name), tokenSource(scanner),
+          tokens(tokenSource, interner), parser(&tokens) {
+        parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->setPredictionMode(
+            antlr4::atn::PredictionMode::SLL);
+        parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+        parser.removeErrorListeners();
+    }
+
+    SysYParser& get() { return parser; }
+
+    // Like the compiler, re-parses in LL mode when SLL bails (on the
+    // suite's inputs with syntax errors), with the diagnostics dropped.
+    double run() {
+        Clock::time_point start = Clock::now();
+        try {
+            parser.compUnit();
+        } catch (antlr4::ParseCancellationException&) {
+            tokens.seek(0);
+            parser.reset();
+            parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+            parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->setPredictionMode(
+                antlr4::atn::PredictionMode::LL);
+            parser.compUnit();
+        }
+        return millisSince(start);
+    }
+
+private:
+    Scanner scanner;
+    ScannerTokenSource tokenSource;
+    Interner interner;
+    SlabTokenStream tokens;
+    SysYParser parser;
+};
+
+static void clearDFA(SysYParser& parser) {
+    parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->clearDFA();
+}
+
+int main(int argc, const char* argv[]) {
+    std::vector<Input> inputs;
+    for (int i = 1; i < argc; ++i) {
+        SourceFile file(argv[i]);
+        if (!file.isOpen()) {
+            std::cerr << "cannot open " << argv[i] << "\n";
+            return 1;
+        }
+        inputs.push_back({argv[i], std::string(file.text())});
+    }
+    if (inputs.empty()) {
+        inputs.push_back({"synthetic 4 KB", syntheticProgram(4 << 10)});
+        inputs.push_back({"synthetic 64 KB", syntheticProgram(64 << 10)});
+    }
+
+    std::string cacheFile = "/tmp/DFACacheBench." + std::to_string(getpid()) + ".dfa";
+    {
+        Parse first(inputs[0]);
+        clearDFA(first.get());
+        for (const Input& input : inputs) {
+            Parse(input).run();
+        }
+        if (!DFACache::save(first.get(), cacheFile)) {
+            std::cerr << "cannot write " << cacheFile << "\n";
+            return 1;
+        }
+        std::cout << "cache: " << DFACache::stateCount(first.get()) << " DFA states\n";
+    }
+
+    for (const Input& input : inputs) {
+        double cold = 1e30, load = 1e30, warm = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            Parse coldParse(input);
+            clearDFA(coldParse.get());
+            cold = std::min(cold, coldParse.run());
+
+            Parse warmParse(input);
+            clearDFA(warmParse.get());
+            Clock::time_point start = Clock::now();
+            if (!DFACache::load(warmParse.get(), cacheFile)) {
+                std::cerr << "cannot load " << cacheFile << "\n";
+                return 1;
+            }
+            load = std::min(load, millisSince(start));
+            warm = std::min(warm, warmParse.run());
+        }
+        std::cout << input.name << ": cold " << cold << " ms, warm " << warm << " ms (+ load "
+                  << load << " ms)\n";
+    }
+    std::remove(cacheFile.c_str());
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DescentParser.h"
+#include "IRGenerator.h"
+#include "Interner.h"
+#include "OutputStream.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+
+// Front end on `return <expr>;` with one deeply nested expression, where
+// `a` is a local: lexing, parsing (DescentParser), lowering (IRGenerator,
+// through ExpWalker) and printing are timed separately. Each of these must
+// take time linear in the depth and must not grow the native stack.
+// Best of 3 runs.
+//
+//   DeepNestingBench                  every shape at depths 1e3 .. 1e6
+//   DeepNestingBench SHAPE DEPTH      one case, with the peak RSS
+//
+// Shapes: chain (a + a + ... + a), right (a + (a + (... a))),
+// parens ((( ... a ... ))), unary (- - ... - a).
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::string program(const std::string& shape, size_t depth) {
+    std::string exp;
+    if (shape == "chain") {
+        exp = "a";
+        for (size_t i = 1; i < depth; ++i) exp += " + a";
+    } else if (shape == "right") {
+        for (size_t i = 1; i < depth; ++i) exp += "a + (";
+        exp += "a" + std::string(depth - 1, ')');
+    } else if (shape == "parens") {
+        exp = std::string(depth, '(') + "a" + std::string(depth, ')');
+    } else if (shape == "unary") {
+        for (size_t i = 0; i < depth; ++i) exp += "- ";
+        exp += "a";
+    } else {
+        std::cerr << "unknown shape " << shape << "\n";
+        std::exit(1);
+    }
+    return "int main() {\n    int a = 1;\n    return " + exp + ";\n}\n";
+}
+
+struct Times {
+    double lex = 1e30, parse = 1e30, lower = 1e30, print = 1e30;
+};
+
+static Times run(const std::string& shape, size_t depth) {
+    std::string source = program(shape, depth);
+    Times best;
+    for (int i = 0; i < 3; ++i) {
+        Clock::time_point start = Clock::now();
+        Scanner scanner(source.data(), source.size());
+        ScannerTokenSource tokenSource(scanner);
+        Interner interner;
+        SlabTokenStream tokens(tokenSource, interner);
+        best.lex = std::min(best.lex, millisSince(start));
+
+        start = Clock::now();
+        DescentParser parser(&tokens);
+        SysYParser::CompUnitContext* tree = parser.compUnit();
+        if (!tree) {
+            std::cerr << shape << " " << depth << ": syntax error\n";
+            std::exit(1);
+        }
+        best.parse = std::min(best.parse, millisSince(start));
+
+        start = Clock::now();
+        IRGenerator generator(interner, &tokens);
+        generator.visit(tree);
+        best.lower = std::min(best.lower, millisSince(start));
+
+        start = Clock::now();
+        std::string ir;
+        StringOutputStream os(ir);
+        generator.printIR(os);
+        os.flush();
+        best.print = std::min(best.print, millisSince(start));
+    }
+    return best;
+}
+
+static void report(const std::string& shape, size_t depth, const Times& t) {
+    std::cout << shape << " " << depth << ": lex " << t.lex << " ms, parse " << t.parse
+              << " ms, lower " << t.lower << " ms, print " << t.print << " ms\n";
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc > 2) {
+        std::string shape = argv[1];
+        size_t depth = std::strtoull(argv[2], nullptr, 10);
+        report(shape, depth, run(shape, depth));
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << "peak RSS " << usage.ru_maxrss / 1024 << " MB\n";
+        return 0;
+    }
+    for (const char* shape : {"chain", "right", "parens", "unary"}) {
+        for (size_t depth = 1000; depth <= 1000000; depth *= 10) {
+            report(shape, depth, run(shape, depth));
+        }
+    }
+    return 0;
+}
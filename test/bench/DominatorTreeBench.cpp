@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "DominatorTree.h"
+
+// Keeps a dominator tree current over a series of CFG edits, once with
+// insertEdge/deleteEdge and once by recalculating after each edit. The CFG
+// stands in for a long function: a chain of `regions` if/else diamonds and
+// while loops, in random order. Best of 5 runs.
+//
+//   DominatorTreeBench [regions] [edits] [--local] [--post]
+//     (defaults: 10000 regions, 1000 edits)
+//
+// By default each edit inserts a short cut from a random block to one of
+// the next six, and deletes it again. A short cut that skips a region
+// changes the level of every later block, and deleting it rebuilds that
+// tail. With --local, each edit adds and removes an edge from a loop body
+// to the loop's exit, or from an arm of a diamond to its join, which
+// changes no dominator. --post runs on the post-dominator tree.
+
+using Edges = std::vector<std::pair<uint32_t, uint32_t>>;
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static Edges buildChain(uint32_t regions, std::mt19937& rng, uint32_t& numBlocks) {
+    Edges edges;
+    uint32_t current = 0;
+    numBlocks = 1;
+    for (uint32_t r = 0; r < regions; ++r) {
+        if (rng() % 2) {
+            uint32_t then = numBlocks++, otherwise = numBlocks++, join = numBlocks++;
+            edges.insert(edges.end(), {{current, then}, {current, otherwise}, {then, join}, {otherwise, join}});
+            current = join;
+        } else {
+            uint32_t header = numBlocks++, body = numBlocks++, exit = numBlocks++;
+            edges.insert(edges.end(), {{current, header}, {header, body}, {body, header}, {header, exit}});
+            current = exit;
+        }
+    }
+    return edges;
+}
+
+int main(int argc, const char* argv[]) {
+    uint32_t regions = 10000;
+    size_t numEdits = 1000;
+    bool local = false, post = false;
+    std::vector<uint32_t> numbers;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--local") {
+            local = true;
+        } else if (arg == "--post") {
+            post = true;
+        } else {
+            numbers.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+        }
+    }
+    if (numbers.size() > 0) {
+        regions = std::max<uint32_t>(numbers[0], 2);
+    }
+    if (numbers.size() > 1) {
+        numEdits = numbers[1];
+    }
+
+    std::mt19937 rng(7);
+    uint32_t numBlocks = 0;
+    Edges edges = buildChain(regions, rng, numBlocks);
+    Edges edits;
+    if (local) {
+        // then -> join, or body -> exit: both are blocks b + 1 -> b + 2
+        // after an edge b -> b + 1 that enters a region.
+        for (auto [from, to] : edges) {
+            if (to == from + 1 && to + 1 < numBlocks && rng() % 4 == 0 && edits.size() < numEdits) {
+                edits.push_back({from + 1, from + 2});
+            }
+        }
+    } else {
+        for (size_t i = 0; i < numEdits; ++i) {
+            uint32_t from = rng() % (numBlocks - 8);
+            edits.push_back({from, from + 1 + rng() % 6});
+        }
+    }
+
+    double incremental = 1e30, recalculated = 1e30, oneBuild = 1e30;
+    for (int run = 0; run < 5; ++run) {
+        Clock::time_point start = Clock::now();
+        DominatorTree tree(numBlocks, edges, post);
+        oneBuild = std::min(oneBuild, millisSince(start));
+
+        start = Clock::now();
+        for (auto [from, to] : edits) {
+            tree.insertEdge(from, to);
+            tree.deleteEdge(from, to);
+        }
+        incremental = std::min(incremental, millisSince(start));
+
+        start = Clock::now();
+        for (auto [from, to] : edits) {
+            tree.insertEdge(from, to);
+            tree.recalculate();
+            tree.deleteEdge(from, to);
+            tree.recalculate();
+        }
+        // The updates in this loop are also timed, but are dwarfed by the
+        // two rebuilds per edit.
+        recalculated = std::min(recalculated, millisSince(start));
+        if (!tree.verify()) {
+            std::cerr << "tree does not match a fresh build\n";
+            return 1;
+        }
+    }
+    std::cout << numBlocks << " blocks, " << 2 * edits.size() << " edits" << (local ? " (local)" : "")
+              << (post ? ", post-dominators" : "") << "\n";
+    std::cout << "one build                  " << oneBuild << " ms\n";
+    std::cout << "insertEdge/deleteEdge      " << incremental << " ms\n";
+    std::cout << "recalculate after each     " << recalculated << " ms\n";
+    return 0;
+}
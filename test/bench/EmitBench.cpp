@@ -0,0 +1,116 @@
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "BitcodeWriter.h"
+#include "DescentParser.h"
+#include "IRGenerator.h"
+#include "IRPrinter.h"
+#include "Interner.h"
+#include "OutputStream.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SysYSource.h"
+
+// Emission throughput and peak RSS on a synthetic module of about 10^6
+// instructions in 100 functions, for each way of writing it out:
+//   ll          IRPrinter straight into a FileOutputStream (the compiler)
+//   ll-string   IRPrinter::toString, then the string through an ofstream
+//               (the copy the compiler used to make before it printed
+//               straight into the file)
+//   bc          BitcodeWriter into a FileOutputStream (--emit=bc)
+// Each mode runs in a child process of its own, so its peak RSS is its own:
+// the module is built, then written 3 times to a file in /tmp, and the best
+// time is reported with the peak RSS before and after writing.
+//
+//   EmitBench [instructions]    (default: 1000000)
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static long peakRssMB() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;
+}
+
+static void write(const std::string& mode, const Module& module, const std::string& path) {
+    if (mode == "ll-string") {
+        std::string text = IRPrinter::toString(module);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << text;
+        return;
+    }
+    FileOutputStream os(path);
+    if (mode == "bc") {
+        BitcodeWriter::write(module, os);
+    } else {
+        IRPrinter::print(module, os);
+    }
+    os.close();
+}
+
+static int runMode(const std::string& mode, size_t instructions) {
+    std::string source = syntheticModuleProgram(instructions, 100);
+    Scanner scanner(source.data(), source.size());
+    ScannerTokenSource tokenSource(scanner);
+    Interner interner;
+    SlabTokenStream tokens(tokenSource, interner);
+    DescentParser parser(&tokens);
+    SysYParser::CompUnitContext* tree = parser.compUnit();
+    if (!tree) {
+        std::cerr << "syntax error in the generated program\n";
+        return 1;
+    }
+    IRGenerator generator(interner, &tokens);
+    generator.visit(tree);
+    long rssBefore = peakRssMB();
+
+    std::string path = "/tmp/EmitBench." + std::to_string(getpid()) + "." + mode;
+    double best = 1e30;
+    for (int i = 0; i < 3; ++i) {
+        Clock::time_point start = Clock::now();
+        write(mode, generator.getModule(), path);
+        best = std::min(best, millisSince(start));
+    }
+    struct stat st;
+    double megabytes = stat(path.c_str(), &st) == 0 ? st.st_size / 1e6 : 0;
+    std::remove(path.c_str());
+
+    std::cout << "  " << mode << std::string(11 - mode.size(), ' ') << best << " ms, " << megabytes
+              << " MB (" << megabytes / (best / 1000) << " MB/s), peak RSS " << rssBefore << " -> "
+              << peakRssMB() << " MB" << std::endl;
+    return 0;
+}
+
+int main(int argc, const char* argv[]) {
+    size_t instructions = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::cout << "about " << instructions << " instructions in 100 functions" << std::endl;
+    int status = 0;
+    for (const char* mode : {"ll", "ll-string", "bc"}) {
+        pid_t child = fork();
+        if (child == 0) {
+            std::exit(runMode(mode, instructions));
+        }
+        int childStatus = 1;
+        waitpid(child, &childStatus, 0);
+        if (!WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0) {
+            std::cerr << mode << " failed\n";
+            status = 1;
+        }
+    }
+    return status;
+}
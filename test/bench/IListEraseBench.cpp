@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "IR.h"
+#include "IRBuilder.h"
+
+// Erases every other instruction of a block of n `add` instructions, each
+// with two constant operands: once from the block's IList, and once from a
+// vector of the same instructions, the way blocks were stored before. The
+// vector shifts its tail on every erase, so it is quadratic.
+//
+//   IListEraseBench [n] [--no-vector]    (n defaults to 100000)
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static Function* makeFunction(Module& module) {
+    IRContext& context = module.getContext();
+    return module.addFunction(context.getFunctionTy(Type::getInt32Ty(), {}), "f");
+}
+
+static double eraseFromIList(size_t n) {
+    Module module;
+    BasicBlock* block = makeFunction(module)->getEntryBlock();
+    IRBuilder builder;
+    builder.setInsertPoint(block);
+    for (size_t i = 0; i < n; ++i) {
+        builder.CreateBinary(Instruction::Add, module.getContext().getInt32(static_cast<int32_t>(i)),
+                             module.getContext().getInt32(1));
+    }
+    Clock::time_point start = Clock::now();
+    for (auto it = block->instList.begin(); it != block->instList.end();) {
+        it = block->instList.erase(it);
+        if (it != block->instList.end()) {
+            ++it;
+        }
+    }
+    double millis = millisSince(start);
+    if (block->instList.size() != n / 2) {
+        std::cerr << "wrong size " << block->instList.size() << "\n";
+        std::exit(1);
+    }
+    return millis;
+}
+
+static double eraseFromVector(size_t n) {
+    Module module;
+    makeFunction(module);
+    Arena& arena = module.getArena();
+    std::vector<Instruction*> insts;
+    for (size_t i = 0; i < n; ++i) {
+        insts.push_back(new (arena, 2) Instruction(Instruction::Add, Type::getInt32Ty(),
+                                                   {module.getContext().getInt32(static_cast<int32_t>(i)),
+                                                    module.getContext().getInt32(1)}));
+    }
+    auto free = [&arena](Instruction* inst) {
+        size_t size = inst->getAllocSize();
+        inst->~Instruction();
+        arena.recycle(inst, size);
+    };
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < insts.size(); ++i) {
+        free(insts[i]);
+        insts.erase(insts.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+    double millis = millisSince(start);
+    for (Instruction* inst : insts) {
+        free(inst);
+    }
+    return millis;
+}
+
+int main(int argc, const char* argv[]) {
+    size_t n = 100000;
+    bool vector = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--no-vector") {
+            vector = false;
+        } else {
+            n = std::strtoull(argv[i], nullptr, 10);
+        }
+    }
+    std::cout << "n = " << n << "\n";
+    std::cout << "IList   " << eraseFromIList(n) << " ms\n";
+    if (vector) {
+        std::cout << "vector  " << eraseFromVector(n) << " ms\n";
+    }
+    return 0;
+}
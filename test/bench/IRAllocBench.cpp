@@ -0,0 +1,144 @@
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "DescentParser.h"
+#include "IR.h"
+#include "IRBuilder.h"
+#include "IRGenerator.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SysYSource.h"
+
+// Heap allocations and frees while IRGenerator builds a synthetic module of
+// about 10^6 instructions in 100 functions, and the time to build it and to
+// tear it down again. Lexing and parsing happen first and are not counted.
+// Times are the best of 3 runs; counts are the same on every run.
+//
+// Then the memory per instruction by operand count: the heap growth
+// (mallinfo2) while IRBuilder appends that many instructions of one kind to
+// one block, divided by their number.
+//
+//   IRAllocBench [instructions] [functions]    (defaults: 1000000 and 100)
+
+static size_t allocations = 0;
+static size_t frees = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept {
+    frees += p != nullptr;
+    std::free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static size_t instructionCount(const Module& module) {
+    size_t n = 0;
+    for (const Function& func : module.funcList) {
+        for (const BasicBlock& block : func.blockList) {
+            n += block.instList.size();
+        }
+    }
+    return n;
+}
+
+// Appends n instructions made by `create` to a fresh function and returns
+// the heap growth per instruction.
+template <typename Create>
+static double bytesPerInstruction(size_t n, Create create) {
+    Module module;
+    IRContext& context = module.getContext();
+    Function* func = module.addFunction(context.getFunctionTy(Type::getInt32Ty(), {}), "f");
+    IRBuilder builder;
+    builder.setInsertPoint(func->getEntryBlock());
+    Value* array = builder.CreateAlloca(context.getArrayTy(Type::getInt32Ty(), std::vector<int>{4, 4}));
+    Value* scalar = builder.CreateAlloca(Type::getInt32Ty());
+    size_t before = mallinfo2().uordblks;
+    for (size_t i = 0; i < n; ++i) {
+        create(builder, context, array, scalar);
+    }
+    return double(mallinfo2().uordblks - before) / n;
+}
+
+static void reportMemory(size_t n) {
+    std::cout << "memory per instruction, " << n << " appended to one block\n";
+    auto line = [](const char* label, double bytes) { std::cout << "  " << label << bytes << " B\n"; };
+    line("ret void (0 operands)  ", bytesPerInstruction(n, [](IRBuilder& b, IRContext&, Value*, Value*) {
+        b.CreateRetVoid();
+    }));
+    line("load (1)               ", bytesPerInstruction(n, [](IRBuilder& b, IRContext&, Value*, Value* scalar) {
+        b.CreateLoad(scalar);
+    }));
+    line("add (2)                ", bytesPerInstruction(n, [](IRBuilder& b, IRContext& c, Value*, Value*) {
+        b.CreateBinary(Instruction::Add, c.getInt32(1), c.getInt32(2));
+    }));
+    line("gep a[i][j] (4)        ", bytesPerInstruction(n, [](IRBuilder& b, IRContext& c, Value* array, Value*) {
+        b.CreateInBoundsGEP(c.getArrayTy(Type::getInt32Ty(), std::vector<int>{4, 4}), array,
+                            {c.getInt32(0), c.getInt32(1), c.getInt32(2)});
+    }));
+}
+
+int main(int argc, const char* argv[]) {
+    size_t instructions = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t functions = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100;
+
+    std::string source = syntheticModuleProgram(instructions, functions);
+    Scanner scanner(source.data(), source.size());
+    ScannerTokenSource tokenSource(scanner);
+    Interner interner;
+    SlabTokenStream tokens(tokenSource, interner);
+    DescentParser parser(&tokens);
+    SysYParser::CompUnitContext* tree = parser.compUnit();
+    if (!tree) {
+        std::cerr << "syntax error in the generated program\n";
+        return 1;
+    }
+
+    double build = 1e30, teardown = 1e30;
+    size_t buildAllocations = 0, buildFrees = 0, teardownFrees = 0, count = 0;
+    for (int run = 0; run < 3; ++run) {
+        size_t allocationsBefore = allocations, freesBefore = frees;
+        Clock::time_point start = Clock::now();
+        auto generator = std::make_unique<IRGenerator>(interner, &tokens);
+        generator->visit(tree);
+        build = std::min(build, millisSince(start));
+        buildAllocations = allocations - allocationsBefore;
+        buildFrees = frees - freesBefore;
+        count = instructionCount(generator->getModule());
+
+        freesBefore = frees;
+        start = Clock::now();
+        generator.reset();
+        teardown = std::min(teardown, millisSince(start));
+        teardownFrees = frees - freesBefore;
+    }
+    std::cout << count << " instructions in " << functions << " functions\n"
+              << "  build     " << build << " ms, " << buildAllocations << " allocations, " << buildFrees
+              << " frees\n"
+              << "  teardown  " << teardown << " ms, " << teardownFrees << " frees\n";
+
+    reportMemory(instructions);
+    return 0;
+}
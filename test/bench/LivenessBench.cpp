@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "FunctionSnapshot.h"
+#include "IR.h"
+#include "IRBuilder.h"
+#include "Liveness.h"
+
+// Maximum register pressure of one function of n `add` instructions, each
+// using two random results from the last `window` values. It is computed
+// on the pointer IR with an unordered_set live set, and on a
+// FunctionSnapshot with Liveness; the snapshot build is timed on its own.
+// Best of 5 runs.
+//
+//   LivenessBench [n] [window]    (defaults: 1000000 and 64)
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// The IR has no branches yet, so every function is one block and a single
+// backward scan is the whole analysis.
+static uint32_t pointerPressure(Function& func) {
+    std::unordered_set<Value*> live;
+    size_t pressure = 0;
+    for (BasicBlock& block : func.blockList) {
+        live.clear();
+        for (auto it = block.instList.end(); it != block.instList.begin();) {
+            Instruction& inst = *--it;
+            live.erase(&inst);
+            for (size_t i = 0; i < inst.getNumOperands(); ++i) {
+                if (Instruction* op = inst.getOperand(i)->asInstruction()) {
+                    live.insert(op);
+                }
+            }
+            pressure = std::max(pressure, live.size());
+        }
+    }
+    return static_cast<uint32_t>(pressure);
+}
+
+int main(int argc, const char* argv[]) {
+    size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t window = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+
+    Module module;
+    IRContext& context = module.getContext();
+    Function* func = module.addFunction(context.getFunctionTy(Type::getInt32Ty(), {}), "f");
+    IRBuilder builder;
+    builder.setInsertPoint(func->getEntryBlock());
+    std::mt19937 rng(1);
+    std::vector<Value*> values{context.getInt32(1)};
+    for (size_t i = 0; i < n; ++i) {
+        auto pick = [&] {
+            size_t recent = std::min(window, values.size());
+            return values[values.size() - 1 - rng() % recent];
+        };
+        Value* lhs = pick();
+        values.push_back(builder.CreateBinary(Instruction::Add, lhs, pick()));
+    }
+    builder.CreateRet(values.back());
+
+    double pointerMillis = 1e30, snapshotMillis = 1e30, livenessMillis = 1e30;
+    uint32_t pointerResult = 0, snapshotResult = 0;
+    for (int run = 0; run < 5; ++run) {
+        Clock::time_point start = Clock::now();
+        pointerResult = pointerPressure(*func);
+        pointerMillis = std::min(pointerMillis, millisSince(start));
+
+        start = Clock::now();
+        FunctionSnapshot snapshot(*func);
+        snapshotMillis = std::min(snapshotMillis, millisSince(start));
+        start = Clock::now();
+        Liveness liveness(snapshot);
+        snapshotResult = liveness.maxPressure();
+        livenessMillis = std::min(livenessMillis, millisSince(start));
+    }
+    std::cout << "n = " << n << ", window = " << window << "\n";
+    std::cout << "pointer IR, unordered_set live set  " << pointerMillis << " ms, pressure " << pointerResult << "\n";
+    std::cout << "snapshot build                      " << snapshotMillis << " ms\n";
+    std::cout << "Liveness on the snapshot            " << livenessMillis << " ms, pressure " << snapshotResult << "\n";
+    return pointerResult == snapshotResult ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <any>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "SysYParser.h"
+#include "SysYParserBaseVisitor.h"
+#include "DescentParser.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+
+// Expression dispatch in IRGenerator: the std::any visitor it used to lower
+// expressions with (accept(), the generated exp(i) accessors, any_cast)
+// against the positional switch lowerExp uses now (rule index and token type
+// of the children, static_cast). Both do the same trivial work per node, an
+// integer evaluation, over the same parse trees of random arithmetic, so the
+// difference is the dispatch. Best of 9 runs.
+//
+//   LowerDispatchBench [functions] [depth]    (defaults: 400 and 9)
+
+using Clock = std::chrono::steady_clock;
+using antlr4::tree::ParseTree;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Same per-node work for both: leaves take a value from their token's
+// offset (`a` is 1), operators apply with the divisor kept nonzero.
+static int leafValue(antlr4::Token* token) { return static_cast<int>(token->getStartIndex() & 15); }
+
+static int apply(size_t op, int lhs, int rhs) {
+    switch (op) {
+    case SysYParser::PLUS: return lhs + rhs;
+    case SysYParser::MINUS: return lhs - rhs;
+    case SysYParser::MUL: return lhs * rhs;
+    case SysYParser::DIV: return lhs / (rhs | 1);
+    case SysYParser::MOD: return lhs % (rhs | 1);
+    case SysYParser::LT: return lhs < rhs;
+    case SysYParser::GT: return lhs > rhs;
+    case SysYParser::LE: return lhs <= rhs;
+    case SysYParser::GE: return lhs >= rhs;
+    case SysYParser::EQ: return lhs == rhs;
+    case SysYParser::NEQ: return lhs != rhs;
+    default: return 0;
+    }
+}
+
+static int applyUnary(size_t op, int operand) {
+    return op == SysYParser::MINUS ? -operand : op == SysYParser::NOT ? !operand : operand;
+}
+
+// The old way: one visit* override per labeled alternative, results boxed.
+class AnyEvaluator : public SysYParserBaseVisitor {
+public:
+    std::any visitNumberExp(SysYParser::NumberExpContext* ctx) override {
+        return leafValue(ctx->number()->IntConst()->getSymbol());
+    }
+    std::any visitLValExp(SysYParser::LValExpContext*) override { return 1; }
+    std::any visitParenExp(SysYParser::ParenExpContext* ctx) override { return visit(ctx->exp()); }
+    std::any visitUnaryExp(SysYParser::UnaryExpContext* ctx) override {
+        size_t op = ctx->MINUS() ? SysYParser::MINUS : ctx->NOT() ? SysYParser::NOT : SysYParser::PLUS;
+        return applyUnary(op, std::any_cast<int>(visit(ctx->exp())));
+    }
+    std::any visitMulDivModExp(SysYParser::MulDivModExpContext* ctx) override { return binary(ctx); }
+    std::any visitAddSubExp(SysYParser::AddSubExpContext* ctx) override { return binary(ctx); }
+    std::any visitRelExp(SysYParser::RelExpContext* ctx) override { return binary(ctx); }
+    std::any visitEqNeqExp(SysYParser::EqNeqExpContext* ctx) override { return binary(ctx); }
+
+private:
+    template <typename Context>
+    std::any binary(Context* ctx) {
+        int lhs = std::any_cast<int>(visit(ctx->exp(0)));
+        int rhs = std::any_cast<int>(visit(ctx->exp(1)));
+        auto* op = static_cast<antlr4::tree::TerminalNode*>(ctx->children[1]);
+        return apply(op->getSymbol()->getType(), lhs, rhs);
+    }
+};
+
+// The new way, as in IRGenerator::lowerExp.
+static bool isToken(ParseTree* node) { return node->getTreeType() == antlr4::tree::ParseTreeType::TERMINAL; }
+
+static size_t tokenType(ParseTree* node) {
+    return static_cast<antlr4::tree::TerminalNode*>(node)->getSymbol()->getType();
+}
+
+static int switchEvaluate(SysYParser::ExpContext* ctx) {
+    const auto& children = ctx->children;
+    ParseTree* first = children[0];
+    if (isToken(first)) {
+        size_t type = tokenType(first);
+        auto* operand = static_cast<SysYParser::ExpContext*>(children[1]);
+        return type == SysYParser::L_PAREN ? switchEvaluate(operand) : applyUnary(type, switchEvaluate(operand));
+    }
+    auto* rule = static_cast<antlr4::ParserRuleContext*>(first);
+    switch (rule->getRuleIndex()) {
+    case SysYParser::RuleLVal:
+        return 1;
+    case SysYParser::RuleNumber:
+        return leafValue(static_cast<antlr4::tree::TerminalNode*>(rule->children[0])->getSymbol());
+    default: {
+        int lhs = switchEvaluate(static_cast<SysYParser::ExpContext*>(first));
+        int rhs = switchEvaluate(static_cast<SysYParser::ExpContext*>(children[2]));
+        return apply(tokenType(children[1]), lhs, rhs);
+    }
+    }
+}
+
+static std::string randomExp(std::mt19937& rng, int depth) {
+    if (depth == 0 || rng() % 8 == 0) {
+        return rng() % 4 == 0 ? "a" : std::to_string(rng() % 100);
+    }
+    static const char* ops[] = {"+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!="};
+    switch (rng() % 6) {
+    case 0: return "(" + randomExp(rng, depth - 1) + ")";
+    case 1: return std::string(rng() % 2 ? "-" : "!") + randomExp(rng, depth - 1);
+    default: return randomExp(rng, depth - 1) + " " + ops[rng() % 11] + " " + randomExp(rng, depth - 1);
+    }
+}
+
+// Expressions not nested in another expression; the evaluators recurse
+// from these.
+static void collectRoots(ParseTree* tree, std::vector<SysYParser::ExpContext*>& roots) {
+    std::vector<ParseTree*> work{tree};
+    while (!work.empty()) {
+        ParseTree* node = work.back();
+        work.pop_back();
+        auto* rule = dynamic_cast<antlr4::ParserRuleContext*>(node);
+        if (!rule) continue;
+        if (rule->getRuleIndex() == SysYParser::RuleExp) {
+            roots.push_back(static_cast<SysYParser::ExpContext*>(rule));
+            continue;
+        }
+        work.insert(work.end(), rule->children.begin(), rule->children.end());
+    }
+}
+
+static size_t countNodes(SysYParser::ExpContext* root) {
+    size_t n = 0;
+    std::vector<ParseTree*> work{root};
+    while (!work.empty()) {
+        ParseTree* node = work.back();
+        work.pop_back();
+        auto* rule = dynamic_cast<antlr4::ParserRuleContext*>(node);
+        if (!rule) continue;
+        n += rule->getRuleIndex() == SysYParser::RuleExp;
+        work.insert(work.end(), rule->children.begin(), rule->children.end());
+    }
+    return n;
+}
+
+int main(int argc, const char* argv[]) {
+    int functions = argc > 1 ? std::atoi(argv[1]) : 400;
+    int depth = argc > 2 ? std::atoi(argv[2]) : 9;
+
+    std::mt19937 rng(7);
+    std::string source;
+    for (int f = 0; f < functions; ++f) {
+        source += "int f" + std::to_string(f) + "() {\n    int a = 1;\n";
+        for (int s = 0; s < 4; ++s) source += "    a = " + randomExp(rng, depth) + ";\n";
+        source += "    return " + randomExp(rng, depth) + ";\n}\n";
+    }
+
+    Scanner scanner(source.data(), source.size());
+    ScannerTokenSource tokenSource(scanner);
+    Interner interner;
+    SlabTokenStream tokens(tokenSource, interner);
+    DescentParser parser(&tokens);
+    SysYParser::CompUnitContext* tree = parser.compUnit();
+    if (!tree) {
+        std::cerr << "syntax error in the generated program\n";
+        return 1;
+    }
+    std::vector<SysYParser::ExpContext*> roots;
+    collectRoots(tree, roots);
+    size_t nodes = 0;
+    for (SysYParser::ExpContext* root : roots) nodes += countNodes(root);
+
+    AnyEvaluator anyEvaluator;
+    double anyMillis = 1e30, switchMillis = 1e30;
+    long anySum = 0, switchSum = 0;
+    for (int run = 0; run < 9; ++run) {
+        Clock::time_point start = Clock::now();
+        anySum = 0;
+        for (SysYParser::ExpContext* root : roots) anySum += std::any_cast<int>(anyEvaluator.visit(root));
+        anyMillis = std::min(anyMillis, millisSince(start));
+
+        start = Clock::now();
+        switchSum = 0;
+        for (SysYParser::ExpContext* root : roots) switchSum += switchEvaluate(root);
+        switchMillis = std::min(switchMillis, millisSince(start));
+    }
+    if (anySum != switchSum) {
+        std::cerr << "evaluators disagree: " << anySum << " vs " << switchSum << "\n";
+        return 1;
+    }
+    std::cout << nodes << " exp nodes in " << roots.size() << " expressions\n"
+              << "  std::any visitor   " << anyMillis << " ms (" << 1e6 * anyMillis / nodes << " ns/node)\n"
+              << "  positional switch  " << switchMillis << " ms (" << 1e6 * switchMillis / nodes << " ns/node)\n";
+    return 0;
+}
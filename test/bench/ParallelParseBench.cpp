@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "DescentParser.h"
+#include "Interner.h"
+#include "ParallelParser.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SourceFile.h"
+#include "SysYSource.h"
+
+// Parse phase of --parse-jobs=1..N: ParallelParser over one fully scanned
+// SlabTokenStream, as the compiler runs it, timed by wall clock (best of 5),
+// next to the sequential DescentParser::compUnit(). Lexing is not timed.
+// Speedups are measured, relative to --parse-jobs=1, and are only
+// meaningful with at least N cores free; the core count is printed first.
+//
+//   ParallelParseBench [N] [KB]        synthetic program (defaults: 8 and 10240)
+//   ParallelParseBench N -f FILE       the given .sy file
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, const char* argv[]) {
+    unsigned maxJobs = argc > 1 ? static_cast<unsigned>(std::max(1, std::atoi(argv[1]))) : 8;
+    std::string source;
+    if (argc > 3 && std::string(argv[2]) == "-f") {
+        SourceFile file(argv[3]);
+        if (!file.isOpen()) {
+            std::cerr << "cannot open " << argv[3] << "\n";
+            return 1;
+        }
+        source = file.text();
+    } else {
+        source = syntheticProgram((argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10240) * 1024);
+    }
+
+    Scanner scanner(source.data(), source.size());
+    ScannerTokenSource tokenSource(scanner);
+    Interner interner;
+    SlabTokenStream tokens(tokenSource, interner);
+    std::cout << source.size() / 1024 << " KB, " << tokens.size() << " tokens, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+
+    double sequential = 1e30;
+    size_t items = 0;
+    for (int i = 0; i < 5; ++i) {
+        tokens.seek(0);
+        Clock::time_point start = Clock::now();
+        DescentParser parser(&tokens);
+        SysYParser::CompUnitContext* tree = parser.compUnit();
+        sequential = std::min(sequential, millisSince(start));
+        if (!tree) {
+            std::cerr << "syntax error\n";
+            return 1;
+        }
+        items = tree->children.size();
+    }
+    std::cout << "  sequential  " << sequential << " ms\n";
+
+    double oneJob = 0;
+    for (unsigned jobs = 1; jobs <= maxJobs; ++jobs) {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            tokens.seek(0);
+            Clock::time_point start = Clock::now();
+            ParallelParser parser(tokens, jobs);
+            SysYParser::CompUnitContext* tree = parser.compUnit();
+            best = std::min(best, millisSince(start));
+            if (!tree || tree->children.size() != items) {
+                std::cerr << "jobs=" << jobs << ": tree differs from the sequential parse\n";
+                return 1;
+            }
+        }
+        if (jobs == 1) {
+            oneJob = best;
+        }
+        std::cout << "  jobs=" << jobs << "  " << best << " ms  (x" << oneJob / best << ")\n";
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "SysYParser.h"
+#include "DescentParser.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SourceFile.h"
+#include "SysYSource.h"
+
+// Parse time per KB of source for the recursive-descent parser and for
+// SysYParser in SLL mode (what the compiler runs first), on the same
+// SlabTokenStream. Lexing is not timed. SysYParser is also timed once with
+// its prediction DFA cleared first ("antlr cold"), as in a fresh process
+// without --dfa-cache; the other rows are the best of 5 runs.
+//
+//   ParseBench [KB...]       synthetic programs (default: 4 64 1024 8192)
+//   ParseBench -f FILE...    the given .sy files
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double parseDescent(SlabTokenStream& tokens) {
+    tokens.seek(0);
+    Clock::time_point start = Clock::now();
+    DescentParser parser(&tokens);
+    if (!parser.compUnit()) {
+        std::cerr << "descent parser: syntax error\n";
+        std::exit(1);
+    }
+    return millisSince(start);
+}
+
+static double parseAntlr(SlabTokenStream& tokens, bool cold = false) {
+    tokens.seek(0);
+    Clock::time_point start = Clock::now();
+    SysYParser parser(&tokens);
+    auto* interpreter = parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+    if (cold) {
+        interpreter->clearDFA();
+        start = Clock::now();
+    }
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+    parser.removeErrorListeners();
+    parser.compUnit();
+    return millisSince(start);
+}
+
+static void run(const std::string& name, const std::string& source) {
+    Scanner scanner(source.data(), source.size(), name);
+    ScannerTokenSource tokenSource(scanner);
+    Interner interner;
+    SlabTokenStream tokens(tokenSource, interner);
+
+    double cold = parseAntlr(tokens, /*cold=*/true);
+    double descent = 1e30, antlr = 1e30;
+    for (int i = 0; i < 5; ++i) {
+        descent = std::min(descent, parseDescent(tokens));
+        antlr = std::min(antlr, parseAntlr(tokens));
+    }
+    double kb = source.size() / 1024.0;
+    std::cout << name << ": " << kb << " KB, " << tokens.size() << " tokens\n"
+              << "  descent      " << descent << " ms  (" << 1000 * descent / kb << " us/KB)\n"
+              << "  antlr        " << antlr << " ms  (" << 1000 * antlr / kb << " us/KB)\n"
+              << "  antlr cold   " << cold << " ms  (" << 1000 * cold / kb << " us/KB)\n";
+}
+
+int main(int argc, const char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "-f") {
+        for (size_t i = 1; i < args.size(); ++i) {
+            SourceFile file(args[i]);
+            if (!file.isOpen()) {
+                std::cerr << "cannot open " << args[i] << "\n";
+                return 1;
+            }
+            run(args[i], std::string(file.text()));
+        }
+        return 0;
+    }
+    if (args.empty()) {
+        args = {"4", "64", "1024", "8192"};
+    }
+    for (const std::string& kb : args) {
+        run("synthetic", syntheticProgram(std::strtoull(kb.c_str(), nullptr, 10) * 1024));
+    }
+    return 0;
+}
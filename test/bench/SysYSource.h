@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+
+// Synthetic SysY input for the front-end benchmarks: one global and one
+// function per item, with declarations, array initializers, nested control
+// flow, calls and mixed-precedence expressions, appended until the program
+// is at least `bytes` long. It exercises the lexer and parser; it uses more
+// of SysY (parameters, arrays, globals) than IRGenerator lowers.
+inline std::string syntheticProgram(size_t bytes) {
+    std::string source;
+    for (size_t i = 0; source.size() < bytes; ++i) {
+        std::string n = std::to_string(i);
+        source += "const int K" + n + " = " + n + " % 7 + 1;\n"
+                  "int g" + n + "[4][2] = {{1, 2}, {K" + n + "}, {}, {3, 4}};\n"
+                  "int f" + n + "(int a, int b[]) {\n"
+                  "    int x = a * 3 + b[0] - (a / 2) % K" + n + ";\n"
+                  "    int y[3] = {x, a + 1, -x};\n"
+                  "    while (x < 100 && !(x == a || x >= 50)) {\n"
+                  "        if (x % 2 == 0) {\n"
+                  "            x = x + y[x % 3] * 2 + g" + n + "[x % 4][1];\n"
+                  "        } else if (x > 10) {\n"
+                  "            x = x - -(a + 1);\n"
+                  "            continue;\n"
+                  "        } else {\n"
+                  "            x = x + 1;\n"
+                  "        }\n"
+                  "        y[1] = y[1] + x;\n"
+                  "    }\n";
+        if (i > 0) {
+            source += "    x = x + f" + std::to_string(i - 1) + "(x, y);\n";
+        }
+        source += "    return x * (y[1] - y[2]) + K" + n + ";\n"
+                  "}\n";
+    }
+    source += "int main() {\n"
+              "    int b[1] = {1};\n"
+              "    return f0(3, b) % 256;\n"
+              "}\n";
+    return source;
+}
+
+// Synthetic SysY input that IRGenerator lowers in full: `functions`
+// functions of straight-line declarations, about `instructions`
+// instructions in all. Each `int vJ = vI + a * 3 - b;` lowers to eight:
+// alloca, three loads, mul, add, sub and store.
+inline std::string syntheticModuleProgram(size_t instructions, size_t functions) {
+    size_t perFunction = instructions / functions / 8;
+    std::string source;
+    for (size_t f = 0; f < functions; ++f) {
+        source += "int f" + std::to_string(f) + "() {\n    int a = 1;\n    int b = 2;\n    int v0 = a;\n";
+        for (size_t j = 1; j < perFunction; ++j) {
+            source += "    int v" + std::to_string(j) + " = v" + std::to_string(j - 1) + " + a * 3 - b;\n";
+        }
+        source += "    return v" + std::to_string(perFunction - 1) + ";\n}\n";
+    }
+    return source;
+}
@@ -0,0 +1,98 @@
+#include <malloc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "antlr4-runtime.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include "ScannerTokenSource.h"
+#include "SlabTokenStream.h"
+#include "SourceFile.h"
+#include "SysYSource.h"
+
+// Token memory and lexing time of the two streams the compiler can put
+// under the parser, both over the Scanner: a CommonTokenStream filled from
+// ScannerTokenSource, and a SlabTokenStream (its constructor scans the whole
+// input). Memory is the heap in use (mallinfo2) while the filled stream is
+// alive, less what was in use before; time is the best of 5 runs.
+//
+//   TokenStreamBench [KB...]       synthetic programs (default: 64 1024 10240)
+//   TokenStreamBench -f FILE...    the given .sy files
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static size_t heapInUse() { return mallinfo2().uordblks; }
+
+struct Result {
+    double millis = 1e30;
+    size_t bytes = 0;
+    size_t tokens = 0;
+};
+
+// `make` builds and fills a stream over the scanner and returns it.
+template <typename Make>
+static Result measure(const std::string& source, Make make) {
+    Result result;
+    for (int i = 0; i < 5; ++i) {
+        Scanner scanner(source.data(), source.size());
+        ScannerTokenSource tokenSource(scanner);
+        Interner interner;
+        size_t before = heapInUse();
+        Clock::time_point start = Clock::now();
+        auto stream = make(tokenSource, interner);
+        result.millis = std::min(result.millis, millisSince(start));
+        result.bytes = heapInUse() - before;
+        result.tokens = stream->size();
+    }
+    return result;
+}
+
+static void run(const std::string& name, const std::string& source) {
+    Result common = measure(source, [](ScannerTokenSource& tokenSource, Interner&) {
+        auto stream = std::make_unique<antlr4::CommonTokenStream>(&tokenSource);
+        stream->fill();
+        return stream;
+    });
+    Result slab = measure(source, [](ScannerTokenSource& tokenSource, Interner& interner) {
+        return std::make_unique<SlabTokenStream>(tokenSource, interner);
+    });
+    auto line = [](const char* label, const Result& r) {
+        std::cout << "  " << label << r.millis << " ms, " << r.bytes / 1024 << " KB ("
+                  << double(r.bytes) / r.tokens << " B/token)\n";
+    };
+    std::cout << name << ": " << source.size() / 1024 << " KB, " << slab.tokens << " tokens\n";
+    line("CommonTokenStream  ", common);
+    line("SlabTokenStream    ", slab);
+}
+
+int main(int argc, const char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "-f") {
+        for (size_t i = 1; i < args.size(); ++i) {
+            SourceFile file(args[i]);
+            if (!file.isOpen()) {
+                std::cerr << "cannot open " << args[i] << "\n";
+                return 1;
+            }
+            run(args[i], std::string(file.text()));
+        }
+        return 0;
+    }
+    if (args.empty()) {
+        args = {"64", "1024", "10240"};
+    }
+    for (const std::string& kb : args) {
+        run("synthetic", syntheticProgram(std::strtoull(kb.c_str(), nullptr, 10) * 1024));
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+"""Time .ll against .bc output, from the compiler through LLVM's tools.
+
+For each input, compiles it with --emit=ll and --emit=bc and reports, per
+format, the output size and the best wall time of:
+    compile   ./compiler [--emit=bc] x.sy out
+    opt       opt -disable-output out          (parse + verify)
+    llc       llc -O0 -filetype=obj out
+The LLVM tools are looked up as opt/llc or opt-14/llc-14; a missing one is
+left out. Without input files, a synthetic module of about 10^6
+instructions in 100 functions is used (the shape of syntheticModuleProgram
+in test/bench/SysYSource.h).
+
+    python3 test/bench/ll_vs_bc.py build/compiler [--runs=N] [x.sy ...]
+"""
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+
+def find_tool(name):
+    for candidate in (name, f"{name}-14"):
+        path = shutil.which(candidate)
+        if path:
+            return path
+    return None
+
+
+def synthetic_module(instructions=1000000, functions=100):
+    per_function = instructions // functions // 8
+    parts = []
+    for f in range(functions):
+        parts.append(f"int f{f}() {{\n    int a = 1;\n    int b = 2;\n    int v0 = a;\n")
+        for j in range(1, per_function):
+            parts.append(f"    int v{j} = v{j - 1} + a * 3 - b;\n")
+        parts.append(f"    return v{per_function - 1};\n}}\n")
+    return "".join(parts)
+
+
+def best_time(command, runs):
+    best = float("inf")
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        best = min(best, time.perf_counter() - start)
+        if result.returncode != 0:
+            return None
+    return best * 1000
+
+
+def main():
+    args = [arg for arg in sys.argv[1:] if not arg.startswith("--runs=")]
+    runs = next((int(arg[len("--runs="):]) for arg in sys.argv[1:] if arg.startswith("--runs=")), 3)
+    if not args:
+        print(f"usage: {sys.argv[0]} <compiler> [--runs=N] [x.sy ...]")
+        return 1
+    compiler, inputs = args[0], [Path(arg) for arg in args[1:]]
+    tools = {name: find_tool(name) for name in ("opt", "llc")}
+
+    with tempfile.TemporaryDirectory() as tmp:
+        if not inputs:
+            synthetic = Path(tmp) / "m1e6.sy"
+            synthetic.write_text(synthetic_module())
+            inputs = [synthetic]
+        for sysy_file in inputs:
+            print(f"{sysy_file.name}:")
+            for emit in ("ll", "bc"):
+                output = Path(tmp) / f"out.{emit}"
+                timings = {"compile": best_time([compiler, f"--emit={emit}", str(sysy_file), str(output)], runs)}
+                if tools["opt"]:
+                    timings["opt"] = best_time([tools["opt"], "-disable-output", str(output)], runs)
+                if tools["llc"]:
+                    timings["llc"] = best_time([tools["llc"], "-O0", "-filetype=obj", str(output),
+                                                "-o", str(Path(tmp) / "out.o")], runs)
+                cells = ", ".join(f"{name} " + ("failed" if ms is None else f"{ms:.0f} ms")
+                                  for name, ms in timings.items())
+                print(f"  {emit}  {output.stat().st_size / 1e6:.2f} MB  {cells}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
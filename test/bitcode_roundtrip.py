@@ -0,0 +1,85 @@
+"""Check the bitcode writer against LLVM's own.
+
+For every .sy file given (or found in a directory given), compiles it to
+.ll and, with --emit=bc, to .bc. Where llvm-as accepts the .ll, the
+llvm-dis text of our .bc must equal that of `llvm-as x.ll`, apart from the
+ModuleID line, which names the file. Inputs llvm-as rejects are counted
+and skipped. Exits with 77, which ctest reports as skipped, when llvm-as
+or llvm-dis is not installed.
+
+    python3 test/bitcode_roundtrip.py build/compiler test/resources/functional
+"""
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+SKIP = 77
+
+
+def find_tool(name):
+    for candidate in (name, f"{name}-14"):
+        path = shutil.which(candidate)
+        if path:
+            return path
+    return None
+
+
+def collect_inputs(paths):
+    inputs = []
+    for path in map(Path, paths):
+        if path.is_dir():
+            inputs.extend(sorted(path.glob("*.sy")))
+        else:
+            inputs.append(path)
+    return inputs
+
+
+def disassemble(llvm_dis, bitcode_file):
+    result = subprocess.run([llvm_dis, "-o", "-", str(bitcode_file)], capture_output=True, text=True)
+    if result.returncode != 0:
+        return None
+    lines = result.stdout.splitlines()
+    return [line for line in lines if not line.startswith("; ModuleID = ")]
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(f"usage: {sys.argv[0]} <compiler> <.sy file or directory>...")
+        return 1
+    compiler = sys.argv[1]
+    llvm_as = find_tool("llvm-as")
+    llvm_dis = find_tool("llvm-dis")
+    if not llvm_as or not llvm_dis:
+        print("llvm-as or llvm-dis not found; skipping")
+        return SKIP
+
+    inputs = collect_inputs(sys.argv[2:])
+    compared, rejected, failed = 0, 0, []
+    with tempfile.TemporaryDirectory() as tmp:
+        llvmir_file = Path(tmp) / "x.ll"
+        ours = Path(tmp) / "ours.bc"
+        theirs = Path(tmp) / "theirs.bc"
+        for sysy_file in inputs:
+            for options, output in (([], llvmir_file), (["--emit=bc"], ours)):
+                subprocess.run([compiler, *options, str(sysy_file), str(output)],
+                               stderr=subprocess.DEVNULL, timeout=60)
+            assembled = subprocess.run([llvm_as, str(llvmir_file), "-o", str(theirs)],
+                                       stderr=subprocess.DEVNULL)
+            if assembled.returncode != 0:
+                rejected += 1
+                continue
+            compared += 1
+            expected = disassemble(llvm_dis, theirs)
+            actual = disassemble(llvm_dis, ours)
+            if actual is None or actual != expected:
+                failed.append(sysy_file)
+                print(f"[ERROR] {sysy_file}: " + ("llvm-dis rejects our .bc" if actual is None else "disassembly differs"))
+
+    print(f"{compared - len(failed)} of {compared} inputs match; {rejected} rejected by llvm-as")
+    return 1 if failed or compared == 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,73 @@
+"""Check that two compiler modes agree on every input.
+
+Runs the compiler once with each option set on every .sy file given (or
+found in a directory given) and fails if the output files, the stderr
+diagnostics or the exit codes differ. ctest uses it to hold the
+hand-written front end to the ANTLR one, for example:
+
+    python3 test/compare_modes.py build/compiler \\
+        --a=--dump-tokens --b="--dump-tokens --lexer=antlr" test/resources/functional
+"""
+import argparse
+import shlex
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+
+def collect_inputs(paths):
+    inputs = []
+    for path in map(Path, paths):
+        if path.is_dir():
+            inputs.extend(sorted(path.glob("*.sy")))
+        else:
+            inputs.append(path)
+    return inputs
+
+
+def run(compiler, options, sysy_file, output_file):
+    result = subprocess.run(
+        [compiler, *options, str(sysy_file), str(output_file)],
+        stderr=subprocess.PIPE,
+        timeout=60,
+    )
+    output = output_file.read_bytes() if output_file.exists() else b""
+    return output, result.stderr, result.returncode
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("compiler")
+    parser.add_argument("--a", required=True, help="options of the first mode")
+    parser.add_argument("--b", required=True, help="options of the second mode")
+    parser.add_argument("inputs", nargs="+", help=".sy files or directories of them")
+    args = parser.parse_args()
+
+    options_a = shlex.split(args.a)
+    options_b = shlex.split(args.b)
+    inputs = collect_inputs(args.inputs)
+    if not inputs:
+        print("no .sy inputs found")
+        return 1
+
+    failed = []
+    with tempfile.TemporaryDirectory() as tmp:
+        out_a = Path(tmp) / "a.out"
+        out_b = Path(tmp) / "b.out"
+        for sysy_file in inputs:
+            out_a.unlink(missing_ok=True)
+            out_b.unlink(missing_ok=True)
+            result_a = run(args.compiler, options_a, sysy_file, out_a)
+            result_b = run(args.compiler, options_b, sysy_file, out_b)
+            differs = [name for name, x, y in zip(("output", "stderr", "exit code"), result_a, result_b) if x != y]
+            if differs:
+                failed.append(sysy_file)
+                print(f"[ERROR] {sysy_file}: {', '.join(differs)} differ")
+
+    print(f"{len(inputs) - len(failed)} of {len(inputs)} inputs agree: [{args.a}] vs [{args.b}]")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
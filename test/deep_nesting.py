@@ -0,0 +1,69 @@
+"""Check that deeply nested expressions compile without overflowing the stack.
+
+Writes three programs with one deeply nested `return` expression, compiles
+each with the default front end (whole-module and --stream) under an 8 MB
+stack limit, and checks the IR it writes:
+
+    ((( ... 1 ... )))     depth 1e6    folds to `ret i32 1`
+    - - ... - a           2e5 minuses  one `sub i32 0, ...` per minus
+    a + a + ... + a       2e5 terms    one `add` per `+`
+
+    python3 test/deep_nesting.py build/compiler
+"""
+import resource
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+STACK_LIMIT = 8 << 20
+
+CASES = [
+    ("parens", "(" * 1000000 + "1" + ")" * 1000000,
+     lambda ir: "ret i32 1\n" in ir),
+    ("unary", "- " * 200000 + "a",
+     lambda ir: ir.count(" = sub i32 0, ") == 200000),
+    ("chain", " + ".join(["a"] * 200000),
+     lambda ir: ir.count(" = add i32 ") == 199999),
+]
+
+
+def limit_stack():
+    soft, hard = resource.getrlimit(resource.RLIMIT_STACK)
+    if hard == resource.RLIM_INFINITY or hard > STACK_LIMIT:
+        resource.setrlimit(resource.RLIMIT_STACK, (STACK_LIMIT, hard))
+
+
+def main():
+    if len(sys.argv) != 2:
+        print(f"usage: {sys.argv[0]} <compiler>")
+        return 1
+    compiler = sys.argv[1]
+
+    failed = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        for name, exp, check in CASES:
+            sysy_file = Path(tmp) / f"{name}.sy"
+            sysy_file.write_text(f"int main() {{\n    int a = 1;\n    return {exp};\n}}\n")
+            for options in ([], ["--stream"]):
+                llvmir_file = Path(tmp) / f"{name}.ll"
+                result = subprocess.run(
+                    [compiler, *options, str(sysy_file), str(llvmir_file)],
+                    stderr=subprocess.PIPE,
+                    preexec_fn=limit_stack,
+                    timeout=120,
+                )
+                label = " ".join([name, *options])
+                if result.returncode != 0 or result.stderr:
+                    print(f"[ERROR] {label}: exit code {result.returncode}, stderr {result.stderr[:200]!r}")
+                    failed += 1
+                elif not check(llvmir_file.read_text()):
+                    print(f"[ERROR] {label}: unexpected IR")
+                    failed += 1
+                else:
+                    print(f"[INFO] {label}: ok")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,93 @@
+#include <string>
+
+#include "ChangeJournal.h"
+#include "Check.h"
+#include "IR.h"
+#include "IRBuilder.h"
+#include "IRPrinter.h"
+
+// A function f of `adds` additions of constants, each result feeding the
+// next, and a ret of the last one.
+static Function* makeFunction(Module& module, int adds) {
+    IRContext& context = module.getContext();
+    Function* func = module.addFunction(context.getFunctionTy(Type::getInt32Ty(), {}), "f");
+    IRBuilder builder;
+    builder.setInsertPoint(func->getEntryBlock());
+    Value* last = context.getInt32(1);
+    for (int i = 0; i < adds; ++i) {
+        last = builder.CreateBinary(Instruction::Add, last, context.getInt32(i + 2));
+    }
+    builder.CreateRet(last);
+    return func;
+}
+
+static Instruction* instAt(Function* func, int index) {
+    auto it = func->getEntryBlock()->instList.begin();
+    std::advance(it, index);
+    return &*it;
+}
+
+// Operands edited while the instruction is out of its block reach no
+// journal; rolling back must still restore them.
+static void testEditWhileRemoved() {
+    Module module;
+    Function* func = makeFunction(module, 2);
+    std::string before = IRPrinter::toString(module);
+    ChangeJournal journal(*func);
+    journal.checkpoint();
+    Instruction* inst = instAt(func, 0);
+    BasicBlock* block = inst->getParent();
+    Instruction* next = instAt(func, 1);
+    inst->removeFromParent();
+    inst->setOperand(0, module.getContext().getInt32(40));
+    block->instList.insert(BasicBlock::InstListType::iteratorTo(next), inst);
+    CHECK(IRPrinter::toString(module).find("add i32 40, 2") != std::string::npos);
+    journal.rollback();
+    CHECK(IRPrinter::toString(module) == before);
+}
+
+static void testEraseAndMove() {
+    Module module;
+    Function* func = makeFunction(module, 4);
+    std::string before = IRPrinter::toString(module);
+    ChangeJournal journal(*func);
+    journal.checkpoint();
+    instAt(func, 3)->replaceAllUsesWith(instAt(func, 2));
+    instAt(func, 3)->eraseFromParent();
+    instAt(func, 0)->moveBefore(instAt(func, 2));
+    instAt(func, 1)->moveBefore(instAt(func, 1));
+    journal.rollback();
+    CHECK(IRPrinter::toString(module) == before);
+}
+
+// An inner commit keeps its changes only until the outer rollback.
+static void testNested() {
+    Module module;
+    Function* func = makeFunction(module, 3);
+    std::string before = IRPrinter::toString(module);
+    ChangeJournal journal(*func);
+    journal.checkpoint();
+    instAt(func, 1)->setOperand(1, module.getContext().getInt32(7));
+    std::string middle = IRPrinter::toString(module);
+    journal.checkpoint();
+    Instruction* inst = instAt(func, 0)->removeFromParent();
+    inst->setOperand(1, module.getContext().getInt32(9));
+    func->getEntryBlock()->instList.push_front(inst);
+    journal.rollback();
+    CHECK(IRPrinter::toString(module) == middle);
+    journal.checkpoint();
+    inst = instAt(func, 2)->removeFromParent();
+    inst->setOperand(1, module.getContext().getInt32(11));
+    func->getEntryBlock()->instList.push_front(inst);
+    journal.commit();
+    CHECK(IRPrinter::toString(module) != middle);
+    journal.rollback();
+    CHECK(IRPrinter::toString(module) == before);
+}
+
+int main() {
+    testEditWhileRemoved();
+    testEraseAndMove();
+    testNested();
+    return 0;
+}
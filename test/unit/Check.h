@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Each unit test under test/unit is its own executable, run by ctest. CHECK
+// stops it with a nonzero exit at the first check that fails; unlike
+// assert, it stays on in Release builds.
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; \
+            std::exit(1);                                                            \
+        }                                                                            \
+    } while (0)
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "DominatorTree.h"
+
+using Edges = std::vector<std::pair<uint32_t, uint32_t>>;
+
+// dominates[a][b] by definition: b is unreachable, or a is reachable and
+// b cannot be reached once a is taken out. For the post-dominator tree the
+// same is asked of the reversed CFG, from a virtual exit (node n).
+static std::vector<std::vector<bool>> bruteForceDominance(uint32_t n, const Edges& edges, bool post) {
+    uint32_t numNodes = n + (post ? 1 : 0);
+    uint32_t root = post ? n : 0;
+    std::vector<std::vector<uint32_t>> succ(numNodes);
+    std::vector<uint32_t> outDegree(n, 0);
+    for (auto [from, to] : edges) {
+        ++outDegree[from];
+        post ? succ[to].push_back(from) : succ[from].push_back(to);
+    }
+    for (uint32_t b = 0; post && b < n; ++b) {
+        if (outDegree[b] == 0) {
+            succ[root].push_back(b);
+        }
+    }
+    auto reachableWithout = [&](uint32_t removed) {
+        std::vector<bool> reached(numNodes);
+        if (root == removed) {
+            return reached;
+        }
+        std::vector<uint32_t> stack{root};
+        reached[root] = true;
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            for (uint32_t w : succ[v]) {
+                if (!reached[w] && w != removed) {
+                    reached[w] = true;
+                    stack.push_back(w);
+                }
+            }
+        }
+        return reached;
+    };
+    std::vector<bool> reachable = reachableWithout(DominatorTree::NONE);
+    std::vector<std::vector<bool>> dominates(numNodes, std::vector<bool>(numNodes));
+    for (uint32_t a = 0; a < numNodes; ++a) {
+        std::vector<bool> reached = reachableWithout(a);
+        for (uint32_t b = 0; b < numNodes; ++b) {
+            dominates[a][b] = !reachable[b] || (reachable[a] && !reached[b]);
+        }
+    }
+    return dominates;
+}
+
+// Checks the tree after an update against a full recompute, dominates()
+// against the definition, and each frontier against its definition: y is
+// in DF(x) iff x dominates a predecessor of y but does not strictly
+// dominate y.
+static void checkTree(const DominatorTree& tree, uint32_t n, const Edges& edges, bool post) {
+    CHECK(tree.verify());
+    std::vector<std::vector<bool>> dominates = bruteForceDominance(n, edges, post);
+    for (uint32_t a = 0; a < n; ++a) {
+        for (uint32_t b = 0; b < n; ++b) {
+            CHECK(tree.dominates(a, b) == dominates[a][b]);
+        }
+    }
+    std::vector<std::vector<uint32_t>> frontiers = tree.dominanceFrontiers();
+    for (uint32_t x = 0; x < n; ++x) {
+        if (!tree.isReachable(x)) {
+            continue;
+        }
+        std::set<uint32_t> expected;
+        for (auto [from, to] : edges) {
+            uint32_t pred = post ? to : from;
+            uint32_t y = post ? from : to;
+            if (tree.isReachable(pred) && tree.isReachable(y) && tree.dominates(x, pred) &&
+                !(x != y && tree.dominates(x, y))) {
+                expected.insert(y);
+            }
+        }
+        std::set<uint32_t> found(frontiers[x].begin(), frontiers[x].end());
+        CHECK(found.size() == frontiers[x].size()); // no duplicates
+        CHECK(found == expected);
+    }
+}
+
+// Random graphs of up to 12 blocks, so that unreachable blocks, self loops,
+// repeated edges and blocks without successors all come up, each put
+// through random edge insertions and deletions.
+static void testRandomUpdates(bool post) {
+    std::mt19937 rng(post ? 2 : 1);
+    for (int graph = 0; graph < 1500; ++graph) {
+        uint32_t n = 1 + rng() % 12;
+        Edges edges;
+        for (uint32_t m = rng() % (n * 3 + 1); m > 0; --m) {
+            edges.push_back({rng() % n, rng() % n});
+        }
+        DominatorTree tree(n, edges, post);
+        CHECK(tree.isPostDominatorTree() == post);
+        checkTree(tree, n, edges, post);
+        for (int update = 0; update < 40; ++update) {
+            if (!edges.empty() && rng() % 2) {
+                size_t k = rng() % edges.size();
+                tree.deleteEdge(edges[k].first, edges[k].second);
+                edges.erase(edges.begin() + static_cast<std::ptrdiff_t>(k));
+            } else {
+                std::pair<uint32_t, uint32_t> edge{rng() % n, rng() % n};
+                edges.push_back(edge);
+                tree.insertEdge(edge.first, edge.second);
+            }
+            checkTree(tree, n, edges, post);
+        }
+    }
+}
+
+// entry -> 1 -> 3 and entry -> 2 -> 3, 3 -> exit 4, with a loop 3 -> 1.
+static void testDiamond() {
+    Edges edges{{0, 1}, {0, 2}, {1, 3}, {2, 3}, {3, 4}, {3, 1}};
+    DominatorTree dominators(5, edges);
+    CHECK(dominators.idom(0) == DominatorTree::NONE);
+    CHECK(dominators.idom(3) == 0 && dominators.idom(4) == 3);
+    CHECK(dominators.nearestCommonDominator(1, 2) == 0);
+    std::vector<std::vector<uint32_t>> frontiers = dominators.dominanceFrontiers();
+    CHECK((frontiers[1] == std::vector<uint32_t>{3} || frontiers[1] == std::vector<uint32_t>{1, 3} ||
+           frontiers[1] == std::vector<uint32_t>{3, 1}));
+    DominatorTree postDominators(5, edges, true);
+    CHECK(postDominators.idom(0) == 3 && postDominators.idom(3) == 4);
+    CHECK(postDominators.idom(4) == DominatorTree::NONE);
+    // 2 -> 3 goes; 2 now has no successor, so only the virtual exit
+    // post-dominates it, and 3 no longer post-dominates the entry.
+    postDominators.deleteEdge(2, 3);
+    CHECK(postDominators.verify());
+    CHECK(postDominators.idom(2) == DominatorTree::NONE && postDominators.idom(0) == DominatorTree::NONE);
+}
+
+int main() {
+    testDiamond();
+    testRandomUpdates(false);
+    testRandomUpdates(true);
+    return 0;
+}
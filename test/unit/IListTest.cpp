@@ -0,0 +1,133 @@
+#include <vector>
+
+#include "Check.h"
+#include "IList.h"
+#include "IR.h"
+#include "IRBuilder.h"
+
+struct Owner;
+
+struct Item : IListNode<Item, Owner> {
+    explicit Item(int value) : value(value) {}
+    int value;
+};
+
+struct Owner {
+    IList<Item, Owner> list{this};
+};
+
+static std::vector<int> valuesOf(const IList<Item, Owner>& list) {
+    std::vector<int> values;
+    for (const Item& item : list) {
+        values.push_back(item.value);
+    }
+    // Walking back must give the same nodes.
+    size_t i = values.size();
+    for (auto it = list.end(); it != list.begin();) {
+        --it;
+        CHECK(i > 0 && it->value == values[--i]);
+    }
+    CHECK(values.size() == list.size());
+    return values;
+}
+
+static void fill(Owner& owner, int count) {
+    for (int i = 0; i < count; ++i) {
+        owner.list.push_back(new Item(i));
+    }
+}
+
+static Item* at(Owner& owner, int index) {
+    auto it = owner.list.begin();
+    std::advance(it, index);
+    return &*it;
+}
+
+// Splicing a range in front of its own first node, or of the node after it,
+// leaves the list as it was.
+static void testSpliceInPlace() {
+    Owner owner;
+    fill(owner, 3);
+    auto& list = owner.list;
+    for (int i = 0; i < 3; ++i) {
+        auto it = list.iteratorTo(at(owner, i));
+        list.splice(it, list, it);
+        CHECK((valuesOf(list) == std::vector<int>{0, 1, 2}));
+        list.splice(std::next(it), list, it);
+        CHECK((valuesOf(list) == std::vector<int>{0, 1, 2}));
+    }
+    list.splice(list.begin(), list, list.begin(), list.end());
+    list.splice(list.end(), list, list.begin(), list.end());
+    CHECK((valuesOf(list) == std::vector<int>{0, 1, 2}));
+}
+
+static void testSpliceWithinList() {
+    Owner owner;
+    fill(owner, 5);
+    auto& list = owner.list;
+    list.splice(list.begin(), list, list.iteratorTo(at(owner, 3)), list.end());
+    CHECK((valuesOf(list) == std::vector<int>{3, 4, 0, 1, 2}));
+    list.splice(list.end(), list, list.begin());
+    CHECK((valuesOf(list) == std::vector<int>{4, 0, 1, 2, 3}));
+}
+
+static void testSpliceBetweenLists() {
+    Owner a, b;
+    fill(a, 4);
+    b.list.push_back(new Item(10));
+    b.list.splice(b.list.begin(), a.list, std::next(a.list.begin()), std::prev(a.list.end()));
+    CHECK((valuesOf(a.list) == std::vector<int>{0, 3}));
+    CHECK((valuesOf(b.list) == std::vector<int>{1, 2, 10}));
+    for (Item& item : b.list) {
+        CHECK(item.getParent() == &b);
+    }
+    CHECK(a.list.front().getParent() == &a);
+}
+
+static void testEraseAndRemove() {
+    Owner owner;
+    fill(owner, 4);
+    auto& list = owner.list;
+    auto next = list.erase(list.iteratorTo(at(owner, 1)));
+    CHECK(next->value == 2);
+    Item* removed = list.remove(next);
+    CHECK(removed->getParent() == nullptr);
+    CHECK((valuesOf(list) == std::vector<int>{0, 3}));
+    list.insert(list.begin(), removed);
+    CHECK((valuesOf(list) == std::vector<int>{2, 0, 3}));
+}
+
+// Instruction::moveBefore splices through the block's list, including onto
+// the instruction itself.
+static void testMoveBeforeSelf() {
+    Module module;
+    IRContext& context = module.getContext();
+    Function* func = module.addFunction(context.getFunctionTy(Type::getInt32Ty(), {}), "f");
+    BasicBlock* block = func->getEntryBlock();
+    IRBuilder builder;
+    builder.setInsertPoint(block);
+    std::vector<Instruction*> insts;
+    for (int i = 0; i < 3; ++i) {
+        insts.push_back(static_cast<Instruction*>(
+            builder.CreateBinary(Instruction::Add, context.getInt32(i), context.getInt32(1))));
+    }
+    for (Instruction* inst : insts) {
+        inst->moveBefore(inst);
+    }
+    insts[2]->moveBefore(insts[0]);
+    std::vector<Instruction*> order;
+    for (Instruction& inst : block->instList) {
+        CHECK(inst.getParent() == block);
+        order.push_back(&inst);
+    }
+    CHECK((order == std::vector<Instruction*>{insts[2], insts[0], insts[1]}));
+}
+
+int main() {
+    testSpliceInPlace();
+    testSpliceWithinList();
+    testSpliceBetweenLists();
+    testEraseAndRemove();
+    testMoveBeforeSelf();
+    return 0;
+}
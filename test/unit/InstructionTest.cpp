@@ -0,0 +1,32 @@
+#include <stdexcept>
+#include <vector>
+
+#include "Check.h"
+#include "IR.h"
+
+// Operand counts are stored in 16 bits; a longer list must be refused, not
+// truncated.
+static void testOperandLimit() {
+    Module module;
+    Arena& arena = module.getArena();
+    std::vector<Value*> operands(Instruction::MAX_OPERANDS, module.getContext().getInt32(7));
+    Instruction* largest = new (arena, operands.size())
+        Instruction(Instruction::Ret, Type::getVoidTy(), operands.data(), operands.size());
+    CHECK(largest->getNumOperands() == Instruction::MAX_OPERANDS);
+    CHECK(largest->getOperand(Instruction::MAX_OPERANDS - 1) == operands.back());
+    largest->~Instruction();
+
+    operands.push_back(operands.back());
+    bool threw = false;
+    try {
+        new (arena, operands.size()) Instruction(Instruction::Ret, Type::getVoidTy(), operands.data(), operands.size());
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+int main() {
+    testOperandLimit();
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Interner.h"
+
+// Every ID must still spell what was interned, and interning a spelling
+// again must give back its ID.
+static void checkAll(const Interner& interner, const std::vector<std::string>& names) {
+    CHECK(interner.size() == names.size());
+    for (size_t id = 0; id < names.size(); ++id) {
+        CHECK(interner.spelling(static_cast<uint32_t>(id)) == names[id]);
+    }
+}
+
+static void testLongBetweenShort() {
+    Interner interner;
+    std::vector<std::string> names;
+    auto add = [&](std::string name) {
+        CHECK(interner.intern(name) == names.size());
+        names.push_back(std::move(name));
+    };
+
+    add("a");
+    add(std::string(8 * 1024, 'L')); // longer than a quarter block
+    // Enough short names to fill several blocks after the long one.
+    for (int i = 0; i < 20000; ++i) {
+        add("name_" + std::to_string(i));
+    }
+    add(std::string(100 * 1024, 'M')); // longer than a whole block
+    add("after");
+    checkAll(interner, names);
+
+    for (size_t id = 0; id < names.size(); ++id) {
+        CHECK(interner.intern(names[id]) == id);
+    }
+    CHECK(interner.size() == names.size());
+}
+
+static void testEmptyAndBoundary() {
+    Interner interner;
+    std::vector<std::string> names = {"", std::string(4 * 1024, 'q'),
+                                      std::string(4 * 1024 + 1, 'r'), "x"};
+    for (size_t id = 0; id < names.size(); ++id) {
+        CHECK(interner.intern(names[id]) == id);
+    }
+    checkAll(interner, names);
+}
+
+int main() {
+    testLongBetweenShort();
+    testEmptyAndBoundary();
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 读回 IRPrinter 输出的 .ll
+#include "IRReader.h"
+// 可按名称运行的 pass
+#include "PassRegistry.h"
+// 撤销修改：变更日志回滚，或恢复事先复制的函数
+#include "ChangeJournal.h"
+#include "FunctionCloner.h"
+#include "IRPrinter.h"
+// 以 write(2) 整块写出的输出缓冲区
+#include "OutputStream.h"
+// 不依赖 LLVM 库直接写出 LLVM bitcode
+#include "BitcodeWriter.h"
+// 源文件只读映射
+#include "SourceFile.h"
+
+// sysy-opt：不经过前端，读入 compiler 生成的 .ll，按顺序运行指定的 pass 后写出，
+// 用于单独调试、测量各个 pass。
+
+static void printUsage() {
+  std::cerr << "Usage: ./sysy-opt [options] <input.ll> <output-file>\n"
+            << "Options:\n"
+            << "  --passes=P1,P2,...  run these passes in order (default: none)\n"
+            << "  --list-passes       list the available passes and exit\n"
+            << "  --time-passes       report the time spent reading, in each pass and writing on stderr\n"
+            << "  --repeat=N          read the input and run the passes N times; report the fastest time of each\n"
+            << "  --undo=journal      undo the passes afterwards by rolling back a ChangeJournal of each function\n"
+            << "  --undo=clone        undo the passes afterwards by restoring copies of the functions taken before\n"
+            << "  --emit=ll           write textual LLVM IR (default)\n"
+            << "  --emit=bc           write LLVM bitcode"
+            << std::endl;
+}
+
+static void listPasses() {
+  for (const PassInfo &pass : PassRegistry::passes()) {
+    std::cout << "  " << pass.name << " - " << pass.description << "\n";
+  }
+}
+
+// --undo：pass 运行前为每个函数做备份，运行后撤销全部修改，输出应与输入相同。
+// 用于比较两种撤销方式的代价。
+enum class UndoMode { None, Journal, Clone };
+
+class Backup {
+public:
+  Backup(UndoMode mode, Module &module) : mode(mode), module(module) {}
+
+  // 每个函数开一个检查点，或复制一份并移出模块（免得 pass 也处理副本）
+  void take() {
+    for (Function &func : module.funcList) {
+      if (mode == UndoMode::Journal) {
+        journals.push_back(std::make_unique<ChangeJournal>(func));
+        journals.back()->checkpoint();
+      } else {
+        originals.push_back(&func);
+      }
+    }
+    for (Function *func : originals) {
+      Function *copy = FunctionCloner::clone(*func, module.getName(func));
+      copies.push_back(module.funcList.remove(IList<Function, Module>::iteratorTo(copy)));
+    }
+  }
+
+  // 回滚日志，或用副本替换修改过的函数
+  void restore() {
+    for (auto &journal : journals) {
+      journal->rollback();
+    }
+    journals.clear();
+    for (size_t i = 0; i < originals.size(); ++i) {
+      module.funcList.insert(IList<Function, Module>::iteratorTo(originals[i]), copies[i]);
+      originals[i]->eraseFromParent();
+    }
+    originals.clear();
+    copies.clear();
+  }
+
+private:
+  UndoMode mode;
+  Module &module;
+  std::vector<std::unique_ptr<ChangeJournal>> journals;
+  std::vector<Function *> originals;
+  std::vector<Function *> copies;
+};
+
+int main(int argc, const char *argv[]) {
+  bool timePasses = false;
+  UndoMode undo = UndoMode::None;
+  bool emitBitcode = false;
+  int repeat = 1;
+  std::vector<const PassInfo *> pipeline;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--list-passes") {
+      listPasses();
+      return 0;
+    } else if (arg == "--time-passes") {
+      timePasses = true;
+    } else if (arg == "--emit=ll") {
+      emitBitcode = false;
+    } else if (arg == "--emit=bc") {
+      emitBitcode = true;
+    } else if (arg == "--undo=journal") {
+      undo = UndoMode::Journal;
+    } else if (arg == "--undo=clone") {
+      undo = UndoMode::Clone;
+    } else if (arg.rfind("--repeat=", 0) == 0) {
+      repeat = std::max(1, std::atoi(arg.c_str() + std::string("--repeat=").size()));
+    } else if (arg.rfind("--passes=", 0) == 0) {
+      // 逗号分隔的 pass 名，按给出的顺序运行
+      std::string list = arg.substr(std::string("--passes=").size());
+      for (size_t start = 0; start <= list.size();) {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string name = list.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) {
+          continue;
+        }
+        const PassInfo *pass = PassRegistry::find(name);
+        if (!pass) {
+          std::cerr << "Unknown pass " << name << "; available passes:" << std::endl;
+          listPasses();
+          return 1;
+        }
+        pipeline.push_back(pass);
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option " << arg << std::endl;
+      printUsage();
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() < 2) {
+    printUsage();
+    return 1;
+  }
+
+  std::string inputFile = positional[0];
+  std::string outputFile = positional[1];
+
+  SourceFile source(inputFile);
+  if (!source.isOpen()) {
+      std::cerr << "Could not open input file " << inputFile << std::endl;
+      return 1;
+  }
+
+  FileOutputStream os(outputFile);
+  if (!os.isOpen()) {
+      std::cerr << "Could not open output file " << outputFile << std::endl;
+      return 1;
+  }
+
+  // --repeat=N 时每一轮都重新读入并运行全部 pass，各阶段取最快的一次
+  using Clock = std::chrono::steady_clock;
+  auto elapsed = [](Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+  };
+  double readTime = std::numeric_limits<double>::infinity();
+  std::vector<double> passTimes(pipeline.size(), std::numeric_limits<double>::infinity());
+  std::vector<size_t> changes(pipeline.size());
+  double backupTime = std::numeric_limits<double>::infinity();
+  double restoreTime = std::numeric_limits<double>::infinity();
+  std::unique_ptr<Module> module;
+  for (int round = 0; round < repeat; ++round) {
+    module.reset();
+    auto start = Clock::now();
+    std::string error;
+    module = IRReader::parse(source.text(), error);
+    if (!module) {
+      std::cerr << inputFile << ":" << error << std::endl;
+      return 1;
+    }
+    readTime = std::min(readTime, elapsed(start));
+    Backup backup(undo, *module);
+    if (undo != UndoMode::None) {
+      start = Clock::now();
+      backup.take();
+      backupTime = std::min(backupTime, elapsed(start));
+    }
+    for (size_t i = 0; i < pipeline.size(); ++i) {
+      start = Clock::now();
+      changes[i] = pipeline[i]->run(*module);
+      passTimes[i] = std::min(passTimes[i], elapsed(start));
+    }
+    if (undo != UndoMode::None) {
+      start = Clock::now();
+      backup.restore();
+      restoreTime = std::min(restoreTime, elapsed(start));
+    }
+  }
+
+  auto start = Clock::now();
+  if (emitBitcode) {
+    BitcodeWriter::write(*module, os);
+  } else {
+    IRPrinter::print(*module, os);
+  }
+  if (!os.close()) {
+    std::cerr << "Could not write output file " << outputFile << std::endl;
+    return 1;
+  }
+  double writeTime = elapsed(start);
+
+  if (timePasses) {
+    std::cerr << "read: " << readTime << " ms\n";
+    if (undo != UndoMode::None) {
+      std::cerr << "backup: " << backupTime << " ms\n";
+    }
+    for (size_t i = 0; i < pipeline.size(); ++i) {
+      std::cerr << pipeline[i]->name << ": " << passTimes[i] << " ms (" << changes[i] << " changed)\n";
+    }
+    if (undo != UndoMode::None) {
+      std::cerr << "undo: " << restoreTime << " ms\n";
+    }
+    std::cerr << "write: " << writeTime << " ms" << std::endl;
+  }
+  return 0;
+}